@@ -0,0 +1,160 @@
+#ifndef CUDA_ADMISSIONCONTROLLER_HPP
+#define CUDA_ADMISSIONCONTROLLER_HPP
+
+#include <boost/utility.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <cudamm/completion.hpp>
+
+namespace cuda
+{
+	class DevicePtr;
+	class Memcpy2D;
+	class Stream;
+
+	/// Counters of an AdmissionController
+	struct AdmissionStats
+	{
+		/// Submissions issued at once, after blocking, rejected and deferred
+		unsigned long admitted, blocked, rejected, deferred;
+
+		/// Largest number of bytes held at a time
+		unsigned long peakBytes;
+
+		/// Time submitters spent blocked
+		double blockedMicroseconds;
+	};
+
+	/// Byte budget for asynchronous transfers and device allocations
+	/**
+		Transfers submitted through the controller hold their size
+		from submission until the CompletionEngine completes them, on
+		any stream. Device allocations made through the controller
+		hold their size until freed through it. A submission is
+		admitted while the held bytes stay at or below the high
+		watermark; once it would go above, nothing more is admitted
+		until the held bytes have dropped to the low watermark. A
+		submission larger than the high watermark alone is admitted
+		when nothing is held.
+
+		Past the watermark the policy decides what happens to a
+		submission:
+
+		- BLOCK waits until it fits, driving the engine if it is a
+		  foreground engine.
+		- REJECT throws an Exception.
+		- DEFER queues it and returns a handle at once. Deferred
+		  transfers are issued in order by issueDeferred() and by
+		  later submissions once the budget allows, always on the
+		  submitting thread, since the completion thread has no
+		  context. Allocations block under DEFER.
+
+		Host buffers of deferred transfers must stay valid until
+		their handle completes.
+
+		Noncopyable.
+	*/
+	class AdmissionController : boost::noncopyable
+	{
+		public:
+			/// What happens to submissions past the watermark
+			enum Policy {
+				BLOCK,
+				REJECT,
+				DEFER };
+
+			/// Create a controller
+			/**
+				@param highWatermark the largest number of bytes held
+				@param engine the engine tracking the transfers
+				@param policy what happens to submissions past the watermark
+			*/
+			AdmissionController(unsigned long highWatermark, CompletionEngine &engine, Policy policy = BLOCK);
+
+			/// Wait for the transfers in flight, fail the deferred ones
+			~AdmissionController();
+
+			/// Set the watermarks
+			/**
+				@param high the largest number of bytes held
+				@param low the held bytes at which admission resumes, at most high
+			*/
+			AdmissionController& setWatermarks(unsigned long high, unsigned long low);
+
+			/// Set the policy
+			/**
+				@param policy what happens to submissions past the watermark
+			*/
+			AdmissionController& setPolicy(Policy policy);
+
+			/// Copy from page locked host memory to device memory asynchronously
+			/**
+				@see memcpy(const DevicePtr&, const void*, unsigned int, const Stream&)
+				@return the handle of the copy
+			*/
+			Completion copy(const DevicePtr &dest, const void *src, unsigned int len, const Stream &stream);
+
+			/// Copy from device memory to page locked host memory asynchronously
+			/**
+				@see memcpy(void*, const DevicePtr&, unsigned int, const Stream&)
+				@return the handle of the copy
+			*/
+			Completion copy(void *dest, const DevicePtr &src, unsigned int len, const Stream &stream);
+
+			/// Execute a 2D copy asynchronously
+			/**
+				@see Memcpy2D::copy(const Stream&)
+				@return the handle of the copy
+			*/
+			Completion copy(const Memcpy2D &copy, const Stream &stream);
+
+			/// Allocate device memory against the budget
+			/**
+				@param size the number of bytes
+				@return the device memory
+			*/
+			DevicePtr malloc(unsigned int size);
+
+			/// Free device memory allocated through the controller
+			/**
+				@param ptr the device memory
+			*/
+			void free(const DevicePtr &ptr);
+
+			/// Issue deferred transfers that fit the budget
+			/**
+				@return the number of transfers issued
+			*/
+			unsigned int issueDeferred();
+
+			/// Get the bytes of the transfers in flight
+			/**
+				@return the bytes issued and not completed yet
+			*/
+			unsigned long inFlightBytes() const;
+
+			/// Get the bytes of the allocations held
+			/**
+				@return the bytes allocated and not freed yet
+			*/
+			unsigned long allocatedBytes() const;
+
+			/// Get the number of deferred transfers
+			/**
+				@return the transfers waiting for budget
+			*/
+			unsigned int deferred() const;
+
+			/// Get the counters
+			/**
+				@return the counters so far
+			*/
+			AdmissionStats stats() const;
+
+		private:
+			struct impl_t;
+			boost::scoped_ptr<impl_t> impl;
+	};
+}
+
+#endif
@@ -0,0 +1,171 @@
+#ifndef CUDA_AUTOTUNER_HPP
+#define CUDA_AUTOTUNER_HPP
+
+#include <string>
+#include <vector>
+
+#include <boost/utility.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/function.hpp>
+
+#include <cudamm/occupancy.hpp>
+
+namespace cuda
+{
+	class Function;
+	class Stream;
+
+	/// Persistent database of tuned launch configurations
+	/**
+		Entries are keyed by module, kernel name, device and problem
+		size bucket and stored in a plain text file, one entry per
+		line. The module is given by the hash of its image, so kernels
+		of the same name in different modules don't share entries and
+		a changed module is tuned again.
+
+		All member functions are thread-safe.
+
+		Noncopyable.
+	*/
+	class TuningDatabase : boost::noncopyable
+	{
+		public:
+			/// Open a tuning database
+			/**
+				Existing entries are read from the file if it exists.
+
+				@param filename the database file
+			*/
+			explicit TuningDatabase(const char *filename);
+
+			/// Destroy the database without saving it
+			~TuningDatabase();
+
+			/// Look up a tuned launch configuration
+			/**
+				@param module the module hash as given by Function::moduleHash
+				@param kernel the kernel name
+				@param device the device name as given by currentDevice
+				@param bucket the problem size bucket as given by bucket
+				@param config a reference where to store the configuration
+				@return true if found
+			*/
+			bool lookup(const std::string &module, const std::string &kernel, const std::string &device,
+				unsigned int bucket, LaunchConfig &config) const;
+
+			/// Store a tuned launch configuration
+			/**
+				Replaces an existing entry with the same key.
+
+				@param module the module hash as given by Function::moduleHash
+				@param kernel the kernel name
+				@param device the device name as given by currentDevice
+				@param bucket the problem size bucket as given by bucket
+				@param config the configuration
+				@param milliseconds the measured time of one launch
+			*/
+			void store(const std::string &module, const std::string &kernel, const std::string &device,
+				unsigned int bucket, const LaunchConfig &config, float milliseconds);
+
+			/// Write all entries to the database file
+			/**
+				Merges with the entries other processes have saved since
+				the file was read, entries of this database replace
+				theirs. The file is replaced in one step, so readers
+				never see it partially written.
+			*/
+			void save() const;
+
+			/// Get the problem size bucket of a problem
+			/**
+				Problems whose sizes have the same base 2 logarithm share
+				a bucket.
+
+				@param problemSize the number of threads of the problem
+				@return the bucket
+			*/
+			static unsigned int bucket(unsigned long problemSize);
+
+			/// Get the name of the device of the current context
+			/**
+				@return the device name and compute capability
+			*/
+			static std::string currentDevice();
+
+		private:
+			struct impl_t;
+			boost::scoped_ptr<impl_t> impl;
+	};
+
+	/// Empirical launch configuration tuner
+	/**
+		Times a kernel with every feasible launch configuration and
+		keeps the fastest one in a TuningDatabase, so later runs look
+		it up instead of tuning again.
+
+		Noncopyable.
+	*/
+	class Autotuner : boost::noncopyable
+	{
+		public:
+			/// Launch callback
+			/**
+				Called with the block shape and shared size already
+				applied to the function. It has to set the parameters
+				and launch the function on the given grid and stream.
+			*/
+			typedef boost::function<void (const LaunchConfig &config, const Stream &stream)> launcher_t;
+
+			/// Create a tuner
+			/**
+				@param database the database to look up and store results
+				@param iterations the number of timed launches per configuration
+			*/
+			explicit Autotuner(TuningDatabase &database, unsigned int iterations = 10);
+
+			/// Get the launch configuration of a kernel for a problem size
+			/**
+				Looks the configuration up in the database and tunes the
+				kernel if it isn't found. The chosen block shape and
+				shared size are applied to the function.
+
+				@param function the function to tune
+				@param width the problem width (in threads)
+				@param height the problem height (in threads)
+				@param stream the stream to run the benchmark launches on
+				@param launch the launch callback
+				@param sharedPerThread the dynamic shared memory needed by each thread (in bytes)
+				@param sharedPerBlock the dynamic shared memory needed by each block (in bytes)
+				@return the launch configuration
+			*/
+			LaunchConfig configure(const Function &function, unsigned int width, unsigned int height,
+				const Stream &stream, const launcher_t &launch,
+				unsigned int sharedPerThread = 0, unsigned int sharedPerBlock = 0);
+
+			/// Time candidate configurations and store the fastest one
+			/**
+				Candidates that fail to launch are skipped. The chosen
+				block shape and shared size are applied to the function.
+
+				An exception is thrown if no candidate launches, telling
+				why each of them failed.
+
+				@param function the function to tune
+				@param width the problem width (in threads)
+				@param height the problem height (in threads)
+				@param stream the stream to run the benchmark launches on
+				@param launch the launch callback
+				@param candidates the configurations to try
+				@return the fastest configuration
+			*/
+			LaunchConfig tune(const Function &function, unsigned int width, unsigned int height,
+				const Stream &stream, const launcher_t &launch,
+				const std::vector<LaunchConfig> &candidates);
+
+		private:
+			TuningDatabase &database;
+			unsigned int iterations;
+	};
+}
+
+#endif
@@ -0,0 +1,171 @@
+#ifndef CUDA_COMMANDBATCH_HPP
+#define CUDA_COMMANDBATCH_HPP
+
+#include <boost/utility.hpp>
+#include <boost/scoped_ptr.hpp>
+
+namespace cuda
+{
+	class DevicePtr;
+	class Event;
+	class LaunchRecord;
+	class Memcpy2D;
+	class Stream;
+
+	/// Recorded sequence of asynchronous operations
+	/**
+		A batch records copies, launches and event records once and
+		submits them to a stream as often as needed. Operations refer
+		to buffers symbolically: a buffer is declared with its kind
+		(device or page locked host memory) and size, and bound to
+		actual memory separately. Rebinding between submissions lets
+		double buffered pipelines alternate buffers without recording
+		the batch again.
+
+		Operations are checked against the declared buffers when they
+		are recorded; that all buffers are bound is checked by validate,
+		or by every submission until validate has passed. Submitting
+		does no more than one driver call (or one LaunchRecord replay)
+		per operation and does not change the batch, so several threads
+		may submit it at once, each to its own stream.
+
+		Noncopyable.
+	*/
+	class CommandBatch : boost::noncopyable
+	{
+		public:
+			/// Symbolic buffer of a batch
+			typedef unsigned int Buffer;
+
+			/// Placeholder for a side of a 2D copy that keeps the memory of the descriptor
+			static const Buffer fixed = ~0u;
+
+			/// Create an empty batch
+			CommandBatch();
+
+			/// Destructor
+			~CommandBatch();
+
+			/// Declare a device memory buffer
+			/**
+				@param bytes the size of the buffer
+				@return the buffer
+			*/
+			Buffer deviceBuffer(unsigned int bytes);
+
+			/// Declare a page locked host memory buffer
+			/**
+				@param bytes the size of the buffer
+				@return the buffer
+			*/
+			Buffer hostBuffer(unsigned int bytes);
+
+			/// Bind a device buffer to device memory
+			/**
+				The memory must hold at least the declared size of the buffer.
+
+				@param buffer the device buffer
+				@param ptr the device memory
+			*/
+			void bind(Buffer buffer, const DevicePtr &ptr);
+
+			/// Bind a host buffer to page locked host memory
+			/**
+				The memory must hold at least the declared size of the buffer.
+
+				@param buffer the host buffer
+				@param ptr the host memory
+			*/
+			void bind(Buffer buffer, void *ptr);
+
+			/// Record an asynchronous copy between buffers
+			/**
+				Copies from host to host memory are not supported.
+
+				@param dest the destination buffer
+				@param destOffset the byte offset in the destination buffer
+				@param src the source buffer
+				@param srcOffset the byte offset in the source buffer
+				@param len the number of bytes to copy
+			*/
+			CommandBatch& copy(Buffer dest, unsigned int destOffset, Buffer src, unsigned int srcOffset, unsigned int len);
+
+			/// Record an asynchronous copy between the beginnings of two buffers
+			/**
+				@param dest the destination buffer
+				@param src the source buffer
+				@param len the number of bytes to copy
+			*/
+			CommandBatch& copy(Buffer dest, Buffer src, unsigned int len);
+
+			/// Record an asynchronous 2D copy
+			/**
+				Positions, pitches and size are taken from the descriptor,
+				so set the pitch of a side given as a buffer on the
+				descriptor too. A side given as a buffer replaces the
+				memory of the descriptor on that side; a side given as
+				fixed keeps it (e.g. for arrays).
+
+				@param descriptor the copy descriptor
+				@param dest the destination buffer or fixed
+				@param src the source buffer or fixed
+			*/
+			CommandBatch& copy(const Memcpy2D &descriptor, Buffer dest, Buffer src);
+
+			/// Record a kernel launch
+			/**
+				The dynamic ranges of the record are filled by the
+				arguments added with argument(), or keep their recorded
+				values if there are none.
+
+				@param record the launch
+			*/
+			CommandBatch& launch(const LaunchRecord &record);
+
+			/// Pass a device buffer to the last recorded launch
+			/**
+				Arguments fill the dynamic ranges of the launch record in
+				order, 4 bytes each, in the format of
+				Function::setParameter(int, const DevicePtr&).
+
+				@param buffer the device buffer
+				@param offset the byte offset in the buffer
+			*/
+			CommandBatch& argument(Buffer buffer, unsigned int offset = 0);
+
+			/// Record an event
+			/**
+				The event must outlive the batch.
+
+				@param event the event to record
+			*/
+			CommandBatch& record(const Event &event);
+
+			/// Check that the batch can be submitted
+			/**
+				Throws if a buffer is not bound or a launch does not get
+				as many arguments as it has dynamic parameter bytes.
+				Until it passes after recording, submit does the same
+				checks on every call.
+			*/
+			void validate() const;
+
+			/// Submit all operations to a stream
+			/**
+				@param stream the stream to associate the operations with
+			*/
+			void submit(const Stream &stream) const;
+
+			/// Get the number of recorded operations
+			/**
+				@return the number of operations
+			*/
+			unsigned int size() const;
+
+		private:
+			struct impl_t;
+			boost::scoped_ptr<impl_t> impl;
+	};
+}
+
+#endif
@@ -0,0 +1,228 @@
+#ifndef CUDA_COMPLETION_HPP
+#define CUDA_COMPLETION_HPP
+
+#include <string>
+
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+#include <boost/scoped_ptr.hpp>
+
+namespace cuda
+{
+	class CompletionEngine;
+	class CompletionSource;
+	class DevicePtr;
+	class Event;
+	class Function;
+	class LaunchRecord;
+	class Memcpy2D;
+	class Stream;
+
+	/// Handle of an asynchronous operation
+	/**
+		Future-style: completed by a CompletionEngine when the operation
+		has finished on the device. Copies refer to the same operation.
+	*/
+	class Completion
+	{
+		public:
+			/// Create a handle that is already complete
+			Completion();
+
+			/// Query if the operation has completed
+			/**
+				@return true if complete
+			*/
+			bool ready() const;
+
+			/// Block until the operation has completed
+			/**
+				Without a background thread in the engine the caller
+				drives the engine while waiting. Throws if querying the
+				operation failed.
+			*/
+			void wait() const;
+
+			/// Block until the operation has completed or a timeout expired
+			/**
+				@param milliseconds the longest time to wait
+				@return true if complete
+			*/
+			bool wait(unsigned int milliseconds) const;
+
+			/// Call a function when the operation has completed
+			/**
+				Runs at once if the operation has already completed,
+				otherwise on the thread that completes it. The callback
+				must not block.
+
+				@param callback the function to call
+			*/
+			void then(const boost::function<void ()> &callback) const;
+
+		private:
+			struct impl_t;
+			boost::shared_ptr<impl_t> impl;
+
+			friend class CompletionEngine;
+			friend class CompletionSource;
+	};
+
+	/// Completes a Completion by hand
+	/**
+		For operations the CompletionEngine does not track itself, e.g.
+		work handed to another thread. Copies refer to the same
+		handle.
+	*/
+	class CompletionSource
+	{
+		public:
+			/// Create a source with a handle that is not complete yet
+			CompletionSource();
+
+			/// Get the handle
+			/**
+				@return the handle, completed by complete() or fail()
+			*/
+			const Completion& completion() const
+			{
+				return completion_;
+			}
+
+			/// Complete the handle
+			void complete() const;
+
+			/// Complete the handle with an error, rethrown by Completion::wait
+			/**
+				@param error the error message
+			*/
+			void fail(const std::string &error) const;
+
+		private:
+			Completion completion_;
+	};
+
+	/// Tracks recorded events and completes their operations
+	/**
+		Pending operations are polled with Event::query, either by a
+		background thread or by the caller through poll(). While
+		operations are pending and none completes, the thread backs
+		off: it polls again at once for a number of spins, then yields
+		for a number of rounds, then sleeps, doubling the sleep up to a
+		bound which is the worst-case completion latency. With nothing
+		pending the thread blocks without polling.
+
+		Each query makes the context the event was created in current
+		if it isn't already, so events of any context can be tracked
+		from threads without one.
+
+		The destructor waits for all pending operations.
+
+		Noncopyable.
+	*/
+	class CompletionEngine : boost::noncopyable
+	{
+		public:
+			/// Create an engine
+			/**
+				@param background true to poll on a background thread, false to poll in poll() and Completion::wait()
+			*/
+			explicit CompletionEngine(bool background = true);
+
+			/// Wait for all pending operations and destroy the engine
+			~CompletionEngine();
+
+			/// Set the back-off of the background thread
+			/**
+				@param spins the number of polls in a row before yielding
+				@param yields the number of yielding polls before sleeping
+				@param maxSleepMicroseconds the longest sleep between polls
+			*/
+			void setBackoff(unsigned int spins, unsigned int yields, unsigned int maxSleepMicroseconds);
+
+			/// Track a recorded event
+			/**
+				@param event the event, kept alive until it completed
+				@return the handle, completed when the event has been recorded
+			*/
+			Completion watch(const boost::shared_ptr<Event> &event);
+
+			/// Track all operations issued to a stream so far
+			/**
+				Records a pooled event on the stream, e.g. after
+				Function::go.
+
+				@param stream the stream
+				@return the handle, completed when the operations have completed
+			*/
+			Completion enqueue(const Stream &stream);
+
+			/// Copy from host memory to device memory asynchronously
+			/**
+				@see memcpy(const DevicePtr&, const void*, unsigned int, const Stream&)
+				@return the handle of the copy
+			*/
+			Completion copy(const DevicePtr &dest, const void *src, unsigned int len, const Stream &stream);
+
+			/// Copy from device memory to host memory asynchronously
+			/**
+				@see memcpy(void*, const DevicePtr&, unsigned int, const Stream&)
+				@return the handle of the copy
+			*/
+			Completion copy(void *dest, const DevicePtr &src, unsigned int len, const Stream &stream);
+
+			/// Execute a 2D copy asynchronously
+			/**
+				@see Memcpy2D::copy(const Stream&)
+				@return the handle of the copy
+			*/
+			Completion copy(const Memcpy2D &copy, const Stream &stream);
+
+			/// Launch a function asynchronously
+			/**
+				@see Function::launch(int, int, const Stream&)
+				@return the handle of the launch
+			*/
+			Completion launch(const Function &function, int gridWidth, int gridHeight, const Stream &stream);
+
+			/// Replay a launch record
+			/**
+				@see LaunchRecord::replay(const Stream&)
+				@return the handle of the launch
+			*/
+			Completion launch(const LaunchRecord &record, const Stream &stream);
+
+			/// Poll all pending operations once
+			/**
+				Completes finished operations and runs their callbacks.
+
+				@return the number of operations completed
+			*/
+			unsigned int poll();
+
+			/// Query if a background thread polls the engine
+			/**
+				@return true if the engine was created with background polling
+			*/
+			bool background() const;
+
+			/// Get the number of pending operations
+			/**
+				@return the number of operations not completed yet
+			*/
+			unsigned int pending() const;
+
+			/// Get the number of polls so far
+			/**
+				@return the number of polls
+			*/
+			unsigned long polls() const;
+
+		private:
+			struct impl_t;
+			boost::scoped_ptr<impl_t> impl;
+	};
+}
+
+#endif
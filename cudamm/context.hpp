@@ -0,0 +1,98 @@
+#ifndef CUDA_CONTEXT_HPP
+#define CUDA_CONTEXT_HPP
+
+#include <boost/utility.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace cuda
+{
+	struct DeviceInfo;
+
+	/// CUDA context of a device
+	/**
+		There is at most one context per device, shared by everyone
+		who asks for it; it is destroyed when the last shared
+		reference goes away. A context is not current on any thread
+		after creation, make it current with a ContextScope.
+
+		Streams, events, modules, functions, texture references, arrays
+		and device memory remember the context that was current when
+		they were created and refuse to be used while another context
+		is current.
+
+		Noncopyable.
+	*/
+	class Context : boost::noncopyable
+	{
+		public:
+			/// Shared context handle
+			typedef boost::shared_ptr<Context> context_ptr;
+
+			/// Get the context of a device, creating it if needed
+			/**
+				An existing context is only returned if it was created
+				with the same flags, otherwise an exception is thrown.
+				Flags 0 accept the existing context whatever its flags.
+
+				@param ordinal the device number
+				@param flags the CU_CTX_* creation flags, 0 for the defaults
+				@return the shared context
+			*/
+			static context_ptr device(int ordinal, unsigned int flags = 0);
+
+			/// Destroy the context
+			~Context();
+
+			/// Get the device number
+			/**
+				@return the device number
+			*/
+			int ordinal() const;
+
+			/// Get the properties of the device
+			/**
+				@return the cached device properties
+			*/
+			const DeviceInfo& info() const;
+
+			/// Query if the context is current on the calling thread
+			/**
+				@return true if current
+			*/
+			bool current() const;
+
+			/// Block until the device has completed all operations of the context
+			void synchronize() const;
+		private:
+			Context(int ordinal, unsigned int flags);
+
+			struct impl_t;
+			boost::scoped_ptr<impl_t> impl;
+
+			friend class ContextScope;
+	};
+
+	/// Make a context current for a scope
+	/**
+		Pushes the context on the calling thread's context stack and pops
+		it again on destruction, restoring whatever was current before.
+		Lets each worker thread drive its own device.
+
+		Noncopyable.
+	*/
+	class ContextScope : boost::noncopyable
+	{
+		public:
+			/// Make a context current
+			/**
+				@param context the context
+			*/
+			explicit ContextScope(const Context &context);
+
+			/// Restore the previous context
+			~ContextScope();
+	};
+}
+
+#endif
@@ -0,0 +1,315 @@
+#ifndef CUDA_COROUTINE_HPP
+#define CUDA_COROUTINE_HPP
+
+// C++20 coroutine support, only available to compilers implementing coroutines.
+// The rest of the library does not depend on it.
+#if defined(__cpp_impl_coroutine)
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <mutex>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+
+#include <cudamm/completion.hpp>
+
+namespace cuda
+{
+	class CoroutineScheduler;
+
+	/// Awaitable completion of an asynchronous operation
+	/**
+		Suspends the awaiting coroutine until the operation has completed,
+		then hands it to the scheduler to be resumed on one of its
+		threads. Rethrows if querying the operation failed.
+	*/
+	class CompletionAwaiter
+	{
+		public:
+			/// Create an awaiter
+			/**
+				@param completion the operation to wait for
+				@param scheduler the scheduler that resumes the coroutine
+			*/
+			CompletionAwaiter(const Completion &completion, CoroutineScheduler &scheduler)
+				: completion(completion)
+				, scheduler(&scheduler)
+			{
+			}
+
+			bool await_ready() const
+			{
+				return completion.ready();
+			}
+
+			void await_suspend(std::coroutine_handle<> coroutine) const;
+
+			void await_resume() const
+			{
+				completion.wait();
+			}
+
+		private:
+			Completion completion;
+			CoroutineScheduler *scheduler;
+	};
+
+	/// Resumes coroutines when their GPU work has finished
+	/**
+		Coroutines awaiting device work are parked without a thread.
+		When the CompletionEngine completes their operation, they are
+		queued here and resumed by whichever host threads call run() or
+		runOne(), so many concurrent flows can share a few threads and
+		none of them blocks in a stream synchronize.
+
+		A foreground engine only completes operations when polled, so
+		run() and runOne() poll it themselves: runOne() once per call,
+		run() whenever it wakes, which is every pollMicroseconds while
+		operations are pending and every idleMicroseconds otherwise.
+
+		Thread-safe. Noncopyable.
+	*/
+	class CoroutineScheduler : boost::noncopyable
+	{
+		public:
+			/// Create a scheduler
+			/**
+				@param engine the engine that tracks the awaited operations
+			*/
+			explicit CoroutineScheduler(CompletionEngine &engine)
+				: engine(engine)
+				, stopped(false)
+			{
+			}
+
+			/// Queue a coroutine to be resumed
+			/**
+				@param coroutine the coroutine
+			*/
+			void post(std::coroutine_handle<> coroutine)
+			{
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					ready.push_back(coroutine);
+				}
+				condition.notify_one();
+			}
+
+			/// Wake interval of run() with a foreground engine and pending operations
+			static constexpr int pollMicroseconds = 50;
+
+			/// Wake interval of run() with a foreground engine and nothing pending
+			static constexpr int idleMicroseconds = 1000;
+
+			/// Resume one queued coroutine if there is one
+			/**
+				Polls a foreground engine first.
+
+				@return true if a coroutine was resumed
+			*/
+			bool runOne()
+			{
+				if(!engine.background()) engine.poll();
+
+				std::coroutine_handle<> coroutine;
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					if(ready.empty()) return false;
+					coroutine = ready.front();
+					ready.pop_front();
+				}
+				coroutine.resume();
+				return true;
+			}
+
+			/// Resume queued coroutines until stop() is called
+			void run()
+			{
+				const bool foreground = !engine.background();
+				const auto wake = [this] { return stopped || !ready.empty(); };
+
+				for(;;)
+				{
+					if(foreground) engine.poll();
+
+					std::coroutine_handle<> coroutine;
+					{
+						std::unique_lock<std::mutex> lock(mutex);
+						if(!foreground)
+						{
+							condition.wait(lock, wake);
+						} else
+						{
+							const int interval = engine.pending() ? pollMicroseconds : idleMicroseconds;
+							condition.wait_for(lock, std::chrono::microseconds(interval), wake);
+						}
+
+						if(ready.empty())
+						{
+							if(stopped) return;
+							continue;
+						}
+						coroutine = ready.front();
+						ready.pop_front();
+					}
+					coroutine.resume();
+				}
+			}
+
+			/// Make run() return once the queue is empty
+			void stop()
+			{
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					stopped = true;
+				}
+				condition.notify_all();
+			}
+
+			/// Get the number of coroutines waiting to be resumed
+			/**
+				@return the number of queued coroutines
+			*/
+			std::size_t queued() const
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				return ready.size();
+			}
+
+			/// Await an operation
+			/**
+				@param completion the operation
+				@return the awaiter
+			*/
+			CompletionAwaiter operator()(const Completion &completion)
+			{
+				return CompletionAwaiter(completion, *this);
+			}
+
+			/// Await all operations issued to a stream so far
+			/**
+				@param stream the stream
+				@return the awaiter
+			*/
+			CompletionAwaiter completed(const Stream &stream)
+			{
+				return CompletionAwaiter(engine.enqueue(stream), *this);
+			}
+
+			/// Await a recorded event
+			/**
+				@param event the event
+				@return the awaiter
+			*/
+			CompletionAwaiter recorded(const boost::shared_ptr<Event> &event)
+			{
+				return CompletionAwaiter(engine.watch(event), *this);
+			}
+
+			/// Copy from host memory to device memory and await the copy
+			/**
+				@see CompletionEngine::copy
+				@return the awaiter
+			*/
+			CompletionAwaiter copy(const DevicePtr &dest, const void *src, unsigned int len, const Stream &stream)
+			{
+				return CompletionAwaiter(engine.copy(dest, src, len, stream), *this);
+			}
+
+			/// Copy from device memory to host memory and await the copy
+			/**
+				@see CompletionEngine::copy
+				@return the awaiter
+			*/
+			CompletionAwaiter copy(void *dest, const DevicePtr &src, unsigned int len, const Stream &stream)
+			{
+				return CompletionAwaiter(engine.copy(dest, src, len, stream), *this);
+			}
+
+			/// Execute a 2D copy and await it
+			/**
+				@see CompletionEngine::copy
+				@return the awaiter
+			*/
+			CompletionAwaiter copy(const Memcpy2D &copy, const Stream &stream)
+			{
+				return CompletionAwaiter(engine.copy(copy, stream), *this);
+			}
+
+			/// Replay a launch record and await the launch
+			/**
+				@see CompletionEngine::launch
+				@return the awaiter
+			*/
+			CompletionAwaiter launch(const LaunchRecord &record, const Stream &stream)
+			{
+				return CompletionAwaiter(engine.launch(record, stream), *this);
+			}
+
+		private:
+			CompletionEngine &engine;
+
+			mutable std::mutex mutex;
+			std::condition_variable condition;
+			std::deque<std::coroutine_handle<> > ready;
+			bool stopped;
+	};
+
+	inline void CompletionAwaiter::await_suspend(std::coroutine_handle<> coroutine) const
+	{
+		CoroutineScheduler *target = scheduler;
+		completion.then([target, coroutine] { target->post(coroutine); });
+	}
+
+	/// Return type of fire-and-forget coroutines
+	/**
+		The coroutine starts at once on the calling thread and frees
+		itself when it returns. Uncaught exceptions are reported on
+		std::cerr.
+	*/
+	struct CoroutineTask
+	{
+		struct promise_type
+		{
+			CoroutineTask get_return_object()
+			{
+				return CoroutineTask();
+			}
+
+			std::suspend_never initial_suspend() const noexcept
+			{
+				return std::suspend_never();
+			}
+
+			std::suspend_never final_suspend() const noexcept
+			{
+				return std::suspend_never();
+			}
+
+			void return_void()
+			{
+			}
+
+			void unhandled_exception()
+			{
+				try
+				{
+					throw;
+				} catch(std::exception const &e)
+				{
+					std::cerr << "Coroutine failed: " << e.what() << std::endl;
+				}
+			}
+		};
+	};
+}
+
+#endif
+
+#endif
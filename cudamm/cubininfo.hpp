@@ -0,0 +1,149 @@
+#ifndef CUDA_CUBININFO_HPP
+#define CUDA_CUBININFO_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace cuda
+{
+	/// Kernel parameter as recorded in a cubin
+	struct CubinParameter
+	{
+		/// Create a parameter description
+		/**
+			@param ordinal the position of the parameter in the argument list
+			@param offset byte offset in parameter space of the kernel
+			@param size size of the parameter in bytes
+		*/
+		CubinParameter(unsigned int ordinal = 0, unsigned int offset = 0, unsigned int size = 0)
+			: ordinal(ordinal), offset(offset), size(size)
+		{
+		}
+		
+		unsigned int ordinal, offset, size;
+	};
+	
+	/// Constant memory symbol as recorded in a cubin
+	struct CubinSymbol
+	{
+		std::string name;
+		
+		/// Constant bank (segment number) of the symbol
+		unsigned int bank;
+		
+		unsigned int offset, size;
+	};
+	
+	/// Kernel resource usage as recorded in a cubin
+	struct CubinKernel
+	{
+		CubinKernel()
+			: registers(0), sharedBytes(0), localBytes(0), constBytes(0), barriers(0), parameterBytes(0)
+		{
+		}
+		
+		std::string name;
+		
+		/// Registers per thread
+		unsigned int registers;
+		
+		/// Static shared memory per block (in bytes)
+		unsigned int sharedBytes;
+		
+		/// Local memory per thread (in bytes)
+		unsigned int localBytes;
+		
+		/// Kernel specific constant memory (in bytes)
+		unsigned int constBytes;
+		
+		/// Number of barriers
+		unsigned int barriers;
+		
+		/// Total size of the parameters (in bytes), 0 if not recorded
+		unsigned int parameterBytes;
+		
+		/// Parameter layout ordered by ordinal, empty if not recorded
+		std::vector<CubinParameter> parameters;
+		
+		/// Check a parameter layout against the one recorded in the cubin
+		/**
+			Does nothing if the cubin does not record the parameter
+			layout, which is the case for old text cubins.
+			
+			An exception describing the first mismatch is thrown if
+			the layouts differ.
+			
+			@param expected the layout the caller is going to use
+		*/
+		void checkParameters(const std::vector<CubinParameter> &expected) const;
+	};
+	
+	/// Host-only reader of cubin metadata
+	/**
+		Reads kernel names, resource usage, parameter layouts, texture
+		references and constant symbols from a cubin without loading
+		it, so no CUDA driver or device is needed.
+		
+		Both the old text format and ELF cubins are understood.
+	*/
+	class CubinInfo
+	{
+		public:
+			/// Read a cubin file
+			/**
+				@param filename the cubin file
+			*/
+			explicit CubinInfo(const char *filename);
+			
+			/// Read a cubin image from memory
+			/**
+				@param image the cubin image
+				@param size the size of the image in bytes
+			*/
+			CubinInfo(const void *image, size_t size);
+			
+			/// Get the target architecture
+			/**
+				@return the architecture, e.g. "sm_10"
+			*/
+			const std::string& architecture() const { return architecture_; }
+			
+			/// Get all kernels
+			const std::vector<CubinKernel>& kernels() const { return kernels_; }
+			
+			/// Get a kernel by name
+			/**
+				An exception is thrown if there is no such kernel.
+				
+				@param name the name of the kernel
+				@return the kernel
+			*/
+			const CubinKernel& kernel(const char *name) const;
+			
+			/// Query if the cubin contains a kernel
+			/**
+				@param name the name of the kernel
+				@return true if found
+			*/
+			bool hasKernel(const char *name) const;
+			
+			/// Get the names of all texture references
+			const std::vector<std::string>& textures() const { return textures_; }
+			
+			/// Get all constant memory symbols
+			const std::vector<CubinSymbol>& constants() const { return constants_; }
+			
+		private:
+			void parse(const char *image, size_t size);
+			void parseText(const char *image, size_t size);
+			void parseElf(const char *image, size_t size);
+		
+			std::string architecture_;
+			std::vector<CubinKernel> kernels_;
+			std::vector<std::string> textures_;
+			std::vector<CubinSymbol> constants_;
+	};
+}
+
+#endif
@@ -4,23 +4,54 @@
 #include <boost/utility.hpp>
 #include <boost/scoped_ptr.hpp>
 
+#include <cudamm/admissioncontroller.hpp>
 #include <cudamm/array.hpp>
+#include <cudamm/autotuner.hpp>
+#include <cudamm/commandbatch.hpp>
+#include <cudamm/completion.hpp>
+#include <cudamm/context.hpp>
+#include <cudamm/coroutine.hpp>
+#include <cudamm/cubininfo.hpp>
+#include <cudamm/device.hpp>
 #include <cudamm/devicememory.hpp>
 #include <cudamm/devicememory2d.hpp>
+#include <cudamm/dispatcher.hpp>
 #include <cudamm/deviceptr.hpp>
 #include <cudamm/event.hpp>
+#include <cudamm/eventpool.hpp>
 #include <cudamm/exception.hpp>
+#include <cudamm/fairscheduler.hpp>
 #include <cudamm/function.hpp>
+#include <cudamm/global.hpp>
+#include <cudamm/gridlauncher.hpp>
+#include <cudamm/haloexchange.hpp>
+#include <cudamm/hostmemory.hpp>
+#include <cudamm/launchrecord.hpp>
 #include <cudamm/memcpy2d.hpp>
 #include <cudamm/module.hpp>
+#include <cudamm/moduleregistry.hpp>
+#include <cudamm/mpscqueue.hpp>
+#include <cudamm/notifier.hpp>
+#include <cudamm/occupancy.hpp>
+#include <cudamm/partitioner.hpp>
+#include <cudamm/residencycache.hpp>
 #include <cudamm/stream.hpp>
+#include <cudamm/streampool.hpp>
+#include <cudamm/taskexecutor.hpp>
+#include <cudamm/taskgraph.hpp>
 #include <cudamm/texturereference.hpp>
+#include <cudamm/transferscheduler.hpp>
+#include <cudamm/waitpolicy.hpp>
 
 /// CUDAmm namespace
 namespace cuda
 {
 	/// Quick and dirty RAII CUDA setup and cleanup
 	/**
+		Makes the context of a device current on the calling thread for
+		the lifetime of the object. See Context and ContextScope for
+		driving several devices.
+
 		Noncopyable.
 	*/
 	class Cuda : boost::noncopyable
@@ -31,8 +62,20 @@ namespace cuda
 				@param numDevice the number of the CUDA device to use
 			*/
 			explicit Cuda(int numDevice = 0, bool gl = false);
+
+			/// Initialize CUDA and create context for a device with a wait policy
+			/**
+				If the device has no context yet it is created with the
+				scheduling flags of the policy. An existing context created
+				with other flags is rejected with an exception. The policy
+				becomes the default policy of the context.
+
+				@param numDevice the number of the CUDA device to use
+				@param policy how host threads wait for the device
+			*/
+			Cuda(int numDevice, bool gl, const WaitPolicy &policy);
 			
-			/// Detach CUDA context
+			/// Restore the previous context, destroy the device's context if unused
 			~Cuda();
 		private:
 			struct impl_t;
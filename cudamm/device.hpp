@@ -0,0 +1,67 @@
+#ifndef CUDA_DEVICE_HPP
+#define CUDA_DEVICE_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace cuda
+{
+	/// Properties of a CUDA device
+	/**
+		Queried once per process, see devices().
+	*/
+	struct DeviceInfo
+	{
+		/// Device number
+		int ordinal;
+
+		/// Device name
+		std::string name;
+
+		/// Compute capability
+		int major, minor;
+
+		/// Total device memory in bytes
+		std::size_t totalMemory;
+
+		int multiprocessors;
+		int maxThreadsPerBlock;
+		int maxThreadsPerMultiprocessor;
+		int maxSharedMemoryPerBlock;
+		int warpSize;
+
+		/// Clock rate in kHz
+		int clockRate;
+
+		/// Number of copy engines, copies overlap kernels if > 0
+		int asyncEngines;
+	};
+
+	/// Get the properties of all CUDA devices
+	/**
+		Initializes CUDA and queries the devices on first call, later
+		calls return the cached result. Thread-safe.
+
+		@return the devices, indexed by ordinal
+	*/
+	const std::vector<DeviceInfo>& devices();
+
+	/// Get the number of CUDA devices
+	/**
+		@return the number of devices
+	*/
+	inline unsigned int deviceCount()
+	{
+		return devices().size();
+	}
+
+	/// Get the properties of a CUDA device
+	/**
+		@param ordinal the device number
+		@return the properties
+	*/
+	const DeviceInfo& device(int ordinal);
+}
+
+#endif
@@ -66,6 +66,9 @@ namespace cuda
 			friend void memset16(const DevicePtr &ptr, unsigned short value, unsigned int count);
 			friend void memset32(const DevicePtr &ptr, unsigned int value, unsigned int count);
 
+			friend void memset8(const DevicePtr &ptr, unsigned char value, unsigned int count, const Stream &stream);
+			friend void memset32(const DevicePtr &ptr, unsigned int value, unsigned int count, const Stream &stream);
+
 			friend void memcpy(const DevicePtr &dest, const void *src, unsigned int len);
 			friend void memcpy(void *dest, const DevicePtr& src, unsigned int len);
 			friend void memcpy(const DevicePtr& dest, const DevicePtr& src, unsigned int len);
@@ -86,7 +89,9 @@ namespace cuda
 
 			friend void free(const DevicePtr &ptr);
 
+			friend class CommandBatch;
 			friend class Function;
+			friend class Module;
 			friend class TextureReference;
 			friend class Memcpy2D;
 	};
@@ -161,6 +166,24 @@ namespace cuda
 	*/
 	void memset32(const DevicePtr &ptr, unsigned int value, unsigned int count);
 
+	/// Set a device memory range to a value asynchronously
+	/**
+		@param ptr the device pointer
+		@param value the value to write
+		@param count the number of values to write
+		@param stream the stream to associate the operation with
+	*/
+	void memset8(const DevicePtr &ptr, unsigned char value, unsigned int count, const Stream &stream);
+
+	/// Set a device memory range to a value asynchronously
+	/**
+		@param ptr the device pointer
+		@param value the value to write
+		@param count the number of values to write
+		@param stream the stream to associate the operation with
+	*/
+	void memset32(const DevicePtr &ptr, unsigned int value, unsigned int count, const Stream &stream);
+
 	/// Copy from host memory to device memory
 	/**
 		@param dest the destination memory pointer
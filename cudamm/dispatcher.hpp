@@ -0,0 +1,154 @@
+#ifndef CUDA_DISPATCHER_HPP
+#define CUDA_DISPATCHER_HPP
+
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <cudamm/completion.hpp>
+#include <cudamm/context.hpp>
+
+namespace cuda
+{
+	class CompletionEngine;
+	class DevicePtr;
+	class Event;
+	class Function;
+	class LaunchRecord;
+	class Memcpy2D;
+	class Stream;
+
+	/// Thread that owns a context and issues work submitted from any thread
+	/**
+		Producers submit operations to a lock-free queue and get a
+		Completion back at once, without touching the context. The
+		dispatcher thread keeps the context current, drains the queue
+		in submission order and completes each handle when the work
+		the operation issued has finished on the device.
+
+		The copies, launches and event records issue their work on a
+		stream of the dispatcher, created on first use, and track it
+		with a foreground CompletionEngine that the dispatcher thread
+		polls, so only that thread ever uses the context. Generic
+		operations run on the dispatcher thread and return the handle
+		of what they issued.
+
+		Without a context the dispatcher runs generic operations
+		without making a context current, e.g. to test or benchmark
+		it against a fake driver.
+
+		The destructor runs all submitted operations first. Objects
+		passed by reference must stay alive until their operation has
+		run.
+
+		Noncopyable.
+	*/
+	class Dispatcher : boost::noncopyable
+	{
+		public:
+			/// Operation run on the dispatcher thread
+			/**
+				Issues work and returns the handle of it; an exception
+				fails the handle of the submission.
+			*/
+			typedef boost::function<Completion ()> Operation;
+
+			/// Start a dispatcher
+			/**
+				@param context the context to own, 0 for none
+			*/
+			explicit Dispatcher(const Context::context_ptr &context);
+
+			/// Run the submitted operations and stop
+			~Dispatcher();
+
+			/// Submit an operation
+			/**
+				Lock-free, callable from any thread.
+
+				@param operation the operation
+				@return the handle, completed when the operation's handle completes
+			*/
+			Completion submit(const Operation &operation);
+
+			/// Copy from page locked host memory to device memory
+			/**
+				@param dest the destination memory pointer
+				@param src the source memory pointer
+				@param len the number of bytes to copy
+				@return the handle of the copy
+			*/
+			Completion copy(const DevicePtr &dest, const void *src, unsigned int len);
+
+			/// Copy from device memory to page locked host memory
+			/**
+				@param dest the destination memory pointer
+				@param src the source memory pointer
+				@param len the number of bytes to copy
+				@return the handle of the copy
+			*/
+			Completion copy(void *dest, const DevicePtr &src, unsigned int len);
+
+			/// Execute a 2D copy
+			/**
+				@param copy the copy
+				@return the handle of the copy
+			*/
+			Completion copy(const Memcpy2D &copy);
+
+			/// Launch a function
+			/**
+				@param function the function, with parameters set at the time the launch runs
+				@param gridWidth grid width
+				@param gridHeight grid height
+				@return the handle of the launch
+			*/
+			Completion launch(const Function &function, int gridWidth, int gridHeight);
+
+			/// Replay a launch record
+			/**
+				@param record the record, copied
+				@return the handle of the launch
+			*/
+			Completion launch(const LaunchRecord &record);
+
+			/// Record an event after all work submitted so far
+			/**
+				@param event the event, kept alive until it completed
+				@return the handle, completed when the event has been recorded
+			*/
+			Completion record(const boost::shared_ptr<Event> &event);
+
+			/// Get the owned context
+			/**
+				@return the context, 0 if there is none
+			*/
+			const Context::context_ptr& context() const;
+
+			/// Get the number of submitted operations
+			/**
+				@return the number of submissions so far
+			*/
+			unsigned long submitted() const;
+
+			/// Get the number of operations run
+			/**
+				@return the number of operations the dispatcher thread has run
+			*/
+			unsigned long executed() const;
+
+		private:
+			/// Operation issuing work to the dispatcher's stream
+			typedef boost::function<Completion (const Stream &, CompletionEngine &)> StreamOperation;
+
+			Completion submitToStream(const StreamOperation &operation);
+
+			struct impl_t;
+			boost::scoped_ptr<impl_t> impl;
+
+			static Completion runOnStream(impl_t *impl, const StreamOperation &operation);
+	};
+}
+
+#endif
@@ -7,6 +7,7 @@
 namespace cuda
 {
 	class Stream;
+	struct WaitPolicy;
 
 	/// CUDA events
 	/**
@@ -18,8 +19,24 @@ namespace cuda
 	class Event : boost::noncopyable
 	{
 		public:
+			/// Event creation flags, may be combined
+			enum Flags {
+				DEFAULT = 0x00,
+				BLOCKING_SYNC = 0x01,
+				DISABLE_TIMING = 0x02 };
+
 			/// Create event
 			Event();
+
+			/// Create event with flags
+			/**
+				Events with DISABLE_TIMING are cheaper to record and wait
+				for but can't be used with operator-. With BLOCKING_SYNC
+				synchronize() sleeps instead of spinning.
+
+				@param flags the creation flags
+			*/
+			explicit Event(unsigned int flags);
 			
 			/// Destroy event
 			~Event();
@@ -41,9 +58,20 @@ namespace cuda
 			/// Block until the event has actually been recorded
 			/**
 				An exception will be thrown if record is not called on
-				this event.
+				this event. Waits by the default policy of the current
+				context if one was set, see WaitPolicy::setContextDefault.
 			*/
 			void synchronize() const;
+
+			/// Wait by a policy until the event has actually been recorded
+			/**
+				BLOCKING and HYBRID only sleep in the driver if the event
+				was created with BLOCKING_SYNC or the context with
+				CU_CTX_SCHED_BLOCKING_SYNC.
+
+				@param policy how to wait
+			*/
+			void synchronize(const WaitPolicy &policy) const;
 			
 			/// Query if the event has actually been recorded
 			/**
@@ -57,6 +85,10 @@ namespace cuda
 			struct impl_t;
 			boost::scoped_ptr<impl_t> impl;
 
+			friend class CommandBatch;
+			friend class CompletionEngine;
+			friend class Stream;
+
 			friend float operator-(const Event &end, const Event &start);
 	};
 	
@@ -0,0 +1,79 @@
+#ifndef CUDA_EVENTPOOL_HPP
+#define CUDA_EVENTPOOL_HPP
+
+#include <boost/utility.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <cudamm/event.hpp>
+
+namespace cuda
+{
+	/// Recycles Cuda events
+	/**
+		Hands out events of one kind of creation flags and takes them
+		back when the last reference to them is dropped, so fine grained
+		dependencies don't create and destroy an event each. Events
+		default to DISABLE_TIMING, the cheapest kind for ordering
+		streams.
+
+		Dropping an event a stream still has a wait enqueued for is
+		fine: a wait refers to the record preceding it, not to later
+		ones. Events may outlive the pool. Thread-safe.
+
+		Noncopyable.
+	*/
+	class EventPool : boost::noncopyable
+	{
+		public:
+			/// Create an empty pool
+			/**
+				@param flags the creation flags of the events (see Event::Flags)
+			*/
+			explicit EventPool(unsigned int flags = Event::DISABLE_TIMING);
+
+			/// Destructor
+			/**
+				Destroys the idle events, events in use are destroyed when
+				released.
+			*/
+			~EventPool();
+
+			/// Get an event
+			/**
+				Reuses an idle event or creates a new one.
+
+				@return the event, returned to the pool when the last copy is destroyed
+			*/
+			boost::shared_ptr<Event> acquire();
+
+			/// Create idle events in advance
+			/**
+				@param count the number of idle events to have at least
+			*/
+			void reserve(unsigned int count);
+
+			/// Get the number of idle events
+			/**
+				@return the number of events ready to be acquired without creating one
+			*/
+			unsigned int available() const;
+
+			/// Get the number of events created by the pool
+			/**
+				@return the number of events created
+			*/
+			unsigned int created() const;
+
+			/// Get the creation flags of the events
+			/**
+				@return the flags
+			*/
+			unsigned int flags() const;
+
+		private:
+			struct impl_t;
+			boost::shared_ptr<impl_t> impl;
+	};
+}
+
+#endif
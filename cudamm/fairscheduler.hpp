@@ -0,0 +1,177 @@
+#ifndef CUDA_FAIRSCHEDULER_HPP
+#define CUDA_FAIRSCHEDULER_HPP
+
+#include <string>
+
+#include <boost/utility.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <cudamm/completion.hpp>
+#include <cudamm/gridlauncher.hpp>
+#include <cudamm/occupancy.hpp>
+
+namespace cuda
+{
+	class Function;
+	class Stream;
+
+	/// Queueing statistics of a tenant
+	struct TenantStats
+	{
+		/// Jobs submitted, jobs whose last slice has been issued
+		unsigned long submitted, issued;
+
+		/// Jobs waiting for their first slice
+		unsigned int queued;
+
+		/// Slices and blocks issued
+		unsigned long slices, blocks;
+
+		/// Time from submission until the first slice was issued, summed and largest
+		double totalDelayMicroseconds, maxDelayMicroseconds;
+
+		/// Get the mean queueing delay
+		/**
+			@return the mean delay of the jobs started so far (in microseconds)
+		*/
+		double meanDelayMicroseconds() const
+		{
+			const unsigned long started = submitted - queued;
+			return started ? totalDelayMicroseconds / started : 0.0;
+		}
+	};
+
+	/// Weighted fair sharing of one device between tenants
+	/**
+		Every tenant has a queue of kernel jobs, a weight and a
+		priority. Jobs are split with splitGrid into slices of at most
+		sliceBlocks blocks, and slices are issued to the stream one at
+		a time by start-time fair queuing: among the tenants of the
+		highest priority with queued work, the one whose next slice has
+		the smallest virtual start time goes next. A tenant's virtual
+		time advances by the blocks of a slice divided by its weight,
+		so backlogged tenants of equal priority get blocks in proportion
+		to their weights, and a tenant that was idle starts at the
+		current virtual time instead of catching up. Higher priorities
+		are served strictly first.
+
+		At most maxInFlight slices are on the stream at a time, so work
+		submitted later overtakes a long batch after a few slices.
+		Smaller slices lower the latency for other tenants at the cost
+		of more launches.
+
+		Kernels find their block in the whole grid through three int
+		offset parameters, as with GridLauncher. A job records the
+		launch configuration of its function at submission, so the
+		function can be configured for the next job right away.
+
+		submit may be called from any thread with the function's
+		context current; schedule and drain from one thread with the
+		stream's context current. With a foreground CompletionEngine,
+		issued slices retire when the engine is polled.
+
+		Noncopyable.
+	*/
+	class FairScheduler : boost::noncopyable
+	{
+		public:
+			/// Identifies a tenant
+			typedef unsigned int Tenant;
+
+			/// Create a scheduler
+			/**
+				@param stream the stream to issue slices to
+				@param engine the engine tracking the slices
+				@param limits the limits of the device
+			*/
+			FairScheduler(const Stream &stream, CompletionEngine &engine, const DeviceLimits &limits);
+
+			/// Destroy the scheduler, failing the jobs not issued yet
+			~FairScheduler();
+
+			/// Limit the blocks of a slice
+			/**
+				@param blocks the largest number of blocks of one launch, 0 for whole grids
+			*/
+			FairScheduler& setSliceBlocks(unsigned int blocks);
+
+			/// Limit the slices on the stream
+			/**
+				@param slices the largest number of slices issued and not completed, at least 1
+			*/
+			FairScheduler& setMaxInFlight(unsigned int slices);
+
+			/// Add a tenant
+			/**
+				@param name the name of the tenant
+				@param weight the share of the tenant relative to others of the same priority
+				@param priority higher priorities are served first
+				@return the tenant
+			*/
+			Tenant addTenant(const std::string &name, double weight = 1.0, int priority = 0);
+
+			/// Change the weight of a tenant
+			/**
+				@param tenant the tenant
+				@param weight the new weight, greater than 0
+			*/
+			void setWeight(Tenant tenant, double weight);
+
+			/// Change the priority of a tenant
+			/**
+				@param tenant the tenant
+				@param priority the new priority
+			*/
+			void setPriority(Tenant tenant, int priority);
+
+			/// Queue a kernel job
+			/**
+				Sets the block shape of the function and records its
+				current configuration.
+
+				@param tenant the tenant
+				@param function the configured function
+				@param offsetParameter byte offset of the grid offset parameters
+				@param problem the problem size (in threads)
+				@param block the block shape
+				@return the handle, completed when the last slice has completed
+			*/
+			Completion submit(Tenant tenant, const Function &function, int offsetParameter,
+				const Extent &problem, const Extent &block);
+
+			/// Issue slices while the stream has room
+			/**
+				@return the number of slices issued
+			*/
+			unsigned int schedule();
+
+			/// Issue all queued slices and wait for them
+			void drain();
+
+			/// Get the number of slices not issued yet
+			/**
+				@return the queued slices of all tenants
+			*/
+			unsigned long queued() const;
+
+			/// Get the name of a tenant
+			/**
+				@param tenant the tenant
+				@return the name
+			*/
+			std::string name(Tenant tenant) const;
+
+			/// Get the statistics of a tenant
+			/**
+				@param tenant the tenant
+				@return the statistics so far
+			*/
+			TenantStats stats(Tenant tenant) const;
+
+		private:
+			struct impl_t;
+			boost::scoped_ptr<impl_t> impl;
+	};
+}
+
+#endif
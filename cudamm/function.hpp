@@ -8,7 +8,11 @@
 #include <boost/mpl/transform.hpp>
 #include <boost/mpl/placeholders.hpp>
 #include <iostream>
+#include <string>
 #include <typeinfo>
+#include <vector>
+
+#include <cudamm/cubininfo.hpp>
 
 using namespace boost;
 
@@ -36,9 +40,33 @@ namespace cuda
 				@note nvcc may use name mangling extern "C" { } is used in CUDA source.
 			*/
 			Function(Module &module, const char *name);
+
+			/// Get a function from a CUDA Module and remember its cubin metadata
+			/**
+				The metadata lets checkParameters validate the argument
+				types of go() calls once after loading instead of at
+				every launch.
+
+				@param module the module to load from
+				@param name the name of the function
+				@param info the metadata of the cubin the module was loaded from
+			*/
+			Function(Module &module, const char *name, const CubinInfo &info);
 			
 			/// Destroy function
 			~Function();
+
+			/// Get the name of the function
+			/**
+				@return the name the function was looked up with
+			*/
+			const char *name() const;
+
+			/// Get the hash of the image of the module of the function
+			/**
+				@return the hash, see Module::hash
+			*/
+			const std::string& moduleHash() const;
 			
 			/// Specify the dimensions of the thread blocks
 			/**
@@ -119,6 +147,81 @@ namespace cuda
 			*/
 			void useTexture(const TextureReference &texref) const;
 
+			/// Get the number of registers used by each thread
+			/**
+				@return the number of registers per thread
+			*/
+			unsigned int registers() const;
+
+			/// Get the statically allocated shared memory of a thread block
+			/**
+				@return the static shared memory size in bytes
+			*/
+			unsigned int staticSharedSize() const;
+
+			/// Get the local memory used by each thread
+			/**
+				@return the local memory size in bytes
+			*/
+			unsigned int localSize() const;
+
+			/// Get the largest block size the function can be launched with
+			/**
+				Depends on the function and the device it is loaded on.
+
+				@return the maximum number of threads per block
+			*/
+			unsigned int maxThreadsPerBlock() const;
+
+			/// Check a parameter layout against the cubin metadata
+			/**
+				An exception is thrown if the layouts differ, see
+				CubinKernel::checkParameters, or if the function was
+				loaded without metadata.
+
+				@param layout the layout the caller is going to use
+			*/
+			void checkParameters(const std::vector<CubinParameter> &layout) const;
+
+			/// Check the layout go() pushes for argument types against the cubin metadata
+			/**
+				E.g. checkParameters<Function::Parameters<DevicePtr, int> >()
+				for go(width, height, stream, ptr, n).
+			*/
+			template <class P>
+			void checkParameters() const
+			{
+				checkParameters(P::layout());
+			}
+
+			/// Exclusive access to the launch state of a function
+			/**
+				Block shape, shared size, parameters and textures belong
+				to the driver function, which is shared by all Function
+				objects of a kernel in a module. Holding a lock makes a
+				configure-then-launch sequence atomic against other
+				threads using the same kernel; launches of other kernels
+				are not blocked. Locks are recursive, and every setter,
+				launch and go() takes one internally.
+
+				Noncopyable.
+			*/
+			class ScopedLock : boost::noncopyable
+			{
+				public:
+					/// Lock the launch state of a function
+					/**
+						@param function the function to lock
+					*/
+					explicit ScopedLock(const Function &function);
+
+					/// Unlock
+					~ScopedLock();
+
+				private:
+					const Function &function;
+			};
+
       // MPL magic for kernel invocation syntactic sugar
 
       struct not_specified {};
@@ -148,6 +251,67 @@ namespace cuda
         int offset;
       };
 
+      // Bytes set_parameters writes for an argument, a DevicePtr is passed as int
+      template <class T>
+      struct parameter_bytes
+      {
+        enum { value = sizeof( T ) };
+      };
+
+      // Records the layout set_parameters pushes, with the same offset steps
+      struct layout_parameters
+      {
+        layout_parameters()
+        {
+          offset = 0;
+        }
+        template <class T>
+        inline void add()
+        {
+          parameters.push_back( CubinParameter( parameters.size(), offset, parameter_bytes<T>::value ) );
+          ALIGN_UP( offset, __alignof(T) );
+          offset += sizeof( T );
+        }
+
+        std::vector<CubinParameter> parameters;
+        unsigned int offset;
+      };
+
+			/// Argument types of a go() call
+			/**
+				layout() gives the parameter layout go() pushes for
+				arguments of these types, to be checked against cubin
+				metadata.
+			*/
+      template <class A,
+                class B = not_specified,
+                class C = not_specified,
+                class D = not_specified,
+                class E = not_specified,
+                class F = not_specified,
+                class G = not_specified,
+                class H = not_specified,
+                class I = not_specified,
+                class J = not_specified>
+      struct Parameters
+      {
+        static std::vector<CubinParameter> layout()
+        {
+          layout_parameters lp;
+          lp.add<A>();
+          lp.add<B>();
+          lp.add<C>();
+          lp.add<D>();
+          lp.add<E>();
+          lp.add<F>();
+          lp.add<G>();
+          lp.add<H>();
+          lp.add<I>();
+          lp.add<J>();
+          return lp.parameters;
+        }
+      };
+
       template <class A,
                 class B,
                 class C,
@@ -160,6 +324,7 @@ namespace cuda
                 class J>
       void go_impl( int width, int height, const Stream &stream, A a, B b, C c, D d, E e, F f, G g, H h, I i, J j )
       {
+        ScopedLock lock( *this );
         set_parameters sp = set_parameters(this);
         sp( a );
         sp( b );
@@ -364,12 +529,25 @@ namespace cuda
 		private:
 			struct impl_t;
 			boost::scoped_ptr<impl_t> impl;
+
+			friend class LaunchRecord;
 	};
 
   template <>
   inline void Function::set_parameters::operator()(Function::not_specified)
   {
   }
+
+  template <>
+  struct Function::parameter_bytes<DevicePtr>
+  {
+    enum { value = sizeof( int ) };
+  };
+
+  template <>
+  inline void Function::layout_parameters::add<Function::not_specified>()
+  {
+  }
 }
 
 
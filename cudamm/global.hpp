@@ -0,0 +1,134 @@
+#ifndef CUDA_GLOBAL_HPP
+#define CUDA_GLOBAL_HPP
+
+#include <boost/utility.hpp>
+
+#include <cudamm/exception.hpp>
+#include <cudamm/deviceptr.hpp>
+#include <cudamm/module.hpp>
+#include <cudamm/stream.hpp>
+
+namespace cuda
+{
+	/// Typed access to a global or __constant__ variable of a module
+	/**
+		Constant variables are read through the constant cache, so
+		small tables and coefficients that are the same for all threads
+		can be uploaded once instead of being passed as parameters on
+		every launch.
+		
+		The variable may be an array of T, count() gives the number of
+		elements.
+		
+		Noncopyable.
+	*/
+	template <class T>
+	class Global : boost::noncopyable
+	{
+		public:
+			/// Look up a variable in a module
+			/**
+				@param mod the module containing the variable
+				@param name the name of the variable
+			*/
+			Global(const Module &mod, const char *name)
+				: ptr_(mod.global(name, size_))
+			{
+				if(size_ < sizeof(T)) throw Exception("Cuda global is smaller than its type");
+			}
+			
+			/// Get a device pointer to the variable
+			const DevicePtr& ptr() const { return ptr_; }
+			
+			/// Get the size of the variable (in bytes)
+			unsigned int size() const { return size_; }
+			
+			/// Get the number of elements of type T in the variable
+			unsigned int count() const { return size_ / sizeof(T); }
+			
+			/// Upload a single value
+			/**
+				@param value the value to write to the first element
+			*/
+			void upload(const T &value) const
+			{
+				upload(&value, 1);
+			}
+			
+			/// Upload an array of values
+			/**
+				@param src the values to write
+				@param n the number of elements to write
+				@param first the index of the first element to write
+			*/
+			void upload(const T *src, unsigned int n, unsigned int first = 0) const
+			{
+				check(n, first);
+				memcpy(ptr_ + first * sizeof(T), src, n * sizeof(T));
+			}
+			
+			/// Upload an array of values asynchronously
+			/**
+				Works only with page locked host memory.
+				
+				@param src the values to write
+				@param n the number of elements to write
+				@param stream the stream to associate the copy operation with
+				@param first the index of the first element to write
+			*/
+			void upload(const T *src, unsigned int n, const Stream &stream, unsigned int first = 0) const
+			{
+				check(n, first);
+				memcpy(ptr_ + first * sizeof(T), src, n * sizeof(T), stream);
+			}
+			
+			/// Download a single value
+			/**
+				@return the value of the first element
+			*/
+			T download() const
+			{
+				T value;
+				download(&value, 1);
+				return value;
+			}
+			
+			/// Download an array of values
+			/**
+				@param dest where to store the values
+				@param n the number of elements to read
+				@param first the index of the first element to read
+			*/
+			void download(T *dest, unsigned int n, unsigned int first = 0) const
+			{
+				check(n, first);
+				memcpy(dest, ptr_ + first * sizeof(T), n * sizeof(T));
+			}
+			
+			/// Download an array of values asynchronously
+			/**
+				Works only with page locked host memory.
+				
+				@param dest where to store the values
+				@param n the number of elements to read
+				@param stream the stream to associate the copy operation with
+				@param first the index of the first element to read
+			*/
+			void download(T *dest, unsigned int n, const Stream &stream, unsigned int first = 0) const
+			{
+				check(n, first);
+				memcpy(dest, ptr_ + first * sizeof(T), n * sizeof(T), stream);
+			}
+			
+		private:
+			void check(unsigned int n, unsigned int first) const
+			{
+				if(first + n > count()) throw Exception("Access outside of Cuda global");
+			}
+			
+			unsigned int size_;
+			DevicePtr ptr_;
+	};
+}
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef CUDA_GRIDLAUNCHER_HPP
+#define CUDA_GRIDLAUNCHER_HPP
+
+#include <vector>
+
+#include <cudamm/occupancy.hpp>
+
+namespace cuda
+{
+	class Function;
+	class Stream;
+
+	/// Size of a one, two or three dimensional problem or block
+	struct Extent
+	{
+		/// Create an extent
+		/**
+			@param x the width
+			@param y the height
+			@param z the depth
+		*/
+		explicit Extent(unsigned int x = 1, unsigned int y = 1, unsigned int z = 1)
+			: x(x), y(y), z(z)
+		{
+		}
+
+		unsigned int x, y, z;
+	};
+
+	/// One launch of a split grid
+	struct GridChunk
+	{
+		/// Offset of the chunk in the whole grid (in blocks)
+		unsigned int offsetX, offsetY, offsetZ;
+
+		/// Grid size of the launch
+		unsigned int gridX, gridY;
+	};
+
+	/// Split the grid covering a problem into launches the device accepts
+	/**
+		The grid is split so that no launch exceeds the device grid
+		size limits or maxBlocksPerLaunch blocks. Since grids are two
+		dimensional, a three dimensional problem takes one launch per
+		layer of blocks in Z.
+
+		@param problem the problem size (in threads)
+		@param block the block shape
+		@param limits the device limits
+		@param maxBlocksPerLaunch the largest number of blocks of one launch, 0 for no limit
+		@return the launches, each covering a disjoint part of the grid
+	*/
+	std::vector<GridChunk> splitGrid(const Extent &problem, const Extent &block,
+		const DeviceLimits &limits, unsigned int maxBlocksPerLaunch = 0);
+
+	/// Launches of a function over a problem extent
+	/**
+		Computes the grid covering a problem and splits it into as
+		many launches as needed. Every launch passes the offset of its
+		part of the grid (in blocks) to the kernel as three int
+		parameters at offsetParameter, so the kernel finds its block
+		in the whole grid as (blockIdx.x + offsetX, blockIdx.y +
+		offsetY, offsetZ). The parameter size of the function has to
+		cover these three ints.
+
+		Limiting the blocks per launch keeps single launches short,
+		e.g. to stay below a display watchdog.
+	*/
+	class GridLauncher
+	{
+		public:
+			/// Create a launcher for the device of the current context
+			/**
+				@param function the function to launch
+				@param offsetParameter byte offset of the grid offset parameters
+			*/
+			GridLauncher(const Function &function, int offsetParameter);
+
+			/// Create a launcher for a device
+			/**
+				@param function the function to launch
+				@param offsetParameter byte offset of the grid offset parameters
+				@param limits the device limits
+			*/
+			GridLauncher(const Function &function, int offsetParameter, const DeviceLimits &limits);
+
+			/// Limit the number of blocks of a single launch
+			/**
+				@param blocks the largest number of blocks, 0 for no limit
+			*/
+			GridLauncher& maxBlocksPerLaunch(unsigned int blocks);
+
+			/// Launch the function over a problem
+			/**
+				Sets the block shape of the function.
+
+				@param problem the problem size (in threads)
+				@param block the block shape
+			*/
+			void launch(const Extent &problem, const Extent &block) const;
+
+			/// Launch the function over a problem asynchronously
+			/**
+				Sets the block shape of the function.
+
+				@param problem the problem size (in threads)
+				@param block the block shape
+				@param stream the stream to associate the launches with
+			*/
+			void launch(const Extent &problem, const Extent &block, const Stream &stream) const;
+
+		private:
+			void launch(const Extent &problem, const Extent &block, const Stream *stream) const;
+
+			const Function &function;
+			int offsetParameter;
+			DeviceLimits limits;
+			unsigned int maxBlocks;
+	};
+}
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef CUDA_HALOEXCHANGE_HPP
+#define CUDA_HALOEXCHANGE_HPP
+
+#include <vector>
+
+#include <boost/utility.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <cudamm/context.hpp>
+#include <cudamm/deviceptr.hpp>
+#include <cudamm/partitioner.hpp>
+
+namespace cuda
+{
+	class Stream;
+
+	/// Part of a domain split across devices, with room for halos
+	/**
+		The buffer holds the interior of the part surrounded by halo
+		rows above and below (or halo columns left and right for
+		column splits), so the interior starts at row (or column)
+		halo. Buffers of row splits have height + 2 * halo rows,
+		buffers of column splits are (width + 2 * halo) elements wide.
+	*/
+	struct HaloPartition
+	{
+		/// Context the buffer and stream belong to
+		Context::context_ptr context;
+
+		/// The buffer and its pitch (in bytes)
+		DevicePtr buffer;
+		unsigned int pitch;
+
+		/// Size of the interior (in elements)
+		unsigned int width, height;
+
+		/// Stream the stencil kernels of the part run on
+		const Stream *stream;
+	};
+
+	/// Exchange of boundary rows or columns between neighbouring devices
+	/**
+		After a stencil step every part needs the outermost interior
+		rows of its neighbours as halo. The exchange copies them with
+		Memcpy2D sub-rectangle copies to portable page locked staging
+		buffers and on into the neighbours' halos, on streams of its
+		own. Devices wait for each other with events on the device,
+		the host never blocks.
+
+		A step overlaps the exchange with interior computation:
+
+			launch boundary kernels (they need the current halos)
+			exchange.beginExchange();
+			launch interior kernels (must not touch the halos)
+			exchange.finishExchange();
+
+		beginExchange starts copying once the work issued so far on
+		each part's stream has completed, finishExchange makes work
+		issued afterwards wait until the new halos have arrived.
+		Parts are neighbours in the order given, top to bottom (or
+		left to right).
+
+		Noncopyable.
+	*/
+	class HaloExchange : boost::noncopyable
+	{
+		public:
+			/// Create an exchange
+			/**
+				@param partitions the parts of the domain, in order
+				@param halo the width of the halo (in rows or columns)
+				@param elementSize the size of an element (in bytes)
+				@param split whether the domain is split into rows or columns
+			*/
+			HaloExchange(const std::vector<HaloPartition> &partitions, unsigned int halo,
+				unsigned int elementSize, Partitioner::Split split = Partitioner::ROWS);
+
+			/// Wait for pending exchanges and release the staging resources
+			~HaloExchange();
+
+			/// Start exchanging the boundaries of the work issued so far
+			void beginExchange();
+
+			/// Make work issued from now on wait for the exchanged halos
+			void finishExchange();
+
+			/// Exchange the halos
+			void exchange()
+			{
+				beginExchange();
+				finishExchange();
+			}
+
+			/// Get the width of the halo
+			/**
+				@return the halo width (in rows or columns)
+			*/
+			unsigned int halo() const;
+
+			/// Get the number of bytes copied to the device per exchange
+			/**
+				@return the bytes of all halos
+			*/
+			unsigned long bytes() const;
+		private:
+			struct impl_t;
+			boost::scoped_ptr<impl_t> impl;
+	};
+}
+
+#endif
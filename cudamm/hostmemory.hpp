@@ -0,0 +1,58 @@
+#ifndef CUDA_HOSTMEMORY_HPP
+#define CUDA_HOSTMEMORY_HPP
+
+#include <iostream>
+
+#include <boost/utility.hpp>
+
+#include <cudamm/exception.hpp>
+
+namespace cuda
+{
+	/// Allocate page locked host memory
+	/**
+		Asynchronous copies need page locked host memory. Portable
+		memory is page locked for all contexts, not only the current
+		one, so it can stage copies between devices.
+
+		@param size the number of bytes to allocate
+		@param portable true to make it page locked for all contexts
+		@return the memory
+	*/
+	void *mallocHost(unsigned int size, bool portable = false);
+
+	/// Free page locked host memory
+	/**
+		@param ptr memory returned by mallocHost
+	*/
+	void freeHost(void *ptr);
+
+	class HostMemory : boost::noncopyable
+	{
+		public:
+			explicit HostMemory(unsigned int size, bool portable = false)
+				: ptr_(mallocHost(size, portable)), size_(size)
+			{
+			}
+
+			~HostMemory()
+			{
+				try
+				{
+					freeHost(ptr());
+				} catch(cuda::Exception const &e)
+				{
+					std::cerr << e.what() << std::endl;
+				}
+			}
+
+			void *ptr() const { return ptr_; }
+			unsigned int size() const { return size_; }
+
+		private:
+			void *ptr_;
+			unsigned int size_;
+	};
+}
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef CUDA_LAUNCHRECORD_HPP
+#define CUDA_LAUNCHRECORD_HPP
+
+#include <boost/scoped_ptr.hpp>
+
+namespace cuda
+{
+	class Function;
+	class Stream;
+
+	/// Snapshot of a fully configured kernel launch
+	/**
+		Records block shape, shared size, parameters and textures of
+		a function as they are currently set, together with a grid
+		size. Replaying the record only sends the state to the driver
+		that differs from the last state set on that function, so
+		steady-state loops that launch the same configuration again
+		and again skip nearly all driver calls but the launch itself.
+
+		Parameter ranges that change between launches can be marked
+		dynamic and are given to replay as one packed block of data.
+	*/
+	class LaunchRecord
+	{
+		public:
+			/// Record the current launch configuration of a function
+			/**
+				The block shape and parameter size of the function must
+				have been set. Parameter bytes not set through the
+				function are recorded as 0.
+
+				@param function the configured function
+				@param gridWidth the width of the grid
+				@param gridHeight the height of the grid
+			*/
+			LaunchRecord(const Function &function, int gridWidth, int gridHeight);
+
+			/// Copy constructor
+			/**
+				@param copy the record to copy
+			*/
+			LaunchRecord(const LaunchRecord &copy);
+
+			/// Destructor
+			~LaunchRecord();
+
+			/// Assignment
+			/**
+				@param copy the record to assign to *this
+			*/
+			LaunchRecord& operator=(const LaunchRecord &copy)
+			{
+				if(&copy == this) return *this;
+				LaunchRecord temp(copy);
+				swap(*this, temp);
+				return *this;
+			}
+
+			/// Mark a parameter range as dynamic
+			/**
+				Dynamic ranges are packed in the order they are marked.
+
+				@param offset byte offset in parameter space of the kernel
+				@param len size of the range in bytes
+			*/
+			LaunchRecord& dynamic(int offset, unsigned int len);
+
+			/// Get the size of the packed dynamic parameter data
+			/**
+				@return the sum of the sizes of all dynamic ranges
+			*/
+			unsigned int dynamicSize() const;
+
+			/// Launch the recorded configuration asynchronously
+			/**
+				Dynamic ranges keep their recorded values.
+
+				@param stream the stream to associate the kernel with
+			*/
+			void replay(const Stream &stream) const;
+
+			/// Launch the recorded configuration with new dynamic parameters
+			/**
+				@param stream the stream to associate the kernel with
+				@param dynamicData the packed values of all dynamic ranges (dynamicSize() bytes)
+			*/
+			void replay(const Stream &stream, const void *dynamicData) const;
+
+		private:
+			struct impl_t;
+			boost::scoped_ptr<impl_t> impl;
+
+			/// Swap two records
+			/**
+				@param a the record to swap with b
+				@param b the record to swap with a
+			*/
+			friend void swap(LaunchRecord &a, LaunchRecord &b);
+	};
+
+	inline void swap(LaunchRecord &a, LaunchRecord &b)
+	{
+		swap(a.impl, b.impl);
+	}
+}
+
+#endif
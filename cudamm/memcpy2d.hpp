@@ -17,7 +17,8 @@ namespace cuda
 		public:
 			/// Create a new copy descriptor
 			/**
-				Assign source and destination position to 0, 0.
+				Assign source and destination position to 0, 0 and
+				their pitches to 0.
 				
 				@param widthBytes the width of the memory region to copy (in bytes)
 				@param height the height of the memory region to copy
@@ -105,6 +106,30 @@ namespace cuda
 				@param height the height of the memory region to copy
 			*/
 			Memcpy2D& size(unsigned int widthBytes, unsigned int height);
+
+			/// Get the number of bytes the copy moves
+			/**
+				@return width (in bytes) times height
+			*/
+			unsigned long bytes() const;
+
+			/// Query if source and destination are set
+			/**
+				@return true if both are set
+			*/
+			bool complete() const;
+
+			/// Query if the copy reads host memory
+			/**
+				@return true if the source is host memory
+			*/
+			bool fromHost() const;
+
+			/// Query if the copy writes host memory
+			/**
+				@return true if the destination is host memory
+			*/
+			bool toHost() const;
 			
 			/// Execute copy
 			/**
@@ -135,6 +160,8 @@ namespace cuda
 		private:
 			struct impl_t;
 			boost::scoped_ptr<impl_t> impl;
+
+			friend class CommandBatch;
 			
 			/// Swap two Memcpy2D's
 			/**
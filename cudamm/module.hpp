@@ -1,11 +1,52 @@
 #ifndef CUDA_MODULE_HPP
 #define CUDA_MODULE_HPP
 
+#include <string>
+
 #include <boost/utility.hpp>
 #include <boost/scoped_ptr.hpp>
 
 namespace cuda
 {
+	class DevicePtr;
+
+	/// Options for loading and just-in-time compiling modules
+	/**
+		The JIT options only have an effect on PTX images, binary
+		images are loaded as they are.
+	*/
+	struct JitOptions
+	{
+		/// Create options that leave everything to the driver
+		JitOptions()
+			: maxRegisters(0)
+			, optimizationLevel(-1)
+			, target(-1)
+			, logSize(8192)
+		{
+		}
+		
+		/// Maximum number of registers per thread, 0 for no limit
+		unsigned int maxRegisters;
+		
+		/// Optimization level (0 to 4), -1 for the driver default
+		int optimizationLevel;
+		
+		/// Compilation target (a CUjit_target value), -1 to use the current context
+		int target;
+		
+		/// Size of the info and error log buffers in bytes
+		unsigned int logSize;
+		
+		/// Directory of the on-disk cache of compiled modules, empty to disable it
+		/**
+			Compiled PTX images are stored under a name derived from the
+			image contents, the device, the driver version and the JIT
+			options, so each image is compiled only once per machine.
+		*/
+		std::string cacheDirectory;
+	};
+
 	/// CUDA modules
 	/**
 		Noncopyable.
@@ -19,8 +60,56 @@ namespace cuda
 			*/
 			explicit Module(const char *filename);
 			
+			/// Load a module from file with JIT options
+			/**
+				@param filename the module file (cubin or PTX)
+				@param options the JIT options
+			*/
+			Module(const char *filename, const JitOptions &options);
+			
 			/// Unload module
 			~Module();
+			
+			/// Get the JIT info log
+			/**
+				@return the info log of the last compilation, empty if the module was not compiled
+			*/
+			const std::string& infoLog() const;
+			
+			/// Get the JIT error log
+			/**
+				@return the error log of the last compilation, empty if the module was not compiled
+			*/
+			const std::string& errorLog() const;
+			
+			/// Get the hash of the module image
+			/**
+				@return the hash, the same for the same image in every process
+			*/
+			const std::string& hash() const;
+			
+			/// Query if the module was loaded from the on-disk cache
+			/**
+				@return true if no compilation was needed
+			*/
+			bool cached() const;
+			
+			/// Get a global variable of the module
+			/**
+				Works for both __device__ and __constant__ variables.
+				
+				@param name the name of the variable
+				@return a device pointer to the variable
+			*/
+			DevicePtr global(const char *name) const;
+			
+			/// Get a global variable of the module and its size
+			/**
+				@param name the name of the variable
+				@param bytes a reference where to store the size of the variable (in bytes)
+				@return a device pointer to the variable
+			*/
+			DevicePtr global(const char *name, unsigned int &bytes) const;
 		private:
 			struct impl_t;
 			boost::scoped_ptr<impl_t> impl;
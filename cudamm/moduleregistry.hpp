@@ -0,0 +1,94 @@
+#ifndef CUDA_MODULEREGISTRY_HPP
+#define CUDA_MODULEREGISTRY_HPP
+
+#include <boost/utility.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace cuda
+{
+	class Module;
+	struct JitOptions;
+
+	/// Process-wide registry of loaded CUDA modules
+	/**
+		Every module image is loaded only once per context and shared
+		by all users that ask for the same file in the current context. The module is unloaded when
+		the last shared reference to it goes away.
+		
+		All member functions are thread-safe.
+		
+		Noncopyable.
+	*/
+	class ModuleRegistry : boost::noncopyable
+	{
+		public:
+			/// Shared module handle
+			typedef boost::shared_ptr<Module> module_ptr;
+			
+			/// Get the process-wide registry
+			/**
+				@return the registry instance
+			*/
+			static ModuleRegistry& instance();
+			
+			/// Load a module from file or share an already loaded one
+			/**
+				Files are identified by their canonical path, so different
+				spellings of the same path share one module.
+				
+				@param filename the module file
+				@return the shared module
+			*/
+			module_ptr load(const char *filename);
+			
+			/// Load a module with JIT options or share an already loaded one
+			/**
+				Modules are only shared between users that ask for the
+				same JIT options.
+				
+				@param filename the module file
+				@param options the JIT options
+				@return the shared module
+			*/
+			module_ptr load(const char *filename, const JitOptions &options);
+			
+			/// Get the number of modules currently alive in the registry
+			/**
+				@return the number of loaded modules
+			*/
+			unsigned int size() const;
+			
+		private:
+			ModuleRegistry();
+			~ModuleRegistry();
+			
+			module_ptr load(const char *filename, const JitOptions *options);
+			
+			struct impl_t;
+			boost::scoped_ptr<impl_t> impl;
+	};
+	
+	/// Load a module through the process-wide registry
+	/**
+		@param filename the module file
+		@return the shared module
+	*/
+	inline ModuleRegistry::module_ptr loadModule(const char *filename)
+	{
+		return ModuleRegistry::instance().load(filename);
+	}
+	
+	/// Load a module with JIT options through the process-wide registry
+	/**
+		@param filename the module file
+		@param options the JIT options
+		@return the shared module
+	*/
+	inline ModuleRegistry::module_ptr loadModule(const char *filename, const JitOptions &options)
+	{
+		return ModuleRegistry::instance().load(filename, options);
+	}
+}
+
+#endif
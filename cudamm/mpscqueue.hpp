@@ -0,0 +1,110 @@
+#ifndef CUDA_MPSCQUEUE_HPP
+#define CUDA_MPSCQUEUE_HPP
+
+#include <boost/atomic.hpp>
+#include <boost/utility.hpp>
+
+namespace cuda
+{
+	/// Lock-free multi-producer single-consumer queue
+	/**
+		Dmitry Vyukov's intrusive MPSC queue over heap nodes: push is
+		one atomic exchange and never waits, pop is wait-free for the
+		single consumer. A push that is in the middle of linking its
+		node makes pop report an empty queue until it is linked, so
+		the consumer must not take an empty pop as proof that no push
+		has started.
+
+		push may be called from any thread, pop and empty only from
+		one consumer thread at a time.
+
+		Noncopyable.
+	*/
+	template <class T>
+	class MpscQueue : boost::noncopyable
+	{
+		public:
+			/// Create an empty queue
+			MpscQueue()
+				: head(new node_t)
+				, tail(head.load(boost::memory_order_relaxed))
+			{
+			}
+
+			/// Destroy the queue and the values left in it
+			~MpscQueue()
+			{
+				while(node_t *next = tail->next.load(boost::memory_order_relaxed))
+				{
+					delete tail;
+					tail = next;
+				}
+				delete tail;
+			}
+
+			/// Append a value
+			/**
+				@param value the value
+			*/
+			void push(const T &value)
+			{
+				node_t *node = new node_t(value);
+
+				// Sequentially consistent so that consumers going to sleep
+				// either see the node or are seen sleeping by the producer
+				node_t *prev = head.exchange(node);
+				prev->next.store(node);
+			}
+
+			/// Take the oldest value
+			/**
+				@param value set to the oldest value
+				@return false if the queue is empty
+			*/
+			bool pop(T &value)
+			{
+				node_t *next = tail->next.load(boost::memory_order_acquire);
+				if(!next) return false;
+
+				// next becomes the stub node, its value is no longer needed
+				value = next->value;
+				next->value = T();
+				delete tail;
+				tail = next;
+				return true;
+			}
+
+			/// Query if the queue is empty
+			/**
+				@return true if there is nothing to pop
+			*/
+			bool empty() const
+			{
+				return !tail->next.load();
+			}
+
+		private:
+			struct node_t
+			{
+				node_t()
+					: next(0)
+				{
+				}
+
+				explicit node_t(const T &value)
+					: next(0)
+					, value(value)
+				{
+				}
+
+				boost::atomic<node_t *> next;
+				T value;
+			};
+
+			// Producers append at head, the consumer takes after tail
+			boost::atomic<node_t *> head;
+			node_t *tail;
+	};
+}
+
+#endif
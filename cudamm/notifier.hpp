@@ -0,0 +1,99 @@
+#ifndef CUDA_NOTIFIER_HPP
+#define CUDA_NOTIFIER_HPP
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+#include <boost/scoped_ptr.hpp>
+
+namespace cuda
+{
+	class Event;
+	class Stream;
+
+	/// Completion notifications through a file descriptor
+	/**
+		Exposes an eventfd that becomes readable when watched work has
+		completed, so GPU completion can join an epoll (or poll/select)
+		set next to sockets and timers. The notification is written by
+		a stream callback of the driver; no thread waits or polls.
+
+		Each watch carries a token; drain() returns the tokens of all
+		completed watches and resets the descriptor, failed() those of
+		watches whose stream reported an error. Linux only.
+
+		Noncopyable.
+	*/
+	class CompletionNotifier : boost::noncopyable
+	{
+		public:
+			/// Create a notifier
+			/**
+				Creates a non-blocking eventfd. Streams for watching
+				events are created as needed, one per pending event
+				watch, in the context current at the time.
+			*/
+			CompletionNotifier();
+
+			/// Destructor
+			/**
+				The descriptor stays open until the callbacks of pending
+				watches have run.
+			*/
+			~CompletionNotifier();
+
+			/// Get the descriptor to wait on
+			/**
+				@return the file descriptor, readable when watches have completed
+			*/
+			int fd() const;
+
+			/// Watch all operations issued to a stream so far
+			/**
+				@param stream the stream
+				@param token the token reported by drain()
+			*/
+			void watch(const Stream &stream, unsigned long token);
+
+			/// Watch a recorded event
+			/**
+				Does not affect the stream the event was recorded on,
+				nor wait for events watched before.
+
+				@param event the event
+				@param token the token reported by drain()
+			*/
+			void watch(const Event &event, unsigned long token);
+
+			/// Collect completed watches
+			/**
+				Call when fd() is readable. Never blocks. Failed
+				watches also make fd() readable but are only reported
+				by failed().
+
+				@return the tokens of the watches completed since the last drain
+			*/
+			std::vector<unsigned long> drain();
+
+			/// Collect failed watches
+			/**
+				Call after drain(). Never blocks.
+
+				@return the tokens of the watches that failed since the last call
+			*/
+			std::vector<unsigned long> failed();
+
+			/// Get the number of watches not completed yet
+			/**
+				@return the number of pending watches
+			*/
+			unsigned int pending() const;
+
+		private:
+			struct impl_t;
+			boost::scoped_ptr<impl_t> impl;
+	};
+}
+
+#endif
@@ -0,0 +1,191 @@
+#ifndef CUDA_OCCUPANCY_HPP
+#define CUDA_OCCUPANCY_HPP
+
+#include <vector>
+
+namespace cuda
+{
+	class Function;
+	struct CubinKernel;
+
+	/// Execution resource limits of a device
+	struct DeviceLimits
+	{
+		unsigned int warpSize;
+		unsigned int multiprocessors;
+
+		unsigned int maxThreadsPerBlock;
+		unsigned int maxBlockDimX, maxBlockDimY, maxBlockDimZ;
+		unsigned int maxGridDimX, maxGridDimY;
+
+		unsigned int maxThreadsPerMultiprocessor;
+		unsigned int maxBlocksPerMultiprocessor;
+
+		/// Registers of one multiprocessor
+		unsigned int registersPerMultiprocessor;
+
+		/// Register allocation granularity
+		unsigned int registerAllocationUnit;
+
+		/// True if registers are allocated per warp, false if per block
+		bool registersPerWarp;
+
+		unsigned int sharedPerMultiprocessor;
+		unsigned int sharedPerBlock;
+
+		/// Shared memory allocation granularity (in bytes)
+		unsigned int sharedAllocationUnit;
+
+		/// Get the limits of a device generation
+		/**
+			Needs no driver, so launch shapes can be planned from
+			cubin metadata alone.
+
+			@param major the major compute capability
+			@param minor the minor compute capability
+			@param multiprocessors the number of multiprocessors of the device
+			@return the limits
+		*/
+		static DeviceLimits forComputeCapability(int major, int minor, unsigned int multiprocessors = 1);
+
+		/// Get the limits of the device of the current context
+		/**
+			@return the limits
+		*/
+		static DeviceLimits current();
+	};
+
+	/// Resource usage of a kernel that limits occupancy
+	struct KernelResources
+	{
+		/// Create a resource description
+		/**
+			@param registers registers per thread
+			@param sharedBytes static shared memory per block (in bytes)
+			@param maxThreadsPerBlock the largest block size of the kernel, 0 for the device limit
+		*/
+		explicit KernelResources(unsigned int registers = 0, unsigned int sharedBytes = 0, unsigned int maxThreadsPerBlock = 0)
+			: registers(registers), sharedBytes(sharedBytes), maxThreadsPerBlock(maxThreadsPerBlock)
+		{
+		}
+
+		/// Get the resources of a kernel from cubin metadata
+		/**
+			@param kernel the kernel metadata
+		*/
+		explicit KernelResources(const CubinKernel &kernel);
+
+		/// Get the resources of a loaded function
+		/**
+			@param function the function
+		*/
+		explicit KernelResources(const Function &function);
+
+		unsigned int registers;
+		unsigned int sharedBytes;
+		unsigned int maxThreadsPerBlock;
+	};
+
+	/// Launch configuration of a kernel
+	struct LaunchConfig
+	{
+		LaunchConfig()
+			: blockX(0), blockY(0), blockZ(0), sharedBytes(0), gridX(0), gridY(0)
+			, blocksPerMultiprocessor(0), warpsPerMultiprocessor(0), occupancy(0.0f)
+		{
+		}
+
+		/// Get the number of threads in one block
+		unsigned int threads() const { return blockX * blockY * blockZ; }
+
+		/// Block shape
+		unsigned int blockX, blockY, blockZ;
+
+		/// Dynamic shared memory per block (in bytes)
+		unsigned int sharedBytes;
+
+		/// Grid size
+		unsigned int gridX, gridY;
+
+		/// Resident blocks on one multiprocessor
+		unsigned int blocksPerMultiprocessor;
+
+		/// Resident warps on one multiprocessor
+		unsigned int warpsPerMultiprocessor;
+
+		/// Ratio of resident warps to the maximum the multiprocessor can hold
+		float occupancy;
+	};
+
+	/// Calculate the number of resident blocks per multiprocessor
+	/**
+		@param limits the device limits
+		@param resources the kernel resources
+		@param threads the number of threads per block
+		@param dynamicShared the dynamic shared memory per block (in bytes)
+		@return the number of blocks, 0 if the kernel can't be launched with this block size
+	*/
+	unsigned int residentBlocks(const DeviceLimits &limits, const KernelResources &resources,
+		unsigned int threads, unsigned int dynamicShared = 0);
+
+	/// List all launch configurations that fit the device and kernel
+	/**
+		Gives one configuration for every block size that is a
+		multiple of the warp size and fits the kernel resources.
+
+		The dynamic shared memory of a block is sharedPerBlock +
+		sharedPerThread * threads.
+
+		@param limits the device limits
+		@param resources the kernel resources
+		@param width the problem width (in threads)
+		@param height the problem height (in threads)
+		@param sharedPerThread the dynamic shared memory needed by each thread (in bytes)
+		@param sharedPerBlock the dynamic shared memory needed by each block (in bytes)
+		@return the launch configurations ordered by block size
+	*/
+	std::vector<LaunchConfig> feasibleLaunches(const DeviceLimits &limits, const KernelResources &resources,
+		unsigned int width, unsigned int height = 1,
+		unsigned int sharedPerThread = 0, unsigned int sharedPerBlock = 0);
+
+	/// Recommend a launch configuration for a problem size
+	/**
+		Tries all feasible launch configurations and picks the one
+		that keeps the most warps resident on the whole device for
+		the given problem, preferring less idle threads and
+		higher per-multiprocessor occupancy on ties.
+
+		An exception is thrown if no block size fits.
+
+		@param limits the device limits
+		@param resources the kernel resources
+		@param width the problem width (in threads)
+		@param height the problem height (in threads)
+		@param sharedPerThread the dynamic shared memory needed by each thread (in bytes)
+		@param sharedPerBlock the dynamic shared memory needed by each block (in bytes)
+		@return the launch configuration
+	*/
+	LaunchConfig recommendLaunch(const DeviceLimits &limits, const KernelResources &resources,
+		unsigned int width, unsigned int height = 1,
+		unsigned int sharedPerThread = 0, unsigned int sharedPerBlock = 0);
+
+	/// Choose and apply a launch configuration for a function
+	/**
+		Queries the device of the current context and the function's
+		attributes, then sets the block shape and shared size of the
+		function. The returned grid size is to be passed to
+		Function::launch.
+
+		@param function the function to configure
+		@param width the problem width (in threads)
+		@param height the problem height (in threads)
+		@param sharedPerThread the dynamic shared memory needed by each thread (in bytes)
+		@param sharedPerBlock the dynamic shared memory needed by each block (in bytes)
+		@return the applied launch configuration
+	*/
+	LaunchConfig configureLaunch(const Function &function,
+		unsigned int width, unsigned int height = 1,
+		unsigned int sharedPerThread = 0, unsigned int sharedPerBlock = 0);
+}
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef CUDA_PARTITIONER_HPP
+#define CUDA_PARTITIONER_HPP
+
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/utility.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <cudamm/deviceptr.hpp>
+
+namespace cuda
+{
+	class Function;
+	class Stream;
+
+	/// Part of a 2D domain assigned to one device
+	struct Tile
+	{
+		/// Index of the device in the partitioner
+		unsigned int device;
+
+		/// Position and size of the tile (in elements)
+		unsigned int x, y, width, height;
+	};
+
+	/// Device side of a tile, passed to the launch callback
+	struct Partition
+	{
+		/// The tile
+		Tile tile;
+
+		/// Input of the tile, its top left element at (0, 0)
+		DevicePtr input;
+		unsigned int inputPitch;
+
+		/// Output of the tile, its top left element at (0, 0)
+		DevicePtr output;
+		unsigned int outputPitch;
+	};
+
+	/// Data-parallel execution of a kernel over a 2D domain on several devices
+	/**
+		Splits the domain into one strip of rows (or columns) per device,
+		sized by the relative throughput of the devices. A run uploads
+		every strip to its device with a Memcpy2D sub-rectangle copy,
+		launches the kernel on it and copies the result back into the
+		host output, all devices working concurrently on their own
+		stream. Host buffers must be page-locked for the copies to
+		overlap.
+
+		The kernel module is loaded once per device through the
+		ModuleRegistry. The launch callback sets the parameters of the
+		kernel for a tile and launches it on the stream, e.g.
+
+			function.go(gridWidth, gridHeight, stream, partition.output, ...)
+
+		It is called with the device's context current.
+
+		Weights start out proportional to multiprocessors times clock
+		rate. With adaptive weights every run times the devices with
+		events and moves the weights towards the measured throughput.
+
+		Noncopyable.
+	*/
+	class Partitioner : boost::noncopyable
+	{
+		public:
+			/// How the domain is split
+			enum Split {
+				ROWS,
+				COLUMNS };
+
+			/// Kernel launch for one tile
+			typedef boost::function<void (const Function &, const Partition &, const Stream &)> Launch;
+
+			/// Create a partitioner
+			/**
+				@param devices the device numbers to use
+				@param moduleFile the module containing the kernel
+				@param kernel the name of the kernel
+				@param split how to split the domain
+			*/
+			Partitioner(const std::vector<int> &devices, const char *moduleFile, const char *kernel, Split split = ROWS);
+
+			/// Release the device resources
+			~Partitioner();
+
+			/// Get the number of devices
+			/**
+				@return the number of devices
+			*/
+			unsigned int devices() const;
+
+			/// Get the relative throughput of the devices
+			/**
+				@return the weights, summing up to 1
+			*/
+			const std::vector<double>& weights() const;
+
+			/// Set the relative throughput of the devices
+			/**
+				@param weights one non-negative weight per device
+			*/
+			void setWeights(const std::vector<double> &weights);
+
+			/// Choose if runs update the weights with measured throughput
+			/**
+				@param adaptive true to adapt the weights
+			*/
+			void setAdaptive(bool adaptive);
+
+			/// Make tile sizes multiples of a granularity
+			/**
+				E.g. the block height for row splits, so that no block
+				straddles two tiles. Only the last tile may be smaller.
+
+				@param granularity the granularity (in elements)
+			*/
+			void setGranularity(unsigned int granularity);
+
+			/// Get the tiles of a domain
+			/**
+				@param width the domain width (in elements)
+				@param height the domain height
+				@return one tile per device, empty tiles included
+			*/
+			std::vector<Tile> tiles(unsigned int width, unsigned int height) const;
+
+			/// Run the kernel over a domain on all devices
+			/**
+				Blocks until all devices have finished.
+
+				@param input the host input, 0 for none
+				@param inputPitch the pitch of the input (in bytes)
+				@param output the host output, 0 for none
+				@param outputPitch the pitch of the output (in bytes)
+				@param width the domain width (in elements)
+				@param height the domain height
+				@param elementSize the size of an element (in bytes)
+				@param launch launches the kernel for a tile
+			*/
+			void run(const void *input, unsigned int inputPitch, void *output, unsigned int outputPitch,
+				unsigned int width, unsigned int height, unsigned int elementSize, const Launch &launch);
+
+			/// Get the time each device took in the last run
+			/**
+				@return the times in milliseconds, 0 for devices without work
+			*/
+			const std::vector<float>& times() const;
+
+			/// Split a domain by weights
+			/**
+				@param width the domain width (in elements)
+				@param height the domain height
+				@param weights one non-negative weight per tile
+				@param split how to split the domain
+				@param granularity tile sizes are multiples of it, but the last
+				@return one tile per weight
+			*/
+			static std::vector<Tile> partition(unsigned int width, unsigned int height,
+				const std::vector<double> &weights, Split split = ROWS, unsigned int granularity = 1);
+		private:
+			struct impl_t;
+			boost::scoped_ptr<impl_t> impl;
+	};
+}
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef CUDA_RESIDENCYCACHE_HPP
+#define CUDA_RESIDENCYCACHE_HPP
+
+#include <boost/utility.hpp>
+#include <boost/scoped_ptr.hpp>
+
+namespace cuda
+{
+	class DevicePtr;
+	class Stream;
+
+	/// Counters of a ResidencyCache
+	struct ResidencyStats
+	{
+		/// Acquires of resident and of missing blocks
+		unsigned long hits, misses;
+
+		/// Blocks prefetched, and prefetched blocks acquired
+		unsigned long prefetches, prefetchHits;
+
+		/// Blocks evicted, and evicted blocks written back
+		unsigned long evictions, writeBacks;
+
+		/// Get the hit rate
+		/**
+			@return the share of acquires that found the block resident
+		*/
+		double hitRate() const
+		{
+			return hits + misses ? static_cast<double>(hits) / (hits + misses) : 0.0;
+		}
+	};
+
+	/// Device memory as a cache of blocks of a larger host buffer
+	/**
+		The host buffer is split into blocks of blockBytes, of which
+		deviceBlocks fit into device memory at a time. acquire makes a
+		block resident and returns its device memory: a miss evicts the
+		least recently used block that is not acquired, writes it back
+		to the host if it is dirty, and uploads the block, all on the
+		access stream, so kernels issued to that stream afterwards see
+		the data.
+
+		With a prefetch distance, acquiring block b also prefetches the
+		next blocks on a side stream. Prefetches only evict blocks that
+		are not acquired and not prefetched themselves, and wait for
+		the work issued to the access stream so far, so kernels still
+		using an evicted block finish first. An acquire of a prefetched
+		block makes the access stream wait for its upload.
+
+		Acquired blocks stay resident until released. Release them
+		once the kernels using them have been issued; the kernels need
+		not have completed.
+
+		The host buffer must be page locked. Use from one thread with
+		the context of the streams current.
+
+		Noncopyable.
+	*/
+	class ResidencyCache : boost::noncopyable
+	{
+		public:
+			/// Create a cache and allocate its device memory
+			/**
+				The device memory, deviceBlocks * blockBytes, must be less
+				than 4 GiB, cuda::malloc takes 32 bit sizes.
+
+				@param host the page locked host buffer
+				@param bytes the size of the host buffer
+				@param blockBytes the size of a block, the last block may be smaller
+				@param deviceBlocks the number of blocks resident at a time
+				@param stream the access stream
+			*/
+			ResidencyCache(void *host, unsigned long bytes, unsigned int blockBytes,
+				unsigned int deviceBlocks, const Stream &stream);
+
+			/// Write back dirty blocks, wait for the streams and free the device memory
+			~ResidencyCache();
+
+			/// Prefetch blocks ahead of acquires
+			/**
+				@param blocks the number of blocks following an acquired one to prefetch
+			*/
+			ResidencyCache& setPrefetchDistance(unsigned int blocks);
+
+			/// Make a block resident and keep it so
+			/**
+				@param block the block
+				@param write true if kernels write the block, which marks it dirty
+				@return the device memory of the block
+			*/
+			const DevicePtr& acquire(unsigned int block, bool write = false);
+
+			/// Let an acquired block be evicted again
+			/**
+				@param block the block
+			*/
+			void release(unsigned int block);
+
+			/// Upload a block on the side stream if a slot is available
+			/**
+				@param block the block
+				@return true if the block is resident or being uploaded
+			*/
+			bool prefetch(unsigned int block);
+
+			/// Mark a resident block as written by the device
+			/**
+				@param block the block
+			*/
+			void markDirty(unsigned int block);
+
+			/// Write all dirty blocks back to the host on the access stream
+			/**
+				@return the number of blocks written back
+			*/
+			unsigned int writeBack();
+
+			/// Query if a block is resident
+			/**
+				@param block the block
+				@return true if the block is in device memory or being uploaded
+			*/
+			bool resident(unsigned int block) const;
+
+			/// Get the number of blocks of the host buffer
+			/**
+				@return the number of blocks
+			*/
+			unsigned int blocks() const;
+
+			/// Get the size of a block
+			/**
+				@param block the block
+				@return the size of the block (in bytes)
+			*/
+			unsigned int blockBytes(unsigned int block) const;
+
+			/// Get the side stream
+			/**
+				@return the stream prefetches are issued to
+			*/
+			const Stream& prefetchStream() const;
+
+			/// Get the counters
+			/**
+				@return the counters so far
+			*/
+			ResidencyStats stats() const;
+
+		private:
+			struct impl_t;
+			boost::scoped_ptr<impl_t> impl;
+	};
+}
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef CUDA_STREAM_HPP
 #define CUDA_STREAM_HPP
 
+#include <boost/function.hpp>
 #include <boost/utility.hpp>
 #include <boost/scoped_ptr.hpp>
 
@@ -8,6 +9,8 @@ namespace cuda
 {
 	class Array;
 	class DevicePtr;
+	class Event;
+	struct WaitPolicy;
 
 	/// CUDA streams
 	/**
@@ -18,31 +21,98 @@ namespace cuda
 	class Stream : boost::noncopyable
 	{
 		public:
+			/// Stream creation flags
+			enum Flags {
+				DEFAULT = 0x00,
+				NON_BLOCKING = 0x01 };
+
 			/// Create stream
 			Stream();
+
+			/// Create stream with flags and priority
+			/**
+				NON_BLOCKING streams don't synchronize with the legacy
+				default stream. Lower priority numbers are higher
+				priorities: pending work of higher priority streams is
+				scheduled first. Priorities are clamped to the range of
+				the device, see priorityRange.
+
+				@param flags the creation flags
+				@param priority the priority, 0 for the default
+			*/
+			explicit Stream(unsigned int flags, int priority = 0);
 			
 			/// Destroy stream
 			~Stream();
 			
 			/// Block until device has completed all operations in stream 
+			/**
+				Waits by the default policy of the current context if
+				one was set, see WaitPolicy::setContextDefault.
+			*/
 			void synchronize() const;
+
+			/// Wait by a policy until device has completed all operations in stream
+			/**
+				@param policy how to wait
+			*/
+			void synchronize(const WaitPolicy &policy) const;
 			
 			/// Query if all operations in the stream have completed
 			/**
 				@return true if complete
 			*/
 			bool query() const;
+
+			/// Get the priority of the stream
+			/**
+				@return the priority, lower numbers are higher priorities
+			*/
+			int priority() const;
+
+			/// Get the range of stream priorities of the current context
+			/**
+				@param least the lowest priority (largest number)
+				@param greatest the highest priority (smallest number)
+			*/
+			static void priorityRange(int &least, int &greatest);
+
+			/// Call a host function when all preceding operations in the stream have completed
+			/**
+				The callback runs on a driver thread and must not call
+				into Cuda. Operations issued to the stream after it wait
+				for it to return. It is also called if a preceding
+				operation failed, with false.
+
+				@param callback the function to call, with true if the preceding operations succeeded
+			*/
+			void callback(const boost::function<void (bool)> &callback) const;
+
+			/// Make all future operations in the stream wait for an event
+			/**
+				The wait happens on the device, the host does not block.
+				The event must have been recorded. It may belong to
+				another context, e.g. of another device.
+
+				@param event the event to wait for
+			*/
+			void wait(const Event &event) const;
 		private:
 			struct impl_t;
 			boost::scoped_ptr<impl_t> impl;
 			
+			friend class CommandBatch;
 			friend class Event;
 			friend class Function;
+			friend class LaunchRecord;
 			friend class Memcpy2D;
 
 			friend void memcpy(const DevicePtr &dest, const void *src, unsigned int len, const Stream &stream);
 			friend void memcpy(void *dest, const DevicePtr& src, unsigned int len, const Stream &stream);
 
+			friend void memset8(const DevicePtr &ptr, unsigned char value, unsigned int count, const Stream &stream);
+			friend void memset32(const DevicePtr &ptr, unsigned int value, unsigned int count, const Stream &stream);
+
 			friend void memcpy(void *dest, const Array &src, unsigned int srcIndex, unsigned int len, const Stream &stream);
 			friend void memcpy(const Array& dest, unsigned int destIndex, const void *src, unsigned int len, const Stream &stream);
 	};
@@ -0,0 +1,70 @@
+#ifndef CUDA_STREAMPOOL_HPP
+#define CUDA_STREAMPOOL_HPP
+
+#include <boost/utility.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <cudamm/stream.hpp>
+
+namespace cuda
+{
+	/// Fixed set of streams handed out for tasks
+	/**
+		Creates its streams once, so tasks don't create and destroy a
+		stream each. Streams are handed out round-robin or to the least
+		loaded stream. Load is the number of times a stream was handed
+		out since it was last seen idle; idle streams are preferred.
+		Thread-safe.
+
+		Noncopyable.
+	*/
+	class StreamPool : boost::noncopyable
+	{
+		public:
+			/// Stream selection policy
+			enum Policy {
+				ROUND_ROBIN,
+				LEAST_LOADED };
+
+			/// Create a pool
+			/**
+				@param size the number of streams
+				@param policy the selection policy
+				@param flags the creation flags of the streams (see Stream::Flags)
+				@param priority the priority of the streams, 0 for the default
+			*/
+			explicit StreamPool(unsigned int size, Policy policy = ROUND_ROBIN,
+				unsigned int flags = Stream::NON_BLOCKING, int priority = 0);
+
+			/// Destructor
+			~StreamPool();
+
+			/// Get a stream for the next task
+			/**
+				@return the stream selected by the policy
+			*/
+			const Stream& next();
+
+			/// Get the number of streams
+			/**
+				@return the number of streams
+			*/
+			unsigned int size() const;
+
+			/// Get a stream of the pool
+			/**
+				@param index the stream index
+				@return the stream
+			*/
+			const Stream& operator[](unsigned int index) const;
+
+			/// Block until all streams have completed
+			void synchronize() const;
+
+		private:
+			struct impl_t;
+			boost::scoped_ptr<impl_t> impl;
+	};
+}
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef CUDA_TASKEXECUTOR_HPP
+#define CUDA_TASKEXECUTOR_HPP
+
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/utility.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <cudamm/taskgraph.hpp>
+
+namespace cuda
+{
+	class DevicePtr;
+	class LaunchRecord;
+	class Memcpy2D;
+	class Stream;
+
+	/// Runs task graphs on a pool of Cuda streams
+	/**
+		Schedules a graph with scheduleTasks and issues it to its
+		streams, with Cuda events for the dependencies between streams.
+		Nothing blocks the host; call synchronize() to wait for the
+		graph to complete.
+
+		With timing enabled every node is bracketed by a pair of events,
+		which gives the measured run time of each node and the measured
+		critical path of the last execution.
+
+		Noncopyable.
+	*/
+	class TaskExecutor : public TaskBackend, boost::noncopyable
+	{
+		public:
+			/// Create an executor
+			/**
+				@param streams the number of streams to create
+				@param timing true to measure the run time of every node
+			*/
+			explicit TaskExecutor(unsigned int streams, bool timing = false);
+
+			/// Destructor
+			~TaskExecutor();
+
+			/// Get the number of streams
+			/**
+				@return the number of streams
+			*/
+			unsigned int streams() const;
+
+			/// Get a stream of the pool
+			/**
+				@param index the stream index
+				@return the stream
+			*/
+			const Stream& stream(unsigned int index) const;
+
+			/// Schedule a graph and issue it
+			/**
+				The graph must outlive the execution.
+
+				@param graph the task graph
+				@return the schedule, valid until the next execute
+			*/
+			const TaskSchedule& execute(const TaskGraph &graph);
+
+			/// Issue a graph by a given schedule
+			/**
+				@param graph the task graph
+				@param schedule a schedule of the graph for at most streams() streams
+			*/
+			void execute(const TaskGraph &graph, const TaskSchedule &schedule);
+
+			/// Block until all streams have completed
+			void synchronize() const;
+
+			/// Get the measured run times of the last execution
+			/**
+				Requires timing and a completed execution.
+
+				@return the run time of every node (in ms)
+			*/
+			std::vector<float> times() const;
+
+			/// Get the measured critical path of the last execution
+			/**
+				Requires timing and a completed execution.
+
+				@param graph the executed graph
+				@return the critical path time (in ms)
+			*/
+			float criticalPath(const TaskGraph &graph) const;
+
+			void run(const TaskGraph &graph, TaskGraph::Node node, unsigned int stream);
+			void record(unsigned int event, unsigned int stream);
+			void wait(unsigned int stream, unsigned int event);
+
+		private:
+			struct impl_t;
+			boost::scoped_ptr<impl_t> impl;
+	};
+
+	/// Task of an asynchronous 2D copy
+	/**
+		@param copy the copy descriptor, copied into the task
+		@return the work
+	*/
+	TaskGraph::Work copyTask(const Memcpy2D &copy);
+
+	/// Task of an asynchronous copy from page locked host memory to device memory
+	/**
+		@param dest the destination memory pointer
+		@param src the source memory pointer
+		@param len the number of bytes to copy
+		@return the work
+	*/
+	TaskGraph::Work copyTask(const DevicePtr &dest, const void *src, unsigned int len);
+
+	/// Task of an asynchronous copy from device memory to page locked host memory
+	/**
+		@param dest the destination memory pointer
+		@param src the source memory pointer
+		@param len the number of bytes to copy
+		@return the work
+	*/
+	TaskGraph::Work copyTask(void *dest, const DevicePtr &src, unsigned int len);
+
+	/// Task of a kernel launch
+	/**
+		@param record the launch, copied into the task
+		@return the work
+	*/
+	TaskGraph::Work launchTask(const LaunchRecord &record);
+
+	/// Task of an asynchronous memset
+	/**
+		@param ptr the device pointer
+		@param value the value to write
+		@param count the number of values to write
+		@return the work
+	*/
+	TaskGraph::Work memsetTask(const DevicePtr &ptr, unsigned int value, unsigned int count);
+
+	/// Task of a host callback
+	/**
+		See Stream::callback.
+
+		@param callback the function to call, with true if the preceding operations succeeded
+		@return the work
+	*/
+	TaskGraph::Work hostTask(const boost::function<void (bool)> &callback);
+}
+
+#endif
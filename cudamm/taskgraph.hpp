@@ -0,0 +1,211 @@
+#ifndef CUDA_TASKGRAPH_HPP
+#define CUDA_TASKGRAPH_HPP
+
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/utility.hpp>
+#include <boost/scoped_ptr.hpp>
+
+namespace cuda
+{
+	class Stream;
+
+	/// Graph of asynchronous tasks and their data dependencies
+	/**
+		Nodes are pieces of work enqueued on a stream (copies,
+		launches, memsets, host callbacks), edges say which nodes have
+		to complete before a node may start. Each node carries a cost,
+		an estimate of its run time used for scheduling and for the
+		critical path.
+
+		Noncopyable.
+	*/
+	class TaskGraph : boost::noncopyable
+	{
+		public:
+			/// Node of a graph
+			typedef unsigned int Node;
+
+			/// Work of a node, enqueues the node on a stream
+			typedef boost::function<void (const Stream &)> Work;
+
+			/// Create an empty graph
+			TaskGraph();
+
+			/// Destructor
+			~TaskGraph();
+
+			/// Add a node
+			/**
+				@param work the work of the node
+				@param cost the estimated run time of the node (in ms)
+				@return the node
+			*/
+			Node add(const Work &work, float cost = 1.0f);
+
+			/// Add a data dependency
+			/**
+				@param node the dependent node
+				@param on the node that has to complete before node starts
+			*/
+			void depend(Node node, Node on);
+
+			/// Get the number of nodes
+			/**
+				@return the number of nodes
+			*/
+			unsigned int size() const;
+
+			/// Get the work of a node
+			/**
+				@param node the node
+				@return the work
+			*/
+			const Work& work(Node node) const;
+
+			/// Get the estimated run time of a node
+			/**
+				@param node the node
+				@return the cost (in ms)
+			*/
+			float cost(Node node) const;
+
+			/// Set the estimated run time of a node
+			/**
+				E.g. to a time measured by a previous execution.
+
+				@param node the node
+				@param cost the cost (in ms)
+			*/
+			void setCost(Node node, float cost);
+
+			/// Get the nodes a node depends on
+			/**
+				@param node the node
+				@return the dependencies, in the order they were added
+			*/
+			const std::vector<Node>& dependencies(Node node) const;
+
+			/// Get the nodes in an order that respects all dependencies
+			/**
+				Independent nodes keep the order they were added in.
+				Throws if the graph has a cycle.
+
+				@return all nodes, dependencies first
+			*/
+			std::vector<Node> order() const;
+
+			/// Get the length of the longest dependency chain by estimated cost
+			/**
+				@return the critical path time (in ms)
+			*/
+			float criticalPath() const;
+
+			/// Get the length of the longest dependency chain for given run times
+			/**
+				@param times the run time of every node (in ms)
+				@return the critical path time (in ms)
+			*/
+			float criticalPath(const std::vector<float> &times) const;
+
+		private:
+			struct impl_t;
+			boost::scoped_ptr<impl_t> impl;
+	};
+
+	/// One node of a schedule, in issue order
+	struct TaskStep
+	{
+		/// The node to run
+		TaskGraph::Node node;
+
+		/// Index of the stream the node runs on
+		unsigned int stream;
+
+		/// Events the stream waits for before the node
+		std::vector<unsigned int> waits;
+
+		/// Event recorded on the stream after the node, -1 for none
+		int record;
+	};
+
+	/// Mapping of a task graph onto a number of streams
+	struct TaskSchedule
+	{
+		/// Steps in the order they are issued
+		std::vector<TaskStep> steps;
+
+		/// Number of streams the schedule uses
+		unsigned int streams;
+
+		/// Number of events the schedule records
+		unsigned int events;
+
+		/// Critical path time by estimated cost (in ms)
+		float criticalPath;
+
+		/// Estimated time until all streams are done (in ms)
+		float makespan;
+	};
+
+	/// Map a task graph onto a pool of streams
+	/**
+		Nodes are issued in dependency order. A node goes to the stream
+		where it can start earliest by estimated cost, preferring the
+		stream a dependency ran on last, so chains stay on one stream.
+		Dependencies across streams become an event record after the
+		producer and an event wait before the consumer, unless the
+		consumer's stream already waited for the producer (directly or
+		through another event), so no redundant waits are issued.
+
+		@param graph the task graph
+		@param streams the number of streams available
+		@return the schedule
+	*/
+	TaskSchedule scheduleTasks(const TaskGraph &graph, unsigned int streams);
+
+	/// Target a schedule is executed against
+	/**
+		TaskExecutor issues schedules to Cuda streams and events;
+		other implementations simulate the driver, e.g. for testing.
+	*/
+	class TaskBackend
+	{
+		public:
+			/// Destructor
+			virtual ~TaskBackend() {}
+
+			/// Enqueue a node on a stream
+			/**
+				@param graph the task graph
+				@param node the node
+				@param stream the stream index
+			*/
+			virtual void run(const TaskGraph &graph, TaskGraph::Node node, unsigned int stream) = 0;
+
+			/// Record an event on a stream
+			/**
+				@param event the event index
+				@param stream the stream index
+			*/
+			virtual void record(unsigned int event, unsigned int stream) = 0;
+
+			/// Make a stream wait for an event
+			/**
+				@param stream the stream index
+				@param event the event index
+			*/
+			virtual void wait(unsigned int stream, unsigned int event) = 0;
+	};
+
+	/// Issue a schedule to a backend
+	/**
+		@param graph the task graph
+		@param schedule a schedule of the graph
+		@param backend the backend to issue to
+	*/
+	void executeTasks(const TaskGraph &graph, const TaskSchedule &schedule, TaskBackend &backend);
+}
+
+#endif
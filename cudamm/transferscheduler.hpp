@@ -0,0 +1,156 @@
+#ifndef CUDA_TRANSFERSCHEDULER_HPP
+#define CUDA_TRANSFERSCHEDULER_HPP
+
+#include <boost/utility.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <cudamm/completion.hpp>
+
+namespace cuda
+{
+	class DevicePtr;
+	class Memcpy2D;
+	class Stream;
+
+	/// Bytes moved in one direction and the device time it took
+	struct TransferStats
+	{
+		/// Transfers completed and their bytes
+		unsigned long transfers, bytes;
+
+		/// Time from the first to the last copy of each flush, summed
+		double milliseconds;
+
+		/// Get the achieved bandwidth
+		/**
+			@return the bandwidth (in GB/s)
+		*/
+		double bandwidth() const
+		{
+			return milliseconds > 0.0 ? bytes / milliseconds * 1e-6 : 0.0;
+		}
+	};
+
+	/// Overlap of uploads and downloads on separate copy streams
+	/**
+		Devices with two copy engines copy to and from the device at
+		the same time, but only for copies on different streams, and
+		on older devices only if the copies are issued interleaved,
+		since all streams share one hardware queue. The scheduler
+		queues host-to-device and device-to-host copies, sorts them
+		into an upload and a download stream of its own and issues
+		them alternating between the directions in chunks of at most
+		chunkBytes, so neither direction waits behind a long copy of
+		the other. 2D copies are issued whole.
+
+		Kernels run on streams of the caller. uploadsBefore makes a
+		compute stream wait for the uploads flushed so far,
+		downloadsAfter makes downloads flushed afterwards wait for the
+		work on a compute stream, e.g. per pipeline step:
+
+			scheduler.upload(input, host, bytes);
+			scheduler.flush();
+			scheduler.uploadsBefore(compute);
+			launch on compute
+			scheduler.downloadsAfter(compute);
+			scheduler.download(host, output, bytes);
+			scheduler.flush();
+
+		Host memory must be page locked and stay valid until the
+		handle of its copy completes. Use from one thread with the
+		context of the scheduler current; the streams are created in
+		the context current at construction.
+
+		Noncopyable.
+	*/
+	class TransferScheduler : boost::noncopyable
+	{
+		public:
+			/// Copy direction
+			enum Direction {
+				UPLOAD,
+				DOWNLOAD };
+
+			/// Create a scheduler
+			/**
+				@param engine the engine tracking the copies
+				@param chunkBytes the largest piece of a copy issued at once, 0 to never split
+			*/
+			explicit TransferScheduler(CompletionEngine &engine, unsigned int chunkBytes = 1 << 20);
+
+			/// Wait for the issued copies, fail the queued ones
+			~TransferScheduler();
+
+			/// Queue a copy from page locked host memory to device memory
+			/**
+				@param dest the destination memory pointer
+				@param src the source memory pointer
+				@param len the number of bytes to copy
+				@return the handle, completed when the copy has completed
+			*/
+			Completion upload(const DevicePtr &dest, const void *src, unsigned int len);
+
+			/// Queue a copy from device memory to page locked host memory
+			/**
+				@param dest the destination memory pointer
+				@param src the source memory pointer
+				@param len the number of bytes to copy
+				@return the handle, completed when the copy has completed
+			*/
+			Completion download(void *dest, const DevicePtr &src, unsigned int len);
+
+			/// Queue a 2D copy between host and device
+			/**
+				An exception is thrown unless the copy has a source and a
+				destination and exactly one of them is host memory.
+
+				@param copy the copy, from or to host memory
+				@return the handle, completed when the copy has completed
+			*/
+			Completion copy(const Memcpy2D &copy);
+
+			/// Issue the queued copies
+			void flush();
+
+			/// Make a stream wait for the uploads flushed so far
+			/**
+				@param compute the stream
+			*/
+			void uploadsBefore(const Stream &compute) const;
+
+			/// Make downloads flushed from now on wait for the work issued to a stream so far
+			/**
+				@param compute the stream
+			*/
+			void downloadsAfter(const Stream &compute) const;
+
+			/// Get the stream of a direction
+			/**
+				@param direction the direction
+				@return the stream the copies of the direction are issued to
+			*/
+			const Stream& stream(Direction direction) const;
+
+			/// Get the number of queued copies
+			/**
+				@param direction the direction
+				@return the copies not flushed yet
+			*/
+			unsigned int queued(Direction direction) const;
+
+			/// Get the bandwidth of a direction
+			/**
+				Includes the flushes that have completed on the device.
+
+				@param direction the direction
+				@return the statistics so far
+			*/
+			TransferStats stats(Direction direction) const;
+
+		private:
+			struct impl_t;
+			boost::scoped_ptr<impl_t> impl;
+	};
+}
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef CUDA_WAITPOLICY_HPP
+#define CUDA_WAITPOLICY_HPP
+
+#include <boost/function.hpp>
+
+namespace cuda
+{
+	class Stream;
+
+	/// How the host waits for the device
+	/**
+		SPIN polls without pause: lowest wake-up latency, one core busy.
+		YIELD polls and yields the core between polls. BLOCKING leaves
+		the wait to the driver, which sleeps if the context (or the
+		event) was created for blocking sync. HYBRID spins for a budget
+		first and blocks after, so short waits wake fast and long waits
+		don't burn a core.
+
+		A policy can be given per call (Stream::synchronize,
+		Event::synchronize) or set as the default of a context, used by
+		the synchronize calls without policy.
+	*/
+	struct WaitPolicy
+	{
+		/// Wait strategy
+		enum Strategy {
+			SPIN,
+			YIELD,
+			BLOCKING,
+			HYBRID };
+
+		/// Create a policy
+		/**
+			@param strategy the wait strategy
+			@param spinMicroseconds the spin budget of HYBRID
+		*/
+		explicit WaitPolicy(Strategy strategy = BLOCKING, unsigned int spinMicroseconds = 50)
+			: strategy(strategy)
+			, spinMicroseconds(spinMicroseconds)
+		{
+		}
+
+		/// Get the context creation flags that match the policy
+		/**
+			@return the CU_CTX_SCHED_* flag for the strategy
+		*/
+		unsigned int contextFlags() const;
+
+		/// Set the default policy of the current context
+		/**
+			@param policy the policy used by synchronize calls without policy
+		*/
+		static void setContextDefault(const WaitPolicy &policy);
+
+		/// Remove the default policy of the current context
+		/**
+			Call before destroying a context with a default, the
+			driver may hand out its handle again.
+		*/
+		static void clearContextDefault();
+
+		/// Get the default policy of the current context
+		/**
+			@param policy set to the default policy if there is one
+			@return true if a default policy was set for the current context
+		*/
+		static bool contextDefault(WaitPolicy &policy);
+
+		Strategy strategy;
+		unsigned int spinMicroseconds;
+	};
+
+	/// Averages of measured waits
+	struct WaitMeasurement
+	{
+		/// Number of waits measured
+		unsigned int samples;
+
+		/// Time from the driver's completion callback until the wait returned
+		double wakeMicroseconds;
+
+		/// Time the wait took
+		double wallMicroseconds;
+
+		/// Processor time the waiting thread used during the wait
+		double cpuMicroseconds;
+	};
+
+	/// Measure wake-up latency and processor cost of a wait policy
+	/**
+		Issues the work, then a stream callback that stamps the time of
+		completion, and waits with the policy. Run it with work of the
+		size of interest (e.g. one small kernel) to compare strategies.
+
+		@param policy the policy to measure
+		@param stream the stream to issue to
+		@param work issues the work to wait for
+		@param samples the number of waits
+		@return the averages
+	*/
+	WaitMeasurement measureWait(const WaitPolicy &policy, const Stream &stream,
+		const boost::function<void (const Stream &)> &work, unsigned int samples = 100);
+}
+
+#endif
@@ -0,0 +1,412 @@
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <map>
+
+#define BOOST_BIND_GLOBAL_PLACEHOLDERS
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <cudamm/admissioncontroller.hpp>
+#include <cudamm/deviceptr.hpp>
+#include <cudamm/exception.hpp>
+#include <cudamm/memcpy2d.hpp>
+
+#include <detail/wait.hpp>
+
+namespace
+{
+	cuda::Completion upload(cuda::CompletionEngine *engine, const cuda::DevicePtr &dest, const void *src,
+		unsigned int len, const cuda::Stream *stream)
+	{
+		return engine->copy(dest, src, len, *stream);
+	}
+
+	cuda::Completion download(cuda::CompletionEngine *engine, void *dest, const cuda::DevicePtr &src,
+		unsigned int len, const cuda::Stream *stream)
+	{
+		return engine->copy(dest, src, len, *stream);
+	}
+
+	cuda::Completion copy2D(cuda::CompletionEngine *engine, const cuda::Memcpy2D &copy, const cuda::Stream *stream)
+	{
+		return engine->copy(copy, *stream);
+	}
+
+	/// Complete a deferred transfer with the outcome of the issued one
+	void completeDeferred(const cuda::Completion &issued, const cuda::CompletionSource &source)
+	{
+		try
+		{
+			issued.wait();
+			source.complete();
+		} catch(std::exception const &e)
+		{
+			source.fail(e.what());
+		}
+	}
+}
+
+namespace cuda
+{
+	struct AdmissionController::impl_t
+	{
+		typedef boost::function<Completion ()> issue_t;
+
+		struct deferred_t
+		{
+			issue_t issue;
+			unsigned long bytes;
+			CompletionSource source;
+		};
+
+		impl_t(unsigned long high, CompletionEngine &engine, Policy policy)
+			: engine(engine)
+			, policy(policy)
+			, high(high)
+			, low(high)
+			, held(0)
+			, inFlight(0)
+			, allocated(0)
+			, throttled(false)
+		{
+			stats = AdmissionStats();
+		}
+
+		/// Query if a submission is admitted now, must hold the mutex
+		bool fits(unsigned long bytes);
+
+		/// Wait for budget to be released, must hold the mutex
+		void waitForRelease(boost::mutex::scoped_lock &lock);
+
+		/// Admit by the policy and take budget, blocking or throwing, must hold the mutex
+		void admit(boost::mutex::scoped_lock &lock, unsigned long bytes, const char *rejected);
+
+		/// Return the budget of a completed transfer
+		void release(unsigned long bytes);
+
+		/// Issue an admitted transfer and track it, must not hold the mutex
+		Completion issue(const issue_t &issue, unsigned long bytes);
+
+		/// Admit a transfer by the policy
+		Completion submit(const issue_t &issue, unsigned long bytes);
+
+		/// Issue the deferred transfers that fit, must not hold the mutex
+		unsigned int issueDeferredTransfers();
+
+		CompletionEngine &engine;
+		Policy policy;
+
+		mutable boost::mutex mutex;
+		boost::condition_variable released;
+
+		unsigned long high, low;
+		unsigned long held, inFlight, allocated;
+		bool throttled;
+
+		// Transfers in flight, oldest first
+		std::deque<Completion> transfers;
+
+		std::deque<deferred_t> waiting;
+
+		// Allocation sizes by device address
+		std::map<unsigned long, unsigned int> allocations;
+
+		AdmissionStats stats;
+	};
+
+	bool AdmissionController::impl_t::fits(unsigned long bytes)
+	{
+		if(throttled && held > low) return false;
+		throttled = false;
+
+		if(!held || held + bytes <= high) return true;
+		throttled = true;
+		return false;
+	}
+
+	void AdmissionController::impl_t::waitForRelease(boost::mutex::scoped_lock &lock)
+	{
+		while(!transfers.empty() && transfers.front().ready()) transfers.pop_front();
+
+		if(transfers.empty())
+		{
+			// Only frees can release budget
+			released.wait(lock);
+			return;
+		}
+
+		// Waiting on the handle drives a foreground engine
+		const Completion oldest = transfers.front();
+		lock.unlock();
+		try
+		{
+			oldest.wait();
+		} catch(Exception const &)
+		{
+			// The submitter of the transfer gets the error
+		}
+		lock.lock();
+	}
+
+	void AdmissionController::impl_t::admit(boost::mutex::scoped_lock &lock, unsigned long bytes, const char *rejected)
+	{
+		if(!fits(bytes))
+		{
+			if(policy == REJECT)
+			{
+				++stats.rejected;
+				throw Exception(rejected);
+			}
+
+			++stats.blocked;
+			const double start = detail::now();
+			while(!fits(bytes)) waitForRelease(lock);
+			stats.blockedMicroseconds += detail::now() - start;
+		} else
+		{
+			++stats.admitted;
+		}
+
+		held += bytes;
+		stats.peakBytes = std::max(stats.peakBytes, held);
+	}
+
+	void AdmissionController::impl_t::release(unsigned long bytes)
+	{
+		// Notified under the mutex, the destructor may destroy the controller once inFlight drops to 0
+		boost::mutex::scoped_lock lock(mutex);
+		held -= bytes;
+		inFlight -= bytes;
+		released.notify_all();
+	}
+
+	Completion AdmissionController::impl_t::issue(const issue_t &issue, unsigned long bytes)
+	{
+		Completion completion;
+		try
+		{
+			completion = issue();
+		} catch(...)
+		{
+			release(bytes);
+			throw;
+		}
+
+		{
+			boost::mutex::scoped_lock lock(mutex);
+			while(!transfers.empty() && transfers.front().ready()) transfers.pop_front();
+			transfers.push_back(completion);
+		}
+
+		// Runs at once if the transfer has already completed, so not under the mutex
+		completion.then(boost::bind(&impl_t::release, this, bytes));
+		return completion;
+	}
+
+	Completion AdmissionController::impl_t::submit(const issue_t &issue, unsigned long bytes)
+	{
+		{
+			boost::mutex::scoped_lock lock(mutex);
+
+			// Deferred transfers go first, later ones queue behind them
+			if(policy == DEFER && (!waiting.empty() || !fits(bytes)))
+			{
+				deferred_t deferred;
+				deferred.issue = issue;
+				deferred.bytes = bytes;
+				waiting.push_back(deferred);
+				++stats.deferred;
+
+				lock.unlock();
+				issueDeferredTransfers();
+				return deferred.source.completion();
+			}
+
+			admit(lock, bytes, "Transfer rejected, admission budget exhausted");
+			inFlight += bytes;
+		}
+
+		return this->issue(issue, bytes);
+	}
+
+	unsigned int AdmissionController::impl_t::issueDeferredTransfers()
+	{
+		unsigned int issued = 0;
+		for(;;)
+		{
+			deferred_t deferred;
+			{
+				boost::mutex::scoped_lock lock(mutex);
+				if(waiting.empty() || !fits(waiting.front().bytes)) break;
+
+				deferred = waiting.front();
+				waiting.pop_front();
+				held += deferred.bytes;
+				stats.peakBytes = std::max(stats.peakBytes, held);
+				inFlight += deferred.bytes;
+			}
+
+			try
+			{
+				const Completion completion = issue(deferred.issue, deferred.bytes);
+				completion.then(boost::bind(completeDeferred, completion, deferred.source));
+			} catch(std::exception const &e)
+			{
+				deferred.source.fail(e.what());
+			}
+			++issued;
+		}
+
+		return issued;
+	}
+
+	AdmissionController::AdmissionController(unsigned long highWatermark, CompletionEngine &engine, Policy policy)
+		: impl(new impl_t(highWatermark, engine, policy))
+	{
+	}
+
+	AdmissionController::~AdmissionController()
+	{
+		std::deque<Completion> transfers;
+		std::deque<impl_t::deferred_t> waiting;
+		{
+			boost::mutex::scoped_lock lock(impl->mutex);
+			transfers.swap(impl->transfers);
+			waiting.swap(impl->waiting);
+		}
+
+		for(std::deque<impl_t::deferred_t>::iterator it = waiting.begin(); it != waiting.end(); ++it)
+		{
+			it->source.fail("Admission controller destroyed before issuing the transfer");
+		}
+
+		// Waiting on the handles drives a foreground engine
+		for(std::deque<Completion>::iterator it = transfers.begin(); it != transfers.end(); ++it)
+		{
+			try
+			{
+				it->wait();
+			} catch(Exception const &)
+			{
+			}
+		}
+
+		// Release callbacks refer to the controller and run after their handle is done,
+		// also for transfers already dropped from the list as ready
+		boost::mutex::scoped_lock lock(impl->mutex);
+		while(impl->inFlight) impl->released.wait(lock);
+	}
+
+	AdmissionController& AdmissionController::setWatermarks(unsigned long high, unsigned long low)
+	{
+		if(low > high) throw Exception("Low watermark above high watermark");
+
+		{
+			boost::mutex::scoped_lock lock(impl->mutex);
+			impl->high = high;
+			impl->low = low;
+		}
+		impl->released.notify_all();
+		return *this;
+	}
+
+	AdmissionController& AdmissionController::setPolicy(Policy policy)
+	{
+		boost::mutex::scoped_lock lock(impl->mutex);
+		impl->policy = policy;
+		return *this;
+	}
+
+	Completion AdmissionController::copy(const DevicePtr &dest, const void *src, unsigned int len, const Stream &stream)
+	{
+		return impl->submit(boost::bind(upload, &impl->engine, dest, src, len, &stream), len);
+	}
+
+	Completion AdmissionController::copy(void *dest, const DevicePtr &src, unsigned int len, const Stream &stream)
+	{
+		return impl->submit(boost::bind(download, &impl->engine, dest, src, len, &stream), len);
+	}
+
+	Completion AdmissionController::copy(const Memcpy2D &copy, const Stream &stream)
+	{
+		return impl->submit(boost::bind(copy2D, &impl->engine, copy, &stream), copy.bytes());
+	}
+
+	DevicePtr AdmissionController::malloc(unsigned int size)
+	{
+		{
+			boost::mutex::scoped_lock lock(impl->mutex);
+			impl->admit(lock, size, "Allocation rejected, admission budget exhausted");
+			impl->allocated += size;
+		}
+
+		DevicePtr ptr;
+		try
+		{
+			ptr = cuda::malloc(size);
+		} catch(...)
+		{
+			boost::mutex::scoped_lock lock(impl->mutex);
+			impl->held -= size;
+			impl->allocated -= size;
+			throw;
+		}
+
+		boost::mutex::scoped_lock lock(impl->mutex);
+		impl->allocations[ptr.pingpang()] = size;
+		return ptr;
+	}
+
+	void AdmissionController::free(const DevicePtr &ptr)
+	{
+		unsigned int size;
+		{
+			boost::mutex::scoped_lock lock(impl->mutex);
+			std::map<unsigned long, unsigned int>::iterator it = impl->allocations.find(ptr.pingpang());
+			if(it == impl->allocations.end()) throw Exception("Device memory not allocated by the admission controller");
+			size = it->second;
+			impl->allocations.erase(it);
+		}
+
+		cuda::free(ptr);
+
+		{
+			boost::mutex::scoped_lock lock(impl->mutex);
+			impl->held -= size;
+			impl->allocated -= size;
+		}
+		impl->released.notify_all();
+	}
+
+	unsigned int AdmissionController::issueDeferred()
+	{
+		return impl->issueDeferredTransfers();
+	}
+
+	unsigned long AdmissionController::inFlightBytes() const
+	{
+		boost::mutex::scoped_lock lock(impl->mutex);
+		return impl->inFlight;
+	}
+
+	unsigned long AdmissionController::allocatedBytes() const
+	{
+		boost::mutex::scoped_lock lock(impl->mutex);
+		return impl->allocated;
+	}
+
+	unsigned int AdmissionController::deferred() const
+	{
+		boost::mutex::scoped_lock lock(impl->mutex);
+		return impl->waiting.size();
+	}
+
+	AdmissionStats AdmissionController::stats() const
+	{
+		boost::mutex::scoped_lock lock(impl->mutex);
+		return impl->stats;
+	}
+}
@@ -9,6 +9,7 @@
 
 #include <detail/error.hpp>
 #include <detail/array_impl.hpp>
+#include <detail/context.hpp>
 #include <detail/stream_impl.hpp>
 #include <detail/deviceptr_impl.hpp>
 
@@ -106,6 +107,7 @@ namespace cuda
 		
 		detail::error_check(cuArrayCreate(&impl->array, &desc),
 			"Can't create Cuda array");
+		impl->context = detail::current_context();
 	}
 	
 	Array::~Array()
@@ -116,42 +118,54 @@ namespace cuda
 	
 	void memcpy(const Array& dest, unsigned int destIndex, const Array &src, unsigned int srcIndex, unsigned int len)
 	{
+		detail::context_check(dest.impl->context, "Can't memcpy from device array to device array");
+		detail::context_check(src.impl->context, "Can't memcpy from device array to device array");
 		detail::error_check(cuMemcpyAtoA(dest.impl->array, destIndex, src.impl->array, srcIndex, len),
 			"Can't memcpy from device array to device array");
 	}
 	
 	void memcpy(const Array &dest, unsigned int destIndex, const DevicePtr &src, unsigned int len)
 	{
+		detail::context_check(dest.impl->context, "Can't memcpy from device memory to device array");
+		detail::context_check(src.impl->context, "Can't memcpy from device memory to device array");
 		detail::error_check(cuMemcpyDtoA(dest.impl->array, destIndex, src.impl->devicePtr, len),
 			"Can't memcpy from device memory to device array");
 	}
 	
 	void memcpy(const DevicePtr &dest, const Array &src, unsigned int srcIndex, unsigned int len)
 	{
+		detail::context_check(dest.impl->context, "Can't memcpy from device array to device memory");
+		detail::context_check(src.impl->context, "Can't memcpy from device array to device memory");
 		detail::error_check(cuMemcpyAtoD(dest.impl->devicePtr, src.impl->array, srcIndex, len),
 			"Can't memcpy from device array to device memory");
 	}
 	
 	void memcpy(void *dest, const Array &src, unsigned int srcIndex, unsigned int len)
 	{
+		detail::context_check(src.impl->context, "Can't memcpy from device array to host memory");
 		detail::error_check(cuMemcpyAtoH(dest, src.impl->array, srcIndex, len),
 			"Can't memcpy from device array to host memory");
 	}
 	
 	void memcpy(const Array& dest, unsigned int destIndex, const void *src, unsigned int len)
 	{
+		detail::context_check(dest.impl->context, "Can't memcpy from host memory to device array");
 		detail::error_check(cuMemcpyHtoA(dest.impl->array, destIndex, src, len),
 			"Can't memcpy from host memory to device array");
 	}
 
 	void memcpy(void *dest, const Array &src, unsigned int srcIndex, unsigned int len, const Stream &stream)
 	{
+		detail::context_check(src.impl->context, "Can't memcpy from device array to host memory asynchronously");
+		detail::context_check(stream.impl->context, "Can't memcpy from device array to host memory asynchronously");
 		detail::error_check(cuMemcpyAtoHAsync(dest, src.impl->array, srcIndex, len, stream.impl->stream),
 			"Can't memcpy from device array to host memory asynchronously");
 	}
 	
 	void memcpy(const Array& dest, unsigned int destIndex, const void *src, unsigned int len, const Stream &stream)
 	{
+		detail::context_check(dest.impl->context, "Can't memcpy from host memory to device array asynchronously");
+		detail::context_check(stream.impl->context, "Can't memcpy from host memory to device array asynchronously");
 		detail::error_check(cuMemcpyHtoAAsync(dest.impl->array, destIndex, src, len, stream.impl->stream),
 			"Can't memcpy from host memory to device array asynchronously");
 	}
@@ -0,0 +1,240 @@
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include <boost/tuple/tuple.hpp>
+#include <boost/tuple/tuple_comparison.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <cuda.h>
+
+#include <cudamm/exception.hpp>
+#include <cudamm/event.hpp>
+#include <cudamm/function.hpp>
+#include <cudamm/stream.hpp>
+#include <cudamm/autotuner.hpp>
+
+#include <detail/error.hpp>
+#include <detail/file.hpp>
+
+namespace cuda
+{
+	struct TuningDatabase::impl_t
+	{
+		typedef boost::tuple<std::string, std::string, std::string, unsigned int> key_t;
+
+		struct entry_t
+		{
+			LaunchConfig config;
+			float milliseconds;
+		};
+
+		typedef std::map<key_t, entry_t> map_t;
+
+		/// Read the entries of a database file, missing files have none
+		static void read(const std::string &filename, map_t &entries);
+
+		std::string filename;
+		mutable boost::mutex mutex;
+		map_t entries;
+	};
+
+	void TuningDatabase::impl_t::read(const std::string &filename, map_t &entries)
+	{
+		// Line format: module <tab> kernel <tab> device <tab> bucket blockX blockY blockZ shared gridX gridY milliseconds
+		std::ifstream file(filename.c_str());
+		std::string line;
+		while(std::getline(file, line))
+		{
+			std::string::size_type tabs[3];
+			std::string::size_type start = 0;
+			for(unsigned int i = 0; i < 3; ++i)
+			{
+				tabs[i] = start == std::string::npos ? start : line.find('\t', start);
+				start = tabs[i] == std::string::npos ? tabs[i] : tabs[i] + 1;
+			}
+			if(tabs[2] == std::string::npos) continue;
+
+			unsigned int bucket;
+			entry_t entry;
+			std::istringstream values(line.substr(tabs[2] + 1));
+			values >> bucket >> entry.config.blockX >> entry.config.blockY >> entry.config.blockZ
+				>> entry.config.sharedBytes >> entry.config.gridX >> entry.config.gridY >> entry.milliseconds;
+			if(!values) continue;
+
+			entries[key_t(line.substr(0, tabs[0]), line.substr(tabs[0] + 1, tabs[1] - tabs[0] - 1),
+				line.substr(tabs[1] + 1, tabs[2] - tabs[1] - 1), bucket)] = entry;
+		}
+	}
+
+	TuningDatabase::TuningDatabase(const char *filename)
+		: impl(new impl_t)
+	{
+		impl->filename = filename;
+		impl_t::read(impl->filename, impl->entries);
+	}
+
+	TuningDatabase::~TuningDatabase()
+	{
+	}
+
+	bool TuningDatabase::lookup(const std::string &module, const std::string &kernel, const std::string &device,
+		unsigned int bucket, LaunchConfig &config) const
+	{
+		boost::mutex::scoped_lock lock(impl->mutex);
+
+		impl_t::map_t::const_iterator it = impl->entries.find(impl_t::key_t(module, kernel, device, bucket));
+		if(it == impl->entries.end()) return false;
+		config = it->second.config;
+		return true;
+	}
+
+	void TuningDatabase::store(const std::string &module, const std::string &kernel, const std::string &device,
+		unsigned int bucket, const LaunchConfig &config, float milliseconds)
+	{
+		boost::mutex::scoped_lock lock(impl->mutex);
+
+		impl_t::entry_t &entry = impl->entries[impl_t::key_t(module, kernel, device, bucket)];
+		entry.config = config;
+		entry.milliseconds = milliseconds;
+	}
+
+	void TuningDatabase::save() const
+	{
+		boost::mutex::scoped_lock lock(impl->mutex);
+
+		// Keep what other processes saved since the file was read, our entries win
+		impl_t::map_t entries;
+		impl_t::read(impl->filename, entries);
+		for(impl_t::map_t::const_iterator it = impl->entries.begin(); it != impl->entries.end(); ++it)
+		{
+			entries[it->first] = it->second;
+		}
+
+		std::ostringstream file;
+		for(impl_t::map_t::const_iterator it = entries.begin(); it != entries.end(); ++it)
+		{
+			const LaunchConfig &config = it->second.config;
+			file << it->first.get<0>() << '\t' << it->first.get<1>() << '\t' << it->first.get<2>()
+				<< '\t' << it->first.get<3>()
+				<< ' ' << config.blockX << ' ' << config.blockY << ' ' << config.blockZ
+				<< ' ' << config.sharedBytes << ' ' << config.gridX << ' ' << config.gridY
+				<< ' ' << it->second.milliseconds << '\n';
+		}
+
+		const std::string contents = file.str();
+		if(!detail::replace_file(impl->filename, contents.data(), contents.size()))
+		{
+			throw Exception(("Can't write tuning database " + impl->filename).c_str());
+		}
+	}
+
+	unsigned int TuningDatabase::bucket(unsigned long problemSize)
+	{
+		unsigned int log = 0;
+		while(problemSize >>= 1) ++log;
+		return log;
+	}
+
+	std::string TuningDatabase::currentDevice()
+	{
+		CUdevice dev;
+		detail::error_check(cuCtxGetDevice(&dev), "Can't get current Cuda device");
+
+		char name[256];
+		int major, minor;
+		detail::error_check(cuDeviceGetName(name, sizeof(name), dev), "Can't get Cuda device name");
+		detail::error_check(cuDeviceComputeCapability(&major, &minor, dev),
+			"Can't get Cuda device compute capability");
+
+		std::ostringstream str;
+		str << name << " (sm_" << major << minor << ")";
+		return str.str();
+	}
+
+	Autotuner::Autotuner(TuningDatabase &database, unsigned int iterations)
+		: database(database)
+		, iterations(iterations ? iterations : 1)
+	{
+	}
+
+	LaunchConfig Autotuner::configure(const Function &function, unsigned int width, unsigned int height,
+		const Stream &stream, const launcher_t &launch,
+		unsigned int sharedPerThread, unsigned int sharedPerBlock)
+	{
+		LaunchConfig config;
+		const unsigned int bucket = TuningDatabase::bucket(static_cast<unsigned long>(width) * height);
+		if(database.lookup(function.moduleHash(), function.name(), TuningDatabase::currentDevice(), bucket, config))
+		{
+			// The grid is stored for the bucket, recompute it for this problem
+			config.gridX = (width + config.blockX - 1) / config.blockX;
+			config.gridY = (height + config.blockY - 1) / config.blockY;
+
+			function.setBlockShape(config.blockX, config.blockY, config.blockZ);
+			function.setSharedSize(config.sharedBytes);
+			return config;
+		}
+
+		const std::vector<LaunchConfig> candidates = feasibleLaunches(DeviceLimits::current(),
+			KernelResources(function), width, height, sharedPerThread, sharedPerBlock);
+		config = tune(function, width, height, stream, launch, candidates);
+		database.save();
+		return config;
+	}
+
+	LaunchConfig Autotuner::tune(const Function &function, unsigned int width, unsigned int height,
+		const Stream &stream, const launcher_t &launch,
+		const std::vector<LaunchConfig> &candidates)
+	{
+		Event start, end;
+
+		// Keep other threads from reconfiguring the function between the timed launches
+		Function::ScopedLock lock(function);
+
+		LaunchConfig best;
+		float bestTime = 0.0f;
+		bool found = false;
+		std::string failures;
+
+		for(std::vector<LaunchConfig>::const_iterator config = candidates.begin(); config != candidates.end(); ++config)
+		{
+			try
+			{
+				function.setBlockShape(config->blockX, config->blockY, config->blockZ);
+				function.setSharedSize(config->sharedBytes);
+
+				// One untimed launch to warm up caches and catch launch failures
+				launch(*config, stream);
+				stream.synchronize();
+
+				start.record(stream);
+				for(unsigned int i = 0; i < iterations; ++i) launch(*config, stream);
+				end.record(stream);
+				end.synchronize();
+
+				const float time = (end - start) / iterations;
+				if(!found || time < bestTime)
+				{
+					best = *config;
+					bestTime = time;
+					found = true;
+				}
+			} catch(cuda::Exception const &e)
+			{
+				std::ostringstream failure;
+				failure << "; " << config->blockX << "x" << config->blockY << "x" << config->blockZ << ": " << e.what();
+				failures += failure.str();
+			}
+		}
+
+		if(!found) throw Exception(("No launch configuration could be tuned" + failures).c_str());
+
+		function.setBlockShape(best.blockX, best.blockY, best.blockZ);
+		function.setSharedSize(best.sharedBytes);
+
+		database.store(function.moduleHash(), function.name(), TuningDatabase::currentDevice(),
+			TuningDatabase::bucket(static_cast<unsigned long>(width) * height), best, bestTime);
+		return best;
+	}
+}
@@ -0,0 +1,331 @@
+#include <utility>
+#include <vector>
+
+#include <cuda.h>
+
+#include <cudamm/exception.hpp>
+#include <cudamm/deviceptr.hpp>
+#include <cudamm/event.hpp>
+#include <cudamm/launchrecord.hpp>
+#include <cudamm/memcpy2d.hpp>
+#include <cudamm/stream.hpp>
+#include <cudamm/commandbatch.hpp>
+
+#include <detail/error.hpp>
+#include <detail/deviceptr_impl.hpp>
+#include <detail/event_impl.hpp>
+#include <detail/memcpy2d_impl.hpp>
+#include <detail/stream_impl.hpp>
+
+namespace cuda
+{
+	const CommandBatch::Buffer CommandBatch::fixed;
+
+	struct CommandBatch::impl_t
+	{
+		struct buffer_t
+		{
+			bool device;
+			unsigned int bytes;
+			bool bound;
+			CUdeviceptr devicePtr;
+			void *host;
+		};
+
+		enum kind_t { HOST_TO_DEVICE, DEVICE_TO_HOST, DEVICE_TO_DEVICE, COPY_2D, LAUNCH, RECORD };
+
+		struct op_t
+		{
+			kind_t kind;
+			Buffer dest, src;
+			unsigned int destOffset, srcOffset, len;
+
+			// Index into copies, launches or events
+			unsigned int index;
+		};
+
+		struct launch_t
+		{
+			explicit launch_t(const LaunchRecord &record)
+				: record(record)
+			{
+			}
+
+			LaunchRecord record;
+			std::vector<std::pair<Buffer, unsigned int> > arguments;
+		};
+
+		impl_t()
+			: validated(false)
+		{
+		}
+
+		buffer_t& buffer(Buffer index)
+		{
+			if(index >= buffers.size()) throw Exception("Unknown command batch buffer");
+			return buffers[index];
+		}
+
+		void checkRange(Buffer index, unsigned int offset, unsigned int len)
+		{
+			const buffer_t &b = buffer(index);
+			if(offset > b.bytes || len > b.bytes - offset) throw Exception("Command batch copy outside of buffer");
+		}
+
+		/// Throw unless the batch can be submitted, changes nothing
+		void check() const;
+
+		std::vector<buffer_t> buffers;
+		std::vector<op_t> ops;
+		std::vector<CUDA_MEMCPY2D_st> copies;
+		std::vector<launch_t> launches;
+		std::vector<CUevent> events;
+
+		bool validated;
+	};
+
+	void CommandBatch::impl_t::check() const
+	{
+		for(std::vector<buffer_t>::const_iterator it = buffers.begin(); it != buffers.end(); ++it)
+		{
+			if(!it->bound) throw Exception("Command batch buffer not bound");
+		}
+
+		for(std::vector<launch_t>::const_iterator it = launches.begin(); it != launches.end(); ++it)
+		{
+			if(!it->arguments.empty() && it->arguments.size() * sizeof(int) != it->record.dynamicSize())
+			{
+				throw Exception("Command batch launch arguments don't match dynamic parameters");
+			}
+		}
+	}
+
+	CommandBatch::CommandBatch()
+		: impl(new impl_t)
+	{
+	}
+
+	CommandBatch::~CommandBatch()
+	{
+	}
+
+	CommandBatch::Buffer CommandBatch::deviceBuffer(unsigned int bytes)
+	{
+		impl_t::buffer_t buffer = { true, bytes, false, 0, 0 };
+		impl->buffers.push_back(buffer);
+		impl->validated = false;
+		return impl->buffers.size() - 1;
+	}
+
+	CommandBatch::Buffer CommandBatch::hostBuffer(unsigned int bytes)
+	{
+		impl_t::buffer_t buffer = { false, bytes, false, 0, 0 };
+		impl->buffers.push_back(buffer);
+		impl->validated = false;
+		return impl->buffers.size() - 1;
+	}
+
+	void CommandBatch::bind(Buffer buffer, const DevicePtr &ptr)
+	{
+		impl_t::buffer_t &b = impl->buffer(buffer);
+		if(!b.device) throw Exception("Can't bind device memory to host buffer");
+		b.devicePtr = ptr.impl->devicePtr;
+		b.bound = true;
+	}
+
+	void CommandBatch::bind(Buffer buffer, void *ptr)
+	{
+		impl_t::buffer_t &b = impl->buffer(buffer);
+		if(b.device) throw Exception("Can't bind host memory to device buffer");
+		if(!ptr) throw Exception("Can't bind null host memory");
+		b.host = ptr;
+		b.bound = true;
+	}
+
+	CommandBatch& CommandBatch::copy(Buffer dest, unsigned int destOffset, Buffer src, unsigned int srcOffset, unsigned int len)
+	{
+		impl->checkRange(dest, destOffset, len);
+		impl->checkRange(src, srcOffset, len);
+
+		const bool destDevice = impl->buffers[dest].device;
+		const bool srcDevice = impl->buffers[src].device;
+		if(!destDevice && !srcDevice) throw Exception("Command batch can't copy from host to host memory");
+
+		impl_t::op_t op;
+		op.kind = srcDevice ? (destDevice ? impl_t::DEVICE_TO_DEVICE : impl_t::DEVICE_TO_HOST) : impl_t::HOST_TO_DEVICE;
+		op.dest = dest;
+		op.src = src;
+		op.destOffset = destOffset;
+		op.srcOffset = srcOffset;
+		op.len = len;
+		op.index = 0;
+		impl->ops.push_back(op);
+		impl->validated = false;
+		return *this;
+	}
+
+	CommandBatch& CommandBatch::copy(Buffer dest, Buffer src, unsigned int len)
+	{
+		return copy(dest, 0, src, 0, len);
+	}
+
+	CommandBatch& CommandBatch::copy(const Memcpy2D &descriptor, Buffer dest, Buffer src)
+	{
+		const CUDA_MEMCPY2D_st &memcpy2d = descriptor.impl->memcpy2d;
+		const unsigned int width = memcpy2d.WidthInBytes, height = memcpy2d.Height;
+
+		// Last byte touched is on the last row at position + width
+		if(dest != fixed && height)
+		{
+			if(height > 1 && memcpy2d.dstPitch < width) throw Exception("Command batch 2D copy destination pitch below width");
+			impl->checkRange(dest, (memcpy2d.dstY + height - 1) * memcpy2d.dstPitch + memcpy2d.dstXInBytes, width);
+		}
+		if(src != fixed && height)
+		{
+			if(height > 1 && memcpy2d.srcPitch < width) throw Exception("Command batch 2D copy source pitch below width");
+			impl->checkRange(src, (memcpy2d.srcY + height - 1) * memcpy2d.srcPitch + memcpy2d.srcXInBytes, width);
+		}
+
+		impl_t::op_t op;
+		op.kind = impl_t::COPY_2D;
+		op.dest = dest;
+		op.src = src;
+		op.destOffset = op.srcOffset = op.len = 0;
+		op.index = impl->copies.size();
+		impl->copies.push_back(memcpy2d);
+		impl->ops.push_back(op);
+		impl->validated = false;
+		return *this;
+	}
+
+	CommandBatch& CommandBatch::launch(const LaunchRecord &record)
+	{
+		impl_t::op_t op;
+		op.kind = impl_t::LAUNCH;
+		op.dest = op.src = fixed;
+		op.destOffset = op.srcOffset = op.len = 0;
+		op.index = impl->launches.size();
+		impl->launches.push_back(impl_t::launch_t(record));
+		impl->ops.push_back(op);
+		impl->validated = false;
+		return *this;
+	}
+
+	CommandBatch& CommandBatch::argument(Buffer buffer, unsigned int offset)
+	{
+		if(impl->ops.empty() || impl->ops.back().kind != impl_t::LAUNCH)
+		{
+			throw Exception("Command batch argument without launch");
+		}
+		if(!impl->buffer(buffer).device) throw Exception("Command batch launch argument must be a device buffer");
+		if(offset > impl->buffers[buffer].bytes) throw Exception("Command batch launch argument outside of buffer");
+
+		impl->launches.back().arguments.push_back(std::make_pair(buffer, offset));
+		impl->validated = false;
+		return *this;
+	}
+
+	CommandBatch& CommandBatch::record(const Event &event)
+	{
+		impl_t::op_t op;
+		op.kind = impl_t::RECORD;
+		op.dest = op.src = fixed;
+		op.destOffset = op.srcOffset = op.len = 0;
+		op.index = impl->events.size();
+		impl->events.push_back(event.impl->event);
+		impl->ops.push_back(op);
+		impl->validated = false;
+		return *this;
+	}
+
+	void CommandBatch::validate() const
+	{
+		impl->check();
+		impl->validated = true;
+	}
+
+	void CommandBatch::submit(const Stream &stream) const
+	{
+		// Only reads the batch, so it may be submitted from several threads at once
+		if(!impl->validated) impl->check();
+
+		const CUstream s = stream.impl->stream;
+		const std::vector<impl_t::buffer_t> &buffers = impl->buffers;
+		std::vector<int> arguments;
+
+		for(std::vector<impl_t::op_t>::const_iterator op = impl->ops.begin(); op != impl->ops.end(); ++op)
+		{
+			switch(op->kind)
+			{
+				case impl_t::HOST_TO_DEVICE:
+					detail::error_check(cuMemcpyHtoDAsync(buffers[op->dest].devicePtr + op->destOffset,
+						static_cast<const char *>(buffers[op->src].host) + op->srcOffset, op->len, s),
+						"Can't memcpy from host memory to device memory asynchronously");
+					break;
+
+				case impl_t::DEVICE_TO_HOST:
+					detail::error_check(cuMemcpyDtoHAsync(static_cast<char *>(buffers[op->dest].host) + op->destOffset,
+						buffers[op->src].devicePtr + op->srcOffset, op->len, s),
+						"Can't memcpy from device memory to host memory asynchronously");
+					break;
+
+				case impl_t::DEVICE_TO_DEVICE:
+					detail::error_check(cuMemcpyDtoDAsync(buffers[op->dest].devicePtr + op->destOffset,
+						buffers[op->src].devicePtr + op->srcOffset, op->len, s),
+						"Can't memcpy from device memory to device memory asynchronously");
+					break;
+
+				case impl_t::COPY_2D:
+				{
+					CUDA_MEMCPY2D_st memcpy2d = impl->copies[op->index];
+					if(op->dest != fixed)
+					{
+						const impl_t::buffer_t &b = buffers[op->dest];
+						memcpy2d.dstMemoryType = b.device ? CU_MEMORYTYPE_DEVICE : CU_MEMORYTYPE_HOST;
+						memcpy2d.dstDevice = b.devicePtr;
+						memcpy2d.dstHost = b.host;
+					}
+					if(op->src != fixed)
+					{
+						const impl_t::buffer_t &b = buffers[op->src];
+						memcpy2d.srcMemoryType = b.device ? CU_MEMORYTYPE_DEVICE : CU_MEMORYTYPE_HOST;
+						memcpy2d.srcDevice = b.devicePtr;
+						memcpy2d.srcHost = b.host;
+					}
+					detail::error_check(cuMemcpy2DAsync(&memcpy2d, s),
+						"Can't execute Cuda 2D memcpy asynchronously");
+					break;
+				}
+
+				case impl_t::LAUNCH:
+				{
+					const impl_t::launch_t &launch = impl->launches[op->index];
+					if(launch.arguments.empty())
+					{
+						launch.record.replay(stream);
+						break;
+					}
+
+					arguments.resize(launch.arguments.size());
+					for(std::vector<int>::size_type i = 0; i < launch.arguments.size(); ++i)
+					{
+						const std::pair<Buffer, unsigned int> &argument = launch.arguments[i];
+						arguments[i] = static_cast<int>(buffers[argument.first].devicePtr + argument.second);
+					}
+					launch.record.replay(stream, &arguments[0]);
+					break;
+				}
+
+				case impl_t::RECORD:
+					detail::error_check(cuEventRecord(impl->events[op->index], s),
+						"Can't record Cuda stream event");
+					break;
+			}
+		}
+	}
+
+	unsigned int CommandBatch::size() const
+	{
+		return impl->ops.size();
+	}
+}
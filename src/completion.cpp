@@ -0,0 +1,122 @@
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/thread/thread.hpp>
+
+#include <cudamm/exception.hpp>
+#include <cudamm/completion.hpp>
+
+#include <detail/completion_impl.hpp>
+
+namespace
+{
+	/// Run callbacks without letting exceptions escape into the completing thread
+	void runCallbacks(const std::vector<boost::function<void ()> > &callbacks)
+	{
+		for(std::vector<boost::function<void ()> >::const_iterator it = callbacks.begin(); it != callbacks.end(); ++it)
+		{
+			try
+			{
+				(*it)();
+			} catch(std::exception const &e)
+			{
+				std::cerr << "Completion callback failed: " << e.what() << std::endl;
+			}
+		}
+	}
+}
+
+namespace cuda
+{
+	void Completion::impl_t::complete(const std::string &failure)
+	{
+		std::vector<boost::function<void ()> > run;
+		{
+			boost::mutex::scoped_lock lock(mutex);
+			done = true;
+			error = failure;
+			run.swap(callbacks);
+		}
+		condition.notify_all();
+		runCallbacks(run);
+	}
+
+	Completion::Completion()
+		: impl(new impl_t)
+	{
+		impl->done = true;
+	}
+
+	bool Completion::ready() const
+	{
+		boost::mutex::scoped_lock lock(impl->mutex);
+		return impl->done;
+	}
+
+	void Completion::wait() const
+	{
+		if(impl->poll)
+		{
+			while(!ready())
+			{
+				if(!impl->poll()) boost::this_thread::yield();
+			}
+		}
+
+		boost::mutex::scoped_lock lock(impl->mutex);
+		while(!impl->done) impl->condition.wait(lock);
+		if(!impl->error.empty()) throw Exception(impl->error.c_str());
+	}
+
+	bool Completion::wait(unsigned int milliseconds) const
+	{
+		const boost::system_time deadline = boost::get_system_time() + boost::posix_time::milliseconds(milliseconds);
+
+		if(impl->poll)
+		{
+			while(!ready() && boost::get_system_time() < deadline)
+			{
+				if(!impl->poll()) boost::this_thread::yield();
+			}
+		}
+
+		boost::mutex::scoped_lock lock(impl->mutex);
+		while(!impl->done)
+		{
+			if(!impl->condition.timed_wait(lock, deadline)) return impl->done;
+		}
+		if(!impl->error.empty()) throw Exception(impl->error.c_str());
+		return true;
+	}
+
+	void Completion::then(const boost::function<void ()> &callback) const
+	{
+		{
+			boost::mutex::scoped_lock lock(impl->mutex);
+			if(!impl->done)
+			{
+				impl->callbacks.push_back(callback);
+				return;
+			}
+		}
+
+		runCallbacks(std::vector<boost::function<void ()> >(1, callback));
+	}
+
+	CompletionSource::CompletionSource()
+	{
+		completion_.impl->done = false;
+	}
+
+	void CompletionSource::complete() const
+	{
+		completion_.impl->complete(std::string());
+	}
+
+	void CompletionSource::fail(const std::string &error) const
+	{
+		completion_.impl->complete(error.empty() ? std::string("Operation failed") : error);
+	}
+}
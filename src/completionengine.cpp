@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define BOOST_BIND_GLOBAL_PLACEHOLDERS
+#include <boost/bind.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <cudamm/exception.hpp>
+#include <cudamm/deviceptr.hpp>
+#include <cudamm/event.hpp>
+#include <cudamm/eventpool.hpp>
+#include <cudamm/function.hpp>
+#include <cudamm/launchrecord.hpp>
+#include <cudamm/memcpy2d.hpp>
+#include <cudamm/stream.hpp>
+#include <cudamm/completion.hpp>
+
+#include <detail/completion_impl.hpp>
+#include <detail/context.hpp>
+#include <detail/event_impl.hpp>
+
+namespace cuda
+{
+	struct CompletionEngine::impl_t
+	{
+		struct pending_t
+		{
+			boost::shared_ptr<Event> event;
+			boost::shared_ptr<Completion::impl_t> completion;
+
+			// Context of the event, made current to query it
+			CUcontext context;
+		};
+
+		/// Background polling loop
+		struct run_t
+		{
+			explicit run_t(impl_t *engine)
+				: engine(engine)
+			{
+			}
+
+			void operator()() const
+			{
+				engine->run();
+			}
+
+			impl_t *engine;
+		};
+
+		impl_t()
+			: spins(64)
+			, yields(64)
+			, maxSleep(1000)
+			, idle(0)
+			, stop(false)
+			, polls(0)
+		{
+		}
+
+		void run();
+		unsigned int poll();
+
+		EventPool events;
+
+		mutable boost::mutex mutex;
+		boost::condition_variable condition;
+		std::vector<pending_t> pending;
+
+		unsigned int spins, yields, maxSleep;
+
+		// Polls in a row that completed nothing
+		unsigned int idle;
+
+		bool stop;
+		unsigned long polls;
+
+		boost::scoped_ptr<boost::thread> thread;
+	};
+
+	unsigned int CompletionEngine::impl_t::poll()
+	{
+		std::vector<pending_t> finished;
+		std::vector<std::string> failures;
+		{
+			boost::mutex::scoped_lock lock(mutex);
+			++polls;
+
+			std::vector<pending_t>::iterator keep = pending.begin();
+			for(std::vector<pending_t>::iterator it = pending.begin(); it != pending.end(); ++it)
+			{
+				std::string failure;
+				bool done;
+				try
+				{
+					detail::context_push_t scope(it->context);
+					done = it->event->query();
+				} catch(Exception const &e)
+				{
+					done = true;
+					failure = e.what();
+				}
+
+				if(done)
+				{
+					finished.push_back(*it);
+					failures.push_back(failure);
+				}
+				else *keep++ = *it;
+			}
+			pending.erase(keep, pending.end());
+
+			idle = finished.empty() ? idle + 1 : 0;
+		}
+
+		// Complete outside the lock, callbacks may enqueue more work
+		for(std::vector<pending_t>::size_type i = 0; i < finished.size(); ++i)
+		{
+			finished[i].completion->complete(failures[i]);
+		}
+
+		return finished.size();
+	}
+
+	void CompletionEngine::impl_t::run()
+	{
+		for(;;)
+		{
+			unsigned int wait;
+			{
+				boost::mutex::scoped_lock lock(mutex);
+				while(pending.empty() && !stop) condition.wait(lock);
+				if(pending.empty()) return;
+
+				// Spin, then yield, then sleep exponentially longer up to maxSleep
+				if(idle < spins) wait = 0;
+				else if(idle < spins + yields) wait = 1;
+				else
+				{
+					const unsigned int shift = std::min(idle - spins - yields, 16u);
+					wait = std::min(1u << shift, maxSleep) + 1;
+				}
+
+				// Sleeping on the condition lets new work cut the sleep short
+				if(wait > 1)
+				{
+					condition.timed_wait(lock, boost::posix_time::microseconds(wait - 1));
+				}
+			}
+
+			if(wait == 1) boost::this_thread::yield();
+			poll();
+		}
+	}
+
+	CompletionEngine::CompletionEngine(bool background)
+		: impl(new impl_t)
+	{
+		if(background) impl->thread.reset(new boost::thread(impl_t::run_t(impl.get())));
+	}
+
+	CompletionEngine::~CompletionEngine()
+	{
+		if(impl->thread)
+		{
+			{
+				boost::mutex::scoped_lock lock(impl->mutex);
+				impl->stop = true;
+			}
+			impl->condition.notify_all();
+			impl->thread->join();
+		}
+		else
+		{
+			while(pending()) if(!poll()) boost::this_thread::yield();
+		}
+	}
+
+	void CompletionEngine::setBackoff(unsigned int spins, unsigned int yields, unsigned int maxSleepMicroseconds)
+	{
+		boost::mutex::scoped_lock lock(impl->mutex);
+		impl->spins = spins;
+		impl->yields = yields;
+		impl->maxSleep = maxSleepMicroseconds;
+	}
+
+	Completion CompletionEngine::watch(const boost::shared_ptr<Event> &event)
+	{
+		Completion completion;
+		completion.impl->done = false;
+		if(!impl->thread) completion.impl->poll = boost::bind(&CompletionEngine::poll, this);
+
+		impl_t::pending_t pending;
+		pending.event = event;
+		pending.completion = completion.impl;
+		pending.context = event->impl->context;
+		{
+			boost::mutex::scoped_lock lock(impl->mutex);
+			impl->pending.push_back(pending);
+			impl->idle = 0;
+		}
+		impl->condition.notify_all();
+
+		return completion;
+	}
+
+	Completion CompletionEngine::enqueue(const Stream &stream)
+	{
+		boost::shared_ptr<Event> event = impl->events.acquire();
+		event->record(stream);
+		return watch(event);
+	}
+
+	Completion CompletionEngine::copy(const DevicePtr &dest, const void *src, unsigned int len, const Stream &stream)
+	{
+		memcpy(dest, src, len, stream);
+		return enqueue(stream);
+	}
+
+	Completion CompletionEngine::copy(void *dest, const DevicePtr &src, unsigned int len, const Stream &stream)
+	{
+		memcpy(dest, src, len, stream);
+		return enqueue(stream);
+	}
+
+	Completion CompletionEngine::copy(const Memcpy2D &copy, const Stream &stream)
+	{
+		copy.copy(stream);
+		return enqueue(stream);
+	}
+
+	Completion CompletionEngine::launch(const Function &function, int gridWidth, int gridHeight, const Stream &stream)
+	{
+		function.launch(gridWidth, gridHeight, stream);
+		return enqueue(stream);
+	}
+
+	Completion CompletionEngine::launch(const LaunchRecord &record, const Stream &stream)
+	{
+		record.replay(stream);
+		return enqueue(stream);
+	}
+
+	unsigned int CompletionEngine::poll()
+	{
+		return impl->poll();
+	}
+
+	bool CompletionEngine::background() const
+	{
+		return impl->thread.get() != 0;
+	}
+
+	unsigned int CompletionEngine::pending() const
+	{
+		boost::mutex::scoped_lock lock(impl->mutex);
+		return impl->pending.size();
+	}
+
+	unsigned long CompletionEngine::polls() const
+	{
+		boost::mutex::scoped_lock lock(impl->mutex);
+		return impl->polls;
+	}
+}
@@ -0,0 +1,147 @@
+#include <map>
+#include <string>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <cuda.h>
+
+#include <cudamm/context.hpp>
+#include <cudamm/device.hpp>
+#include <cudamm/exception.hpp>
+#include <cudamm/waitpolicy.hpp>
+
+#include <detail/context.hpp>
+#include <detail/error.hpp>
+
+namespace
+{
+	typedef std::map<int, boost::weak_ptr<cuda::Context> > contexts_t;
+
+	boost::mutex contextsMutex;
+	contexts_t contexts;
+}
+
+namespace cuda
+{
+	namespace detail
+	{
+		CUcontext current_context()
+		{
+			CUcontext context;
+			if(cuCtxGetCurrent(&context) != CUDA_SUCCESS) return 0;
+			return context;
+		}
+
+		void context_check(CUcontext owner, const char *msg)
+		{
+			if(!owner || owner == current_context()) return;
+			throw Exception((std::string(msg) + ": created in another Cuda context").c_str());
+		}
+
+		context_push_t::context_push_t(CUcontext context)
+			: pushed(false)
+		{
+			if(!context || context == current_context()) return;
+			error_check(cuCtxPushCurrent(context), "Can't push Cuda context");
+			pushed = true;
+		}
+
+		context_push_t::~context_push_t()
+		{
+			if(!pushed) return;
+			CUcontext popped;
+			error_warn(cuCtxPopCurrent(&popped), "Can't pop Cuda context");
+		}
+	}
+
+	struct Context::impl_t
+	{
+		CUcontext ctx;
+		int ordinal;
+		unsigned int flags;
+	};
+
+	Context::context_ptr Context::device(int ordinal, unsigned int flags)
+	{
+		// Validates the ordinal and initializes Cuda
+		cuda::device(ordinal);
+
+		boost::mutex::scoped_lock lock(contextsMutex);
+
+		contexts_t::iterator it = contexts.find(ordinal);
+		if(it != contexts.end())
+		{
+			context_ptr context = it->second.lock();
+			if(context)
+			{
+				if(flags && flags != context->impl->flags)
+					throw Exception("Cuda context of the device exists with other creation flags");
+				return context;
+			}
+		}
+
+		context_ptr context(new Context(ordinal, flags));
+		contexts[ordinal] = context;
+		return context;
+	}
+
+	Context::Context(int ordinal, unsigned int flags)
+		: impl(new impl_t)
+	{
+		impl->ordinal = ordinal;
+		impl->flags = flags;
+
+		CUdevice dev;
+		detail::error_check(cuDeviceGet(&dev, ordinal), "Can't get Cuda device");
+		detail::error_check(cuCtxCreate(&impl->ctx, flags, dev), "Can't create Cuda context");
+
+		// cuCtxCreate makes the context current, leave the thread as it was
+		CUcontext popped;
+		detail::error_check(cuCtxPopCurrent(&popped), "Can't pop Cuda context");
+	}
+
+	Context::~Context()
+	{
+		if(cuCtxPushCurrent(impl->ctx) == CUDA_SUCCESS)
+		{
+			WaitPolicy::clearContextDefault();
+
+			CUcontext popped;
+			detail::error_warn(cuCtxPopCurrent(&popped), "Can't pop Cuda context");
+		}
+		detail::error_warn(cuCtxDestroy(impl->ctx), "Can't destroy Cuda context");
+	}
+
+	int Context::ordinal() const
+	{
+		return impl->ordinal;
+	}
+
+	const DeviceInfo& Context::info() const
+	{
+		return cuda::device(impl->ordinal);
+	}
+
+	bool Context::current() const
+	{
+		return detail::current_context() == impl->ctx;
+	}
+
+	void Context::synchronize() const
+	{
+		ContextScope scope(*this);
+		detail::error_check(cuCtxSynchronize(), "Can't synchronize Cuda context");
+	}
+
+	ContextScope::ContextScope(const Context &context)
+	{
+		detail::error_check(cuCtxPushCurrent(context.impl->ctx), "Can't push Cuda context");
+	}
+
+	ContextScope::~ContextScope()
+	{
+		CUcontext popped;
+		detail::error_warn(cuCtxPopCurrent(&popped), "Can't pop Cuda context");
+	}
+}
@@ -0,0 +1,463 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include <cudamm/exception.hpp>
+#include <cudamm/cubininfo.hpp>
+
+namespace
+{
+	// Text cubins
+
+	/// Block of a text cubin: "key = value" pairs, nested blocks and bare words
+	struct text_block_t
+	{
+		std::string name;
+		std::map<std::string, std::string> values;
+		std::vector<text_block_t> blocks;
+		std::vector<std::string> words;
+
+		unsigned int number(const char *key) const
+		{
+			std::map<std::string, std::string>::const_iterator it = values.find(key);
+			if(it == values.end()) return 0;
+			return static_cast<unsigned int>(std::strtoul(it->second.c_str(), 0, 0));
+		}
+
+		std::string string(const char *key) const
+		{
+			std::map<std::string, std::string>::const_iterator it = values.find(key);
+			if(it == values.end()) return std::string();
+			return it->second;
+		}
+	};
+
+	class text_parser_t
+	{
+		public:
+			text_parser_t(const char *text, size_t size)
+				: pos(text), end(text + size)
+			{
+			}
+
+			void parse(text_block_t &block)
+			{
+				std::string token;
+				while(next(token))
+				{
+					if(token == "}") return;
+
+					std::string op;
+					const char *mark = pos;
+					if(next(op) && op == "=")
+					{
+						std::string value;
+						if(!next(value)) throw cuda::Exception("Unexpected end of cubin");
+						block.values[token] = value;
+					} else if(op == "{")
+					{
+						block.blocks.push_back(text_block_t());
+						block.blocks.back().name = token;
+						parse(block.blocks.back());
+					} else
+					{
+						pos = mark;
+						block.words.push_back(token);
+					}
+				}
+			}
+
+		private:
+			bool next(std::string &token)
+			{
+				while(pos != end && std::isspace(static_cast<unsigned char>(*pos))) ++pos;
+				if(pos == end) return false;
+
+				if(*pos == '{' || *pos == '}' || *pos == '=')
+				{
+					token.assign(pos, pos + 1);
+					++pos;
+					return true;
+				}
+
+				const char *start = pos;
+				while(pos != end && !std::isspace(static_cast<unsigned char>(*pos))
+					&& *pos != '{' && *pos != '}' && *pos != '=') ++pos;
+				token.assign(start, pos);
+				return true;
+			}
+
+			const char *pos, *end;
+	};
+
+	// ELF cubins
+
+	const unsigned int SHT_SYMTAB = 2;
+	const unsigned int STT_OBJECT = 1;
+	const unsigned int STT_CUDA_TEXTURE = 10;
+
+	// .nv.info attribute formats and the attributes we are interested in
+	const unsigned char EIFMT_HVAL = 0x03;
+	const unsigned char EIFMT_SVAL = 0x04;
+	const unsigned char EIATTR_PARAM_CBANK = 0x0a;
+	const unsigned char EIATTR_FRAME_SIZE = 0x11;
+	const unsigned char EIATTR_KPARAM_INFO = 0x17;
+	const unsigned char EIATTR_CBANK_PARAM_SIZE = 0x19;
+	const unsigned char EIATTR_REGCOUNT = 0x2f;
+
+	struct elf_section_t
+	{
+		std::string name;
+		unsigned int type, info, link;
+		size_t offset, size;
+	};
+
+	struct elf_symbol_t
+	{
+		std::string name;
+		unsigned int type, section;
+		size_t value, size;
+	};
+
+	/// Bounds checked little endian reader
+	class elf_reader_t
+	{
+		public:
+			elf_reader_t(const char *image, size_t size)
+				: image(reinterpret_cast<const unsigned char *>(image)), size(size)
+			{
+			}
+
+			boost::uint64_t read(size_t offset, unsigned int bytes) const
+			{
+				if(offset + bytes > size || offset + bytes < offset) throw cuda::Exception("Truncated ELF cubin");
+				boost::uint64_t value = 0;
+				for(unsigned int i = bytes; i--; ) value = (value << 8) | image[offset + i];
+				return value;
+			}
+
+			std::string string(size_t offset) const
+			{
+				if(offset >= size) throw cuda::Exception("Truncated ELF cubin");
+				const char *begin = reinterpret_cast<const char *>(image + offset);
+				return std::string(begin, ::strnlen(begin, size - offset));
+			}
+
+		private:
+			const unsigned char *image;
+			size_t size;
+	};
+
+	bool startsWith(const std::string &str, const char *prefix)
+	{
+		return str.compare(0, std::strlen(prefix), prefix) == 0;
+	}
+
+	cuda::CubinKernel& kernelNamed(std::vector<cuda::CubinKernel> &kernels, const std::string &name)
+	{
+		for(std::vector<cuda::CubinKernel>::iterator it = kernels.begin(); it != kernels.end(); ++it)
+		{
+			if(it->name == name) return *it;
+		}
+		kernels.push_back(cuda::CubinKernel());
+		kernels.back().name = name;
+		return kernels.back();
+	}
+
+	bool byOrdinal(const cuda::CubinParameter &a, const cuda::CubinParameter &b)
+	{
+		return a.ordinal < b.ordinal;
+	}
+}
+
+namespace cuda
+{
+	void CubinKernel::checkParameters(const std::vector<CubinParameter> &expected) const
+	{
+		if(parameters.empty() && !parameterBytes) return;
+
+		std::ostringstream msg;
+		msg << "Parameter layout of Cuda kernel " << name << " does not match cubin: ";
+
+		if(!parameters.empty())
+		{
+			if(expected.size() != parameters.size())
+			{
+				msg << expected.size() << " parameters given, " << parameters.size() << " expected";
+				throw Exception(msg.str().c_str());
+			}
+
+			for(size_t i = 0; i < parameters.size(); ++i)
+			{
+				if(expected[i].offset != parameters[i].offset || expected[i].size != parameters[i].size)
+				{
+					msg << "parameter " << i << " at offset " << expected[i].offset << " with size " << expected[i].size
+						<< ", expected offset " << parameters[i].offset << " with size " << parameters[i].size;
+					throw Exception(msg.str().c_str());
+				}
+			}
+		}
+
+		if(parameterBytes && !expected.empty())
+		{
+			const unsigned int bytes = expected.back().offset + expected.back().size;
+			if(bytes > parameterBytes)
+			{
+				msg << bytes << " parameter bytes given, " << parameterBytes << " expected";
+				throw Exception(msg.str().c_str());
+			}
+		}
+	}
+
+	CubinInfo::CubinInfo(const char *filename)
+	{
+		std::ifstream file(filename, std::ios::in | std::ios::binary);
+		if(!file) throw Exception((std::string("Can't open cubin ") + filename).c_str());
+
+		const std::vector<char> image((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		parse(image.empty() ? 0 : &image[0], image.size());
+	}
+
+	CubinInfo::CubinInfo(const void *image, size_t size)
+	{
+		parse(static_cast<const char *>(image), size);
+	}
+
+	const CubinKernel& CubinInfo::kernel(const char *name) const
+	{
+		for(std::vector<CubinKernel>::const_iterator it = kernels_.begin(); it != kernels_.end(); ++it)
+		{
+			if(it->name == name) return *it;
+		}
+		throw Exception((std::string("No kernel named ") + name + " in cubin").c_str());
+	}
+
+	bool CubinInfo::hasKernel(const char *name) const
+	{
+		for(std::vector<CubinKernel>::const_iterator it = kernels_.begin(); it != kernels_.end(); ++it)
+		{
+			if(it->name == name) return true;
+		}
+		return false;
+	}
+
+	void CubinInfo::parse(const char *image, size_t size)
+	{
+		if(size >= 4 && std::memcmp(image, "\x7f" "ELF", 4) == 0) parseElf(image, size);
+		else parseText(image, size);
+	}
+
+	void CubinInfo::parseText(const char *image, size_t size)
+	{
+		text_block_t root;
+		text_parser_t(image, size).parse(root);
+
+		for(std::vector<text_block_t>::const_iterator it = root.blocks.begin(); it != root.blocks.end(); ++it)
+		{
+			if(it->name == "architecture")
+			{
+				if(!it->words.empty()) architecture_ = it->words.front();
+			} else if(it->name == "sampler" || it->name == "texture")
+			{
+				textures_.push_back(it->string("name"));
+			} else if(it->name == "consts")
+			{
+				CubinSymbol symbol;
+				symbol.name = it->string("name");
+				symbol.bank = it->number("segnum");
+				symbol.offset = it->number("offset");
+				symbol.size = it->number("bytes");
+				constants_.push_back(symbol);
+			} else if(it->name == "code")
+			{
+				CubinKernel kernel;
+				kernel.name = it->string("name");
+				kernel.registers = it->number("reg");
+				kernel.sharedBytes = it->number("smem");
+				kernel.localBytes = it->number("lmem");
+				kernel.barriers = it->number("bar");
+				kernel.parameterBytes = it->number("params");
+
+				for(std::vector<text_block_t>::const_iterator c = it->blocks.begin(); c != it->blocks.end(); ++c)
+				{
+					if(c->name == "const") kernel.constBytes += c->number("bytes");
+				}
+
+				kernels_.push_back(kernel);
+			}
+		}
+
+		if(architecture_.empty() && kernels_.empty()) throw Exception("Not a cubin");
+	}
+
+	void CubinInfo::parseElf(const char *image, size_t size)
+	{
+		const elf_reader_t elf(image, size);
+
+		const bool is64 = elf.read(4, 1) == 2;
+		if(elf.read(5, 1) != 1) throw Exception("Big endian ELF cubins are not supported");
+
+		const unsigned int flags = static_cast<unsigned int>(elf.read(is64 ? 48 : 36, 4));
+		const size_t shoff = static_cast<size_t>(is64 ? elf.read(40, 8) : elf.read(32, 4));
+		const unsigned int shentsize = static_cast<unsigned int>(elf.read(is64 ? 58 : 46, 2));
+		const unsigned int shnum = static_cast<unsigned int>(elf.read(is64 ? 60 : 48, 2));
+		const unsigned int shstrndx = static_cast<unsigned int>(elf.read(is64 ? 62 : 50, 2));
+
+		std::ostringstream arch;
+		arch << "sm_" << (flags & 0xff);
+		architecture_ = arch.str();
+
+		// Section headers
+		std::vector<elf_section_t> sections(shnum);
+		for(unsigned int i = 0; i < shnum; ++i)
+		{
+			const size_t sh = shoff + i * shentsize;
+			elf_section_t &section = sections[i];
+			section.type = static_cast<unsigned int>(elf.read(sh + 4, 4));
+			if(is64)
+			{
+				section.offset = static_cast<size_t>(elf.read(sh + 24, 8));
+				section.size = static_cast<size_t>(elf.read(sh + 32, 8));
+				section.link = static_cast<unsigned int>(elf.read(sh + 40, 4));
+				section.info = static_cast<unsigned int>(elf.read(sh + 44, 4));
+			} else
+			{
+				section.offset = static_cast<size_t>(elf.read(sh + 16, 4));
+				section.size = static_cast<size_t>(elf.read(sh + 20, 4));
+				section.link = static_cast<unsigned int>(elf.read(sh + 24, 4));
+				section.info = static_cast<unsigned int>(elf.read(sh + 28, 4));
+			}
+		}
+
+		if(shstrndx >= shnum) throw Exception("ELF cubin without section names");
+		for(unsigned int i = 0; i < shnum; ++i)
+		{
+			const size_t sh = shoff + i * shentsize;
+			sections[i].name = elf.string(sections[shstrndx].offset + static_cast<size_t>(elf.read(sh, 4)));
+		}
+
+		// Symbols
+		std::vector<elf_symbol_t> symbols;
+		for(unsigned int i = 0; i < shnum; ++i)
+		{
+			if(sections[i].type != SHT_SYMTAB || sections[i].link >= shnum) continue;
+
+			const size_t entsize = is64 ? 24 : 16;
+			const size_t strtab = sections[sections[i].link].offset;
+			for(size_t sym = sections[i].offset; sym + entsize <= sections[i].offset + sections[i].size; sym += entsize)
+			{
+				elf_symbol_t symbol;
+				symbol.name = elf.string(strtab + static_cast<size_t>(elf.read(sym, 4)));
+				if(is64)
+				{
+					symbol.type = static_cast<unsigned int>(elf.read(sym + 4, 1)) & 0xf;
+					symbol.section = static_cast<unsigned int>(elf.read(sym + 6, 2));
+					symbol.value = static_cast<size_t>(elf.read(sym + 8, 8));
+					symbol.size = static_cast<size_t>(elf.read(sym + 16, 8));
+				} else
+				{
+					symbol.value = static_cast<size_t>(elf.read(sym + 4, 4));
+					symbol.size = static_cast<size_t>(elf.read(sym + 8, 4));
+					symbol.type = static_cast<unsigned int>(elf.read(sym + 12, 1)) & 0xf;
+					symbol.section = static_cast<unsigned int>(elf.read(sym + 14, 2));
+				}
+				symbols.push_back(symbol);
+			}
+		}
+
+		// Kernels, their shared memory and constant banks
+		for(unsigned int i = 0; i < shnum; ++i)
+		{
+			const std::string &name = sections[i].name;
+			if(startsWith(name, ".text."))
+			{
+				CubinKernel &kernel = kernelNamed(kernels_, name.substr(6));
+				kernel.registers = sections[i].info >> 24;
+			} else if(startsWith(name, ".nv.shared."))
+			{
+				kernelNamed(kernels_, name.substr(11)).sharedBytes = static_cast<unsigned int>(sections[i].size);
+			} else if(startsWith(name, ".nv.constant") && name.find('.', 12) != std::string::npos)
+			{
+				CubinKernel &kernel = kernelNamed(kernels_, name.substr(name.find('.', 12) + 1));
+				kernel.constBytes += static_cast<unsigned int>(sections[i].size);
+			}
+		}
+
+		// Texture references and constant symbols
+		for(std::vector<elf_symbol_t>::const_iterator it = symbols.begin(); it != symbols.end(); ++it)
+		{
+			if(it->type == STT_CUDA_TEXTURE)
+			{
+				textures_.push_back(it->name);
+			} else if(it->type == STT_OBJECT && it->section < shnum)
+			{
+				const std::string &section = sections[it->section].name;
+				if(!startsWith(section, ".nv.constant") || section.find('.', 12) != std::string::npos) continue;
+
+				CubinSymbol symbol;
+				symbol.name = it->name;
+				symbol.bank = static_cast<unsigned int>(std::strtoul(section.c_str() + 12, 0, 10));
+				symbol.offset = static_cast<unsigned int>(it->value);
+				symbol.size = static_cast<unsigned int>(it->size);
+				constants_.push_back(symbol);
+			}
+		}
+
+		// Attributes: ".nv.info" holds attributes of all kernels keyed by
+		// symbol index, ".nv.info.<kernel>" those of a single kernel
+		for(unsigned int i = 0; i < shnum; ++i)
+		{
+			const std::string &name = sections[i].name;
+			if(name != ".nv.info" && !startsWith(name, ".nv.info.")) continue;
+
+			CubinKernel *owner = name.size() > 9 ? &kernelNamed(kernels_, name.substr(9)) : 0;
+
+			size_t pos = sections[i].offset;
+			const size_t end = sections[i].offset + sections[i].size;
+			while(pos + 4 <= end)
+			{
+				const unsigned int format = static_cast<unsigned int>(elf.read(pos, 1));
+				const unsigned int attribute = static_cast<unsigned int>(elf.read(pos + 1, 1));
+				const unsigned int value = static_cast<unsigned int>(elf.read(pos + 2, 2));
+				const size_t data = pos + 4;
+				pos = data + (format == EIFMT_SVAL ? value : 0);
+
+				if(format == EIFMT_HVAL && attribute == EIATTR_CBANK_PARAM_SIZE && owner)
+				{
+					owner->parameterBytes = value;
+				} else if(format == EIFMT_SVAL && attribute == EIATTR_KPARAM_INFO && owner && value >= 12)
+				{
+					const unsigned int info = static_cast<unsigned int>(elf.read(data + 8, 4));
+					owner->parameters.push_back(CubinParameter(
+						static_cast<unsigned int>(elf.read(data + 4, 2)),
+						static_cast<unsigned int>(elf.read(data + 6, 2)),
+						(info >> 18) & 0x3fff));
+				} else if(format == EIFMT_SVAL && attribute == EIATTR_PARAM_CBANK && owner && value >= 8)
+				{
+					owner->parameterBytes = static_cast<unsigned int>(elf.read(data + 6, 2));
+				} else if(format == EIFMT_SVAL && value >= 8
+					&& (attribute == EIATTR_REGCOUNT || attribute == EIATTR_FRAME_SIZE))
+				{
+					const size_t index = static_cast<size_t>(elf.read(data, 4));
+					if(index >= symbols.size() || !hasKernel(symbols[index].name.c_str())) continue;
+
+					CubinKernel &kernel = kernelNamed(kernels_, symbols[index].name);
+					const unsigned int amount = static_cast<unsigned int>(elf.read(data + 4, 4));
+					if(attribute == EIATTR_REGCOUNT) kernel.registers = amount;
+					else kernel.localBytes = amount;
+				}
+			}
+
+			if(owner) std::sort(owner->parameters.begin(), owner->parameters.end(), byOrdinal);
+		}
+	}
+}
@@ -6,23 +6,28 @@ namespace cuda
 {
 	struct Cuda::impl_t
 	{
-		CUcontext ctx;
+		// The scope is declared last so it is popped before the context is released
+		Context::context_ptr context;
+		boost::scoped_ptr<ContextScope> scope;
 	};
 
 	Cuda::Cuda(int numDevice, bool gl)
 		: impl(new impl_t)
 	{
-		detail::error_check(cuInit(0));
-	
-		CUdevice dev;
-		detail::error_check(cuDeviceGet(&dev, numDevice), "Can't get Cuda device");
     //if(gl) detail::error_check(cuGLCtxCreate(&impl->ctx, 0, dev), "Can't create (OpenGL interoperable) Cuda context");
-    //else   detail::error_check(cuCtxCreate(&impl->ctx, 0, dev), "Can't create Cuda context");
-    detail::error_check(cuCtxCreate(&impl->ctx, 0, dev), "Can't create Cuda context");
+		impl->context = Context::device(numDevice);
+		impl->scope.reset(new ContextScope(*impl->context));
+	}
+
+	Cuda::Cuda(int numDevice, bool /*gl*/, const WaitPolicy &policy)
+		: impl(new impl_t)
+	{
+		impl->context = Context::device(numDevice, policy.contextFlags());
+		impl->scope.reset(new ContextScope(*impl->context));
+		WaitPolicy::setContextDefault(policy);
 	}
 
 	Cuda::~Cuda()
 	{
-		detail::error_warn(cuCtxDetach(impl->ctx), "Can't detach Cuda context");
 	}
 }
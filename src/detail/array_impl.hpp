@@ -1,6 +1,7 @@
 #ifndef CUDA_DETAIL_ARRAY_IMPL_HPP
 #define CUDA_DETAIL_ARRAY_IMPL_HPP
 
+#include <cuda.h>
 #include <cudamm/array.hpp>
 
 namespace cuda
@@ -8,6 +9,9 @@ namespace cuda
 	struct Array::impl_t
 	{
 		CUarray array;
+
+		// Context the array was created in
+		CUcontext context;
 	};
 }
 
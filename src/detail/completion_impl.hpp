@@ -0,0 +1,36 @@
+#ifndef CUDA_DETAIL_COMPLETION_IMPL_HPP
+#define CUDA_DETAIL_COMPLETION_IMPL_HPP
+
+#include <string>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <cudamm/completion.hpp>
+
+namespace cuda
+{
+	struct Completion::impl_t
+	{
+		impl_t()
+			: done(false)
+		{
+		}
+
+		/// Mark complete, wake waiters and run callbacks
+		void complete(const std::string &failure);
+
+		boost::mutex mutex;
+		boost::condition_variable condition;
+		bool done;
+		std::string error;
+		std::vector<boost::function<void ()> > callbacks;
+
+		// Drives the completing engine while waiting, empty if it has a background thread
+		boost::function<unsigned int ()> poll;
+	};
+}
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef CUDA_DETAIL_CONTEXT_HPP
+#define CUDA_DETAIL_CONTEXT_HPP
+
+#include <boost/utility.hpp>
+
+#include <cuda.h>
+
+namespace cuda
+{
+	namespace detail
+	{
+		/// Get the context current on the calling thread, 0 if there is none
+		CUcontext current_context();
+
+		/// Throw unless the owning context of an object is current
+		/**
+			Objects without owner (0) pass.
+
+			@param owner the context the object was created in
+			@param msg what could not be done
+		*/
+		void context_check(CUcontext owner, const char *msg);
+
+		/// Make a context current for a scope unless it already is
+		/**
+			For threads that use objects of a context they don't own,
+			e.g. completion polling threads.
+
+			Noncopyable.
+		*/
+		class context_push_t : boost::noncopyable
+		{
+			public:
+				/// Push the context
+				/**
+					@param context the context, 0 to push nothing
+				*/
+				explicit context_push_t(CUcontext context);
+
+				/// Pop the context if it was pushed
+				~context_push_t();
+
+			private:
+				bool pushed;
+		};
+	}
+}
+
+#endif
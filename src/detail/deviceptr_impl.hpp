@@ -10,10 +10,14 @@ namespace cuda
 	{
 		impl_t()
 			: devicePtr(static_cast<CUdeviceptr>(0))
+			, context(0)
 		{
 		}
 
 		CUdeviceptr devicePtr;
+
+		// Context the memory was allocated in, 0 if unknown
+		CUcontext context;
 	};
 }
 
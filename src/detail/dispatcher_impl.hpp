@@ -0,0 +1,73 @@
+#ifndef CUDA_DETAIL_DISPATCHER_IMPL_HPP
+#define CUDA_DETAIL_DISPATCHER_IMPL_HPP
+
+#include <boost/atomic.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <cudamm/dispatcher.hpp>
+#include <cudamm/mpscqueue.hpp>
+
+namespace cuda
+{
+	struct Dispatcher::impl_t
+	{
+		struct item_t
+		{
+			Operation operation;
+			CompletionSource source;
+		};
+
+		/// Background loop
+		struct run_t
+		{
+			explicit run_t(impl_t *dispatcher)
+				: dispatcher(dispatcher)
+			{
+			}
+
+			void operator()() const
+			{
+				dispatcher->run();
+			}
+
+			impl_t *dispatcher;
+		};
+
+		impl_t()
+			: idle(false)
+			, stop(false)
+			, submitted(0)
+			, executed(0)
+		{
+		}
+
+		void run();
+
+		Context::context_ptr context;
+		MpscQueue<item_t> queue;
+
+		// The thread sleeps on the condition while idle is set
+		boost::atomic<bool> idle;
+		boost::mutex mutex;
+		boost::condition_variable condition;
+		bool stop;
+
+		boost::atomic<unsigned long> submitted, executed;
+
+		// Stream and engine, created and released on the dispatcher thread
+		boost::shared_ptr<void> resources;
+
+		// Polls the engine of the stream operations and returns the number of
+		// operations still pending, empty until the first stream operation
+		boost::function<unsigned int ()> poll;
+
+		boost::scoped_ptr<boost::thread> thread;
+	};
+}
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef CUDA_DETAIL_EVENT_IMPL_HPP
+#define CUDA_DETAIL_EVENT_IMPL_HPP
+
+#include <cuda.h>
+
+#include <cudamm/event.hpp>
+
+namespace cuda
+{
+	struct Event::impl_t
+	{
+		CUevent event;
+
+		// Context the event was created in
+		CUcontext context;
+	};
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef CUDA_DETAIL_FILE_HPP
+#define CUDA_DETAIL_FILE_HPP
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace cuda
+{
+	namespace detail
+	{
+		/// Replace a file with new contents in one step
+		/**
+			Writes to a unique temporary file next to the target first,
+			so that concurrent readers and writers never see a partially
+			written file.
+
+			@param filename the file to replace
+			@param data the new contents
+			@param len the size of the contents (in bytes)
+			@return true if the file was replaced
+		*/
+		inline bool replace_file(const std::string &filename, const void *data, size_t len)
+		{
+			std::vector<char> temp(filename.begin(), filename.end());
+			const char suffix[] = ".XXXXXX";
+			temp.insert(temp.end(), suffix, suffix + sizeof(suffix));
+
+			const int fd = mkstemp(&temp[0]);
+			if(fd < 0) return false;
+
+			std::FILE *file = fdopen(fd, "wb");
+			if(!file)
+			{
+				close(fd);
+				std::remove(&temp[0]);
+				return false;
+			}
+
+			const bool written = std::fwrite(data, 1, len, file) == len;
+			if(std::fclose(file) != 0 || !written || std::rename(&temp[0], filename.c_str()) != 0)
+			{
+				std::remove(&temp[0]);
+				return false;
+			}
+			return true;
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef CUDA_DETAIL_FUNCTION_IMPL_HPP
+#define CUDA_DETAIL_FUNCTION_IMPL_HPP
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/recursive_mutex.hpp>
+
+#include <cuda.h>
+
+#include <cudamm/function.hpp>
+
+namespace cuda
+{
+	namespace detail
+	{
+		/// Launch state of a CUfunction as last set through the library
+		/**
+			The driver keeps block shape, shared size, parameters and
+			textures per CUfunction, and a module hands out the same
+			CUfunction for every lookup of a name, so this state is
+			shared by all Function objects of a kernel.
+		*/
+		struct function_state_t
+		{
+			function_state_t(CUfunction func, CUcontext context)
+				: func(func)
+				, context(context)
+				, blockX(0), blockY(0), blockZ(0)
+				, sharedSize(0), sharedSizeKnown(false)
+				, parameterSize(0), parameterSizeKnown(false)
+			{
+			}
+			
+			/// Record parameter bytes written to the driver
+			void setParameters(int offset, const void *data, unsigned int len)
+			{
+				const size_t end = static_cast<size_t>(offset) + len;
+				if(parameters.size() < end)
+				{
+					parameters.resize(end, 0);
+					known.resize(end, false);
+				}
+				
+				const unsigned char *bytes = static_cast<const unsigned char *>(data);
+				std::copy(bytes, bytes + len, parameters.begin() + offset);
+				std::fill(known.begin() + offset, known.begin() + end, true);
+			}
+			
+			/// Query if a texture reference has been made available to the function
+			bool usesTexture(CUtexref texref) const
+			{
+				return std::find(textures.begin(), textures.end(), texref) != textures.end();
+			}
+			
+			CUfunction func;
+
+			// Context of the module the function belongs to
+			CUcontext context;
+			
+			// Block shape, 0 if not set yet
+			int blockX, blockY, blockZ;
+			
+			unsigned int sharedSize;
+			bool sharedSizeKnown;
+			
+			unsigned int parameterSize;
+			bool parameterSizeKnown;
+			
+			// Shadow of the parameter space and which bytes of it have been set
+			std::vector<unsigned char> parameters;
+			std::vector<bool> known;
+			
+			std::vector<CUtexref> textures;
+			
+			// Guards the driver state of func and this shadow of it
+			boost::recursive_mutex mutex;
+		};
+	}
+	
+	struct Function::impl_t
+	{
+		boost::shared_ptr<detail::function_state_t> state;
+		CUfunction func;
+		std::string name;
+
+		// Hash of the image of the module
+		std::string moduleHash;
+
+		// Cubin metadata of the kernel, 0 if not given
+		boost::shared_ptr<CubinKernel> cubin;
+	};
+}
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef CUDA_DETAIL_HASH_HPP
+#define CUDA_DETAIL_HASH_HPP
+
+#include <cstddef>
+#include <string>
+
+#include <boost/cstdint.hpp>
+
+namespace cuda
+{
+	namespace detail
+	{
+		/// 64 bit FNV-1a hash, used for naming on-disk cache entries
+		class hash_t
+		{
+			public:
+				hash_t()
+					: value_(14695981039346656037ULL)
+				{
+				}
+				
+				hash_t& add(const void *data, size_t len)
+				{
+					const unsigned char *p = static_cast<const unsigned char *>(data);
+					for(size_t i = 0; i < len; ++i)
+					{
+						value_ ^= p[i];
+						value_ *= 1099511628211ULL;
+					}
+					return *this;
+				}
+				
+				hash_t& add(const std::string &str)
+				{
+					return add(str.data(), str.size() + 1);
+				}
+				
+				template <class T>
+				hash_t& add(const T &value)
+				{
+					return add(&value, sizeof(value));
+				}
+				
+				boost::uint64_t value() const { return value_; }
+				
+				std::string hex() const
+				{
+					static const char digits[] = "0123456789abcdef";
+					std::string str(16, '0');
+					for(int i = 0; i < 16; ++i) str[15 - i] = digits[(value_ >> (4 * i)) & 0xf];
+					return str;
+				}
+				
+			private:
+				boost::uint64_t value_;
+		};
+	}
+}
+
+#endif
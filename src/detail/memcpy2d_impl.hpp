@@ -0,0 +1,16 @@
+#ifndef CUDA_DETAIL_MEMCPY2D_IMPL_HPP
+#define CUDA_DETAIL_MEMCPY2D_IMPL_HPP
+
+#include <cuda.h>
+
+#include <cudamm/memcpy2d.hpp>
+
+namespace cuda
+{
+	struct Memcpy2D::impl_t
+	{
+		CUDA_MEMCPY2D_st memcpy2d;
+	};
+}
+
+#endif
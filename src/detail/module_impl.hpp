@@ -1,17 +1,66 @@
 #ifndef CUDA_DETAIL_MODULE_IMPL_HPP
 #define CUDA_DETAIL_MODULE_IMPL_HPP
 
+#include <map>
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
 #include <cuda.h>
 
 #include <cudamm/module.hpp>
 
+#include <detail/function_impl.hpp>
+
 namespace cuda
 {
 	struct Module::impl_t
 	{
+		struct global_t
+		{
+			CUdeviceptr ptr;
+			unsigned int bytes;
+		};
+
+		typedef boost::shared_ptr<detail::function_state_t> function_ptr;
+		typedef std::map<std::string, function_ptr> function_map_t;
+		typedef std::map<std::string, CUtexref> texref_map_t;
+		typedef std::map<std::string, global_t> global_map_t;
+
+		impl_t()
+			: fromCache(false)
+		{
+		}
+
 		CUmodule mod;
+
+		// Context the module was loaded in
+		CUcontext context;
+
+		// Hash of the module image
+		std::string hash;
+
+		// JIT results of the load, if any
+		std::string infoLog, errorLog;
+		bool fromCache;
+
+		/// Look up a function by name, asking the driver only on first use
+		function_ptr function(const char *name);
+
+		/// Look up a texture reference by name, asking the driver only on first use
+		CUtexref texref(const char *name);
+
+		/// Look up a global symbol by name, asking the driver only on first use
+		global_t global(const char *name);
+
+		// Handles owned by the module stay valid until it is unloaded,
+		// so they can be cached by name and shared by all users.
+		boost::mutex mutex;
+		function_map_t functions;
+		texref_map_t texrefs;
+		global_map_t globals;
 	};
 }
 
 #endif
-
@@ -10,6 +10,9 @@ namespace cuda
 	struct Stream::impl_t
 	{
 		CUstream stream;
+
+		// Context the stream was created in
+		CUcontext context;
 	};
 }
 
@@ -1,6 +1,7 @@
 #ifndef CUDA_DETAIL_TEXTUREREFERENCE_IMPL_HPP
 #define CUDA_DETAIL_TEXTUREREFERENCE_IMPL_HPP
 
+#include <cuda.h>
 #include <cudamm/texturereference.hpp>
 
 namespace cuda
@@ -8,6 +9,9 @@ namespace cuda
 	struct TextureReference::impl_t
 	{
 		CUtexref texref;
+
+		// Context of the module the texture reference belongs to
+		CUcontext context;
 	};
 }
 
@@ -0,0 +1,71 @@
+#ifndef CUDA_DETAIL_WAIT_HPP
+#define CUDA_DETAIL_WAIT_HPP
+
+#include <time.h>
+
+#include <boost/thread/thread.hpp>
+
+#include <cudamm/waitpolicy.hpp>
+
+namespace cuda
+{
+	namespace detail
+	{
+		/// Monotonic time in microseconds
+		inline double now()
+		{
+			timespec t;
+			clock_gettime(CLOCK_MONOTONIC, &t);
+			return t.tv_sec * 1e6 + t.tv_nsec * 1e-3;
+		}
+
+		/// Processor time of the calling thread in microseconds
+		inline double threadTime()
+		{
+			timespec t;
+			clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+			return t.tv_sec * 1e6 + t.tv_nsec * 1e-3;
+		}
+
+		/// Wait by a policy
+		/**
+			@param policy the wait policy
+			@param query returns true once the wait is over
+			@param block waits in the driver
+		*/
+		template <class Query, class Block>
+		void wait(const WaitPolicy &policy, Query query, Block block)
+		{
+			switch(policy.strategy)
+			{
+				case WaitPolicy::SPIN:
+					while(!query());
+					break;
+
+				case WaitPolicy::YIELD:
+					while(!query()) boost::this_thread::yield();
+					break;
+
+				case WaitPolicy::BLOCKING:
+					block();
+					break;
+
+				case WaitPolicy::HYBRID:
+				{
+					const double end = now() + policy.spinMicroseconds;
+					while(!query())
+					{
+						if(now() >= end)
+						{
+							block();
+							break;
+						}
+					}
+					break;
+				}
+			}
+		}
+	}
+}
+
+#endif
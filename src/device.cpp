@@ -0,0 +1,80 @@
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+
+#include <cuda.h>
+
+#include <cudamm/device.hpp>
+#include <cudamm/exception.hpp>
+
+#include <detail/error.hpp>
+
+namespace
+{
+	boost::mutex devicesMutex;
+	std::vector<cuda::DeviceInfo> deviceList;
+	bool queried = false;
+
+	int attribute(CUdevice_attribute attribute, CUdevice dev)
+	{
+		int value = 0;
+		cuda::detail::error_check(cuDeviceGetAttribute(&value, attribute, dev),
+			"Can't get Cuda device attribute");
+		return value;
+	}
+
+	cuda::DeviceInfo query(int ordinal)
+	{
+		CUdevice dev;
+		cuda::detail::error_check(cuDeviceGet(&dev, ordinal), "Can't get Cuda device");
+
+		char name[256];
+		cuda::detail::error_check(cuDeviceGetName(name, sizeof(name), dev), "Can't get Cuda device name");
+
+		cuda::DeviceInfo info;
+		info.ordinal = ordinal;
+		info.name = name;
+		cuda::detail::error_check(cuDeviceComputeCapability(&info.major, &info.minor, dev),
+			"Can't get Cuda device compute capability");
+		cuda::detail::error_check(cuDeviceTotalMem(&info.totalMemory, dev),
+			"Can't get Cuda device memory size");
+		info.multiprocessors = attribute(CU_DEVICE_ATTRIBUTE_MULTIPROCESSOR_COUNT, dev);
+		info.maxThreadsPerBlock = attribute(CU_DEVICE_ATTRIBUTE_MAX_THREADS_PER_BLOCK, dev);
+		info.maxThreadsPerMultiprocessor = attribute(CU_DEVICE_ATTRIBUTE_MAX_THREADS_PER_MULTIPROCESSOR, dev);
+		info.maxSharedMemoryPerBlock = attribute(CU_DEVICE_ATTRIBUTE_MAX_SHARED_MEMORY_PER_BLOCK, dev);
+		info.warpSize = attribute(CU_DEVICE_ATTRIBUTE_WARP_SIZE, dev);
+		info.clockRate = attribute(CU_DEVICE_ATTRIBUTE_CLOCK_RATE, dev);
+		info.asyncEngines = attribute(CU_DEVICE_ATTRIBUTE_ASYNC_ENGINE_COUNT, dev);
+		return info;
+	}
+}
+
+namespace cuda
+{
+	const std::vector<DeviceInfo>& devices()
+	{
+		// The list never changes once queried, so the reference stays valid
+		boost::mutex::scoped_lock lock(devicesMutex);
+		if(queried) return deviceList;
+
+		detail::error_check(cuInit(0), "Can't initialize Cuda");
+
+		int count;
+		detail::error_check(cuDeviceGetCount(&count), "Can't get Cuda device count");
+
+		std::vector<DeviceInfo> list;
+		for(int i = 0; i < count; ++i) list.push_back(query(i));
+
+		deviceList.swap(list);
+		queried = true;
+		return deviceList;
+	}
+
+	const DeviceInfo& device(int ordinal)
+	{
+		const std::vector<DeviceInfo> &list = devices();
+		if(ordinal < 0 || static_cast<unsigned int>(ordinal) >= list.size())
+			throw Exception("No such Cuda device");
+		return list[ordinal];
+	}
+}
@@ -3,6 +3,7 @@
 #include <cudamm/deviceptr.hpp>
 #include <cudamm/stream.hpp>
 
+#include <detail/context.hpp>
 #include <detail/error.hpp>
 #include <detail/stream_impl.hpp>
 #include <detail/deviceptr_impl.hpp>
@@ -37,52 +38,79 @@ namespace cuda
   
   void memcpy(const DevicePtr &dest, const void *src, unsigned int len)
   {
+    detail::context_check(dest.impl->context, "Can't memcpy from host memory to device memory");
     detail::error_check(cuMemcpyHtoD(dest.impl->devicePtr, src, len),
       "Can't memcpy from host memory to device memory");
   }
   
   void memcpy(void *dest, const DevicePtr& src, unsigned int len)
   { 
+    detail::context_check(src.impl->context, "Can't memcpy from device memory to host memory");
     detail::error_check(cuMemcpyDtoH(dest, src.impl->devicePtr, len),
       "Can't memcpy from device memory to host memory");
   }
 
   void memcpy(const DevicePtr& dest, const DevicePtr& src, unsigned int len)
   {
+    detail::context_check(dest.impl->context, "Can't memcpy from device memory to device memory");
+    detail::context_check(src.impl->context, "Can't memcpy from device memory to device memory");
     detail::error_check(cuMemcpyDtoD(dest.impl->devicePtr, src.impl->devicePtr, len),
       "Can't memcpy from device memory to device memory");
   }
 
   void memcpy(const DevicePtr &dest, const void *src, unsigned int len, const Stream &stream)
   {
+    detail::context_check(dest.impl->context, "Can't memcpy from host memory to device memory asynchronously");
+    detail::context_check(stream.impl->context, "Can't memcpy from host memory to device memory asynchronously");
     detail::error_check(cuMemcpyHtoDAsync(dest.impl->devicePtr, src, len, stream.impl->stream),
       "Can't memcpy from host memory to device memory asynchronously");
   }
   
   void memcpy(void *dest, const DevicePtr& src, unsigned int len, const Stream &stream)
   {
+    detail::context_check(src.impl->context, "Can't memcpy from device memory to host memory asynchronously");
+    detail::context_check(stream.impl->context, "Can't memcpy from device memory to host memory asynchronously");
     detail::error_check(cuMemcpyDtoHAsync(dest, src.impl->devicePtr, len, stream.impl->stream),
       "Can't memcpy from device memory to host memory asynchronously");
   }
   
   void memset8(const DevicePtr &ptr, unsigned char value, unsigned int count)
   {
+    detail::context_check(ptr.impl->context, "Can't memset device memory (unsigned char)");
     detail::error_check(cuMemsetD8(ptr.impl->devicePtr, value, count),
       "Can't memset device memory (unsigned char)");
   }
   
   void memset16(const DevicePtr &ptr, unsigned short value, unsigned int count)
   {
+    detail::context_check(ptr.impl->context, "Can't memset device memory (unsigned short)");
     detail::error_check(cuMemsetD16(ptr.impl->devicePtr, value, count),
       "Can't memset device memory (unsigned short)");
   }
   
   void memset32(const DevicePtr &ptr, unsigned int value, unsigned int count)
   {
+    detail::context_check(ptr.impl->context, "Can't memset device memory (unsigned int)");
     detail::error_check(cuMemsetD32(ptr.impl->devicePtr, value, count),
       "Can't memset device memory (unsigned int)");
   }
 
+  void memset8(const DevicePtr &ptr, unsigned char value, unsigned int count, const Stream &stream)
+  {
+    detail::context_check(ptr.impl->context, "Can't memset device memory asynchronously (unsigned char)");
+    detail::context_check(stream.impl->context, "Can't memset device memory asynchronously (unsigned char)");
+    detail::error_check(cuMemsetD8Async(ptr.impl->devicePtr, value, count, stream.impl->stream),
+      "Can't memset device memory asynchronously (unsigned char)");
+  }
+
+  void memset32(const DevicePtr &ptr, unsigned int value, unsigned int count, const Stream &stream)
+  {
+    detail::context_check(ptr.impl->context, "Can't memset device memory asynchronously (unsigned int)");
+    detail::context_check(stream.impl->context, "Can't memset device memory asynchronously (unsigned int)");
+    detail::error_check(cuMemsetD32Async(ptr.impl->devicePtr, value, count, stream.impl->stream),
+      "Can't memset device memory asynchronously (unsigned int)");
+  }
+
   DevicePtr malloc(unsigned int size)
   {
     CUdeviceptr devPtr;
@@ -93,6 +121,7 @@ namespace cuda
       
     DevicePtr ptr;
     ptr.impl->devicePtr = devPtr;
+    ptr.impl->context = detail::current_context();
     return ptr;
   }
 
@@ -107,6 +136,7 @@ namespace cuda
     
     DevicePtr ptr;
     ptr.impl->devicePtr = devPtr;
+    ptr.impl->context = detail::current_context();
 
     pitch = p;
     return ptr;
@@ -114,6 +144,7 @@ namespace cuda
   
   void free(const DevicePtr &ptr)
   {
+    detail::context_check(ptr.impl->context, "Can't deallocate device memory");
     detail::error_check(cuMemFree(ptr.impl->devicePtr),
       "Can't deallocate device memory");
   }
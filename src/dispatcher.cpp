@@ -0,0 +1,148 @@
+#include <exception>
+#include <string>
+
+#define BOOST_BIND_GLOBAL_PLACEHOLDERS
+#include <boost/bind.hpp>
+
+#include <cudamm/dispatcher.hpp>
+#include <cudamm/exception.hpp>
+
+#include <detail/dispatcher_impl.hpp>
+
+namespace
+{
+	/// Operations run between polls while the queue is busy
+	const unsigned int pollEvery = 64;
+
+	/// Longest nap between polls while operations are pending
+	const unsigned int pollMicroseconds = 50;
+
+	/// Complete a submission with the outcome of the work its operation issued
+	void forward(const cuda::Completion &issued, const cuda::CompletionSource &source)
+	{
+		try
+		{
+			issued.wait();
+			source.complete();
+		} catch(std::exception const &e)
+		{
+			source.fail(e.what());
+		}
+	}
+}
+
+namespace cuda
+{
+	void Dispatcher::impl_t::run()
+	{
+		boost::scoped_ptr<ContextScope> scope;
+		if(context) scope.reset(new ContextScope(*context));
+
+		unsigned int sincePoll = 0;
+		for(;;)
+		{
+			item_t item;
+			if(queue.pop(item))
+			{
+				// Counted before the handle can complete
+				++executed;
+				try
+				{
+					const Completion issued = item.operation();
+					issued.then(boost::bind(forward, issued, item.source));
+				} catch(std::exception const &e)
+				{
+					item.source.fail(e.what());
+				}
+
+				// Completions keep flowing under a steady stream of submissions
+				if(poll && ++sincePoll == pollEvery)
+				{
+					sincePoll = 0;
+					poll();
+				}
+				continue;
+			}
+
+			sincePoll = 0;
+			const unsigned int pending = poll ? poll() : 0;
+
+			// Announce the sleep before the last look at the queue, producers
+			// look at idle after pushing, so one of both sees the other
+			idle = true;
+			if(!queue.empty())
+			{
+				idle = false;
+				continue;
+			}
+
+			boost::mutex::scoped_lock lock(mutex);
+			if(pending)
+			{
+				// Work on the device is tracked here, so only nap between polls
+				if(idle && !stop) condition.timed_wait(lock, boost::posix_time::microseconds(pollMicroseconds));
+			} else
+			{
+				while(idle && !stop) condition.wait(lock);
+			}
+			idle = false;
+			if(stop && queue.empty() && !pending) break;
+		}
+
+		// Stream and engine go while the context is still current
+		poll.clear();
+		resources.reset();
+	}
+
+	Dispatcher::Dispatcher(const Context::context_ptr &context)
+		: impl(new impl_t)
+	{
+		impl->context = context;
+		impl->thread.reset(new boost::thread(impl_t::run_t(impl.get())));
+	}
+
+	Dispatcher::~Dispatcher()
+	{
+		{
+			boost::mutex::scoped_lock lock(impl->mutex);
+			impl->stop = true;
+			impl->idle = false;
+		}
+		impl->condition.notify_all();
+		impl->thread->join();
+	}
+
+	Completion Dispatcher::submit(const Operation &operation)
+	{
+		impl_t::item_t item;
+		item.operation = operation;
+		impl->queue.push(item);
+		++impl->submitted;
+
+		if(impl->idle)
+		{
+			{
+				boost::mutex::scoped_lock lock(impl->mutex);
+				impl->idle = false;
+			}
+			impl->condition.notify_one();
+		}
+
+		return item.source.completion();
+	}
+
+	const Context::context_ptr& Dispatcher::context() const
+	{
+		return impl->context;
+	}
+
+	unsigned long Dispatcher::submitted() const
+	{
+		return impl->submitted;
+	}
+
+	unsigned long Dispatcher::executed() const
+	{
+		return impl->executed;
+	}
+}
@@ -0,0 +1,130 @@
+#define BOOST_BIND_GLOBAL_PLACEHOLDERS
+#include <boost/bind.hpp>
+
+#include <cudamm/completion.hpp>
+#include <cudamm/deviceptr.hpp>
+#include <cudamm/dispatcher.hpp>
+#include <cudamm/event.hpp>
+#include <cudamm/exception.hpp>
+#include <cudamm/function.hpp>
+#include <cudamm/launchrecord.hpp>
+#include <cudamm/memcpy2d.hpp>
+#include <cudamm/stream.hpp>
+
+#include <detail/dispatcher_impl.hpp>
+
+// Kept apart from the dispatcher thread so that dispatchers of generic
+// operations link without the rest of the library
+
+namespace
+{
+	/// Stream and engine of a dispatcher
+	struct resources_t
+	{
+		resources_t()
+			: stream(cuda::Stream::NON_BLOCKING)
+			, engine(false)
+		{
+		}
+
+		// The engine is destroyed first, it waits for work on the stream.
+		// It is polled by the dispatcher thread, which owns the context.
+		cuda::Stream stream;
+		cuda::CompletionEngine engine;
+	};
+
+	unsigned int pollEngine(cuda::CompletionEngine *engine)
+	{
+		engine->poll();
+		return engine->pending();
+	}
+
+	cuda::Completion copyToDevice(const cuda::DevicePtr &dest, const void *src, unsigned int len,
+		const cuda::Stream &stream, cuda::CompletionEngine &engine)
+	{
+		return engine.copy(dest, src, len, stream);
+	}
+
+	cuda::Completion copyToHost(void *dest, const cuda::DevicePtr &src, unsigned int len,
+		const cuda::Stream &stream, cuda::CompletionEngine &engine)
+	{
+		return engine.copy(dest, src, len, stream);
+	}
+
+	cuda::Completion copy2D(const cuda::Memcpy2D &copy, const cuda::Stream &stream, cuda::CompletionEngine &engine)
+	{
+		return engine.copy(copy, stream);
+	}
+
+	cuda::Completion launchFunction(const cuda::Function &function, int gridWidth, int gridHeight,
+		const cuda::Stream &stream, cuda::CompletionEngine &engine)
+	{
+		return engine.launch(function, gridWidth, gridHeight, stream);
+	}
+
+	cuda::Completion launchRecord(const cuda::LaunchRecord &record, const cuda::Stream &stream, cuda::CompletionEngine &engine)
+	{
+		return engine.launch(record, stream);
+	}
+
+	cuda::Completion recordEvent(const boost::shared_ptr<cuda::Event> &event,
+		const cuda::Stream &stream, cuda::CompletionEngine &engine)
+	{
+		event->record(stream);
+		return engine.watch(event);
+	}
+}
+
+namespace cuda
+{
+	Completion Dispatcher::runOnStream(impl_t *impl, const StreamOperation &operation)
+	{
+		if(!impl->context) throw Exception("Dispatcher without context has no stream");
+
+		// Created on the dispatcher thread, with the context current
+		if(!impl->resources)
+		{
+			resources_t *resources = new resources_t;
+			impl->resources.reset(resources);
+			impl->poll = boost::bind(pollEngine, &resources->engine);
+		}
+
+		resources_t &resources = *static_cast<resources_t *>(impl->resources.get());
+		return operation(resources.stream, resources.engine);
+	}
+
+	Completion Dispatcher::submitToStream(const StreamOperation &operation)
+	{
+		return submit(boost::bind(&Dispatcher::runOnStream, impl.get(), operation));
+	}
+
+	Completion Dispatcher::copy(const DevicePtr &dest, const void *src, unsigned int len)
+	{
+		return submitToStream(boost::bind(copyToDevice, dest, src, len, _1, _2));
+	}
+
+	Completion Dispatcher::copy(void *dest, const DevicePtr &src, unsigned int len)
+	{
+		return submitToStream(boost::bind(copyToHost, dest, src, len, _1, _2));
+	}
+
+	Completion Dispatcher::copy(const Memcpy2D &copy)
+	{
+		return submitToStream(boost::bind(copy2D, copy, _1, _2));
+	}
+
+	Completion Dispatcher::launch(const Function &function, int gridWidth, int gridHeight)
+	{
+		return submitToStream(boost::bind(launchFunction, boost::cref(function), gridWidth, gridHeight, _1, _2));
+	}
+
+	Completion Dispatcher::launch(const LaunchRecord &record)
+	{
+		return submitToStream(boost::bind(launchRecord, record, _1, _2));
+	}
+
+	Completion Dispatcher::record(const boost::shared_ptr<Event> &event)
+	{
+		return submitToStream(boost::bind(recordEvent, event, _1, _2));
+	}
+}
@@ -1,22 +1,53 @@
+#define BOOST_BIND_GLOBAL_PLACEHOLDERS
+#include <boost/bind.hpp>
+
 #include <cuda.h>
 
+#include <detail/context.hpp>
 #include <detail/error.hpp>
+#include <detail/event_impl.hpp>
 #include <detail/stream_impl.hpp>
+#include <detail/wait.hpp>
 
 #include <cudamm/event.hpp>
+#include <cudamm/waitpolicy.hpp>
 
-namespace cuda
+namespace
 {
-	struct Event::impl_t
+	/// Blocking part of a policy wait
+	struct synchronize_t
 	{
+		explicit synchronize_t(CUevent event)
+			: event(event)
+		{
+		}
+
+		void operator()() const
+		{
+			cuda::detail::error_check(cuEventSynchronize(event),
+				"Can't synchronize Cuda event");
+		}
+
 		CUevent event;
 	};
+}
 
+namespace cuda
+{
 	Event::Event()
 		: impl(new impl_t)
 	{
 		detail::error_check(cuEventCreate(&impl->event, 0),
 			"Can't create Cuda event");
+		impl->context = detail::current_context();
+	}
+
+	Event::Event(unsigned int flags)
+		: impl(new impl_t)
+	{
+		detail::error_check(cuEventCreate(&impl->event, flags),
+			"Can't create Cuda event");
+		impl->context = detail::current_context();
 	}
 	
 	Event::~Event()
@@ -27,24 +58,42 @@ namespace cuda
 	
 	void Event::record() const
 	{
+		detail::context_check(impl->context, "Can't record Cuda event");
 		detail::error_check(cuEventRecord(impl->event, 0),
 			"Can't record Cuda event");
 	}
 
 	void Event::record(const Stream &stream) const
 	{
+		detail::context_check(impl->context, "Can't record Cuda stream event");
+		detail::context_check(stream.impl->context, "Can't record Cuda stream event");
 		detail::error_check(cuEventRecord(impl->event, stream.impl->stream),
 			"Can't record Cuda stream event");
 	}
 	
 	void Event::synchronize() const
 	{
+		detail::context_check(impl->context, "Can't synchronize Cuda event");
+
+		WaitPolicy policy;
+		if(WaitPolicy::contextDefault(policy))
+		{
+			synchronize(policy);
+			return;
+		}
+
 		detail::error_check(cuEventSynchronize(impl->event),
 			"Can't synchronize Cuda event");
 	}
+
+	void Event::synchronize(const WaitPolicy &policy) const
+	{
+		detail::wait(policy, boost::bind(&Event::query, this), synchronize_t(impl->event));
+	}
 	
 	bool Event::query() const
 	{
+		detail::context_check(impl->context, "Can't query Cuda event state");
 		CUresult result = cuEventQuery(impl->event);
 		if(result == CUDA_ERROR_NOT_READY) return false;
 		detail::error_check(result, "Can't query Cuda event state");
@@ -53,6 +102,9 @@ namespace cuda
 	
 	float operator-(const Event &end, const Event &start)
 	{
+		detail::context_check(end.impl->context, "Can't get Cuda event elapsed time");
+		detail::context_check(start.impl->context, "Can't get Cuda event elapsed time");
+
 		float timer;
 		detail::error_check(cuEventElapsedTime(&timer, start.impl->event, end.impl->event),
 			"Can't get Cuda event elapsed time");
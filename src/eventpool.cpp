@@ -0,0 +1,106 @@
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+
+#include <cudamm/eventpool.hpp>
+
+namespace cuda
+{
+	struct EventPool::impl_t
+	{
+		explicit impl_t(unsigned int flags)
+			: flags(flags)
+			, created(0)
+		{
+		}
+
+		~impl_t()
+		{
+			for(std::vector<Event *>::iterator it = idle.begin(); it != idle.end(); ++it) delete *it;
+		}
+
+		/// Deleter of acquired events, keeps the pool state alive
+		struct release_t
+		{
+			explicit release_t(const boost::shared_ptr<impl_t> &pool)
+				: pool(pool)
+			{
+			}
+
+			void operator()(Event *event) const
+			{
+				boost::mutex::scoped_lock lock(pool->mutex);
+				pool->idle.push_back(event);
+			}
+
+			boost::shared_ptr<impl_t> pool;
+		};
+
+		const unsigned int flags;
+
+		mutable boost::mutex mutex;
+		std::vector<Event *> idle;
+		unsigned int created;
+	};
+
+	EventPool::EventPool(unsigned int flags)
+		: impl(new impl_t(flags))
+	{
+	}
+
+	EventPool::~EventPool()
+	{
+	}
+
+	boost::shared_ptr<Event> EventPool::acquire()
+	{
+		Event *event = 0;
+		{
+			boost::mutex::scoped_lock lock(impl->mutex);
+			if(!impl->idle.empty())
+			{
+				event = impl->idle.back();
+				impl->idle.pop_back();
+			}
+		}
+
+		if(!event)
+		{
+			event = new Event(impl->flags);
+
+			boost::mutex::scoped_lock lock(impl->mutex);
+			++impl->created;
+		}
+
+		return boost::shared_ptr<Event>(event, impl_t::release_t(impl));
+	}
+
+	void EventPool::reserve(unsigned int count)
+	{
+		while(available() < count)
+		{
+			Event *event = new Event(impl->flags);
+
+			boost::mutex::scoped_lock lock(impl->mutex);
+			++impl->created;
+			impl->idle.push_back(event);
+		}
+	}
+
+	unsigned int EventPool::available() const
+	{
+		boost::mutex::scoped_lock lock(impl->mutex);
+		return impl->idle.size();
+	}
+
+	unsigned int EventPool::created() const
+	{
+		boost::mutex::scoped_lock lock(impl->mutex);
+		return impl->created;
+	}
+
+	unsigned int EventPool::flags() const
+	{
+		return impl->flags;
+	}
+}
@@ -0,0 +1,384 @@
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <utility>
+#include <vector>
+
+#define BOOST_BIND_GLOBAL_PLACEHOLDERS
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <cudamm/exception.hpp>
+#include <cudamm/fairscheduler.hpp>
+#include <cudamm/function.hpp>
+#include <cudamm/launchrecord.hpp>
+#include <cudamm/stream.hpp>
+
+#include <detail/wait.hpp>
+
+namespace
+{
+	/// Complete a job with the outcome of its last slice
+	void completeJob(const cuda::Completion &last, const cuda::CompletionSource &source)
+	{
+		try
+		{
+			last.wait();
+			source.complete();
+		} catch(std::exception const &e)
+		{
+			source.fail(e.what());
+		}
+	}
+
+	/// Complete a job once its last slice has completed
+	void completeAfter(const cuda::Completion &last, const cuda::CompletionSource &source)
+	{
+		last.then(boost::bind(completeJob, last, source));
+	}
+
+	void failJob(const cuda::CompletionSource &source, const std::string &error)
+	{
+		source.fail(error);
+	}
+}
+
+namespace cuda
+{
+	struct FairScheduler::impl_t
+	{
+		typedef std::pair<unsigned int, unsigned int> grid_t;
+
+		// Completes or fails a job, may run continuations of the user
+		typedef boost::function<void ()> outcome_t;
+
+		struct job_t
+		{
+			job_t()
+				: next(0)
+				, submitted(detail::now())
+			{
+			}
+
+			std::vector<GridChunk> chunks;
+			unsigned int next;
+
+			// One record per grid size, grid offsets dynamic
+			std::vector<grid_t> grids;
+			std::vector<LaunchRecord> records;
+
+			CompletionSource source;
+			double submitted;
+		};
+
+		struct tenant_t
+		{
+			std::string name;
+			double weight;
+			int priority;
+
+			// Virtual finish time of the last slice issued
+			double finish;
+
+			std::deque<boost::shared_ptr<job_t> > jobs;
+			TenantStats stats;
+		};
+
+		impl_t(const Stream &stream, CompletionEngine &engine, const DeviceLimits &limits)
+			: stream(stream)
+			, engine(engine)
+			, limits(limits)
+			, sliceBlocks(0)
+			, maxInFlight(2)
+			, virtualTime(0.0)
+			, pending(0)
+		{
+		}
+
+		tenant_t& tenant(Tenant id)
+		{
+			if(id >= tenants.size()) throw Exception("Unknown tenant");
+			return tenants[id];
+		}
+
+		/// Pick the tenant to issue the next slice of
+		/**
+			@return the tenant, tenants.size() if nothing is queued
+		*/
+		unsigned int pick() const;
+
+		/// Issue the next slice of a tenant, must hold the mutex
+		/**
+			@param tenant the tenant
+			@param outcomes where to add job outcomes, to be run without the mutex
+		*/
+		void issue(tenant_t &tenant, std::vector<outcome_t> &outcomes);
+
+		const Stream &stream;
+		CompletionEngine &engine;
+		DeviceLimits limits;
+		unsigned int sliceBlocks, maxInFlight;
+
+		mutable boost::mutex mutex;
+		std::vector<tenant_t> tenants;
+		double virtualTime;
+		unsigned long pending;
+
+		// Slices on the stream, oldest first
+		std::deque<Completion> inFlight;
+	};
+
+	unsigned int FairScheduler::impl_t::pick() const
+	{
+		unsigned int best = tenants.size();
+		double bestStart = 0.0;
+
+		for(unsigned int i = 0; i < tenants.size(); ++i)
+		{
+			const tenant_t &tenant = tenants[i];
+			if(tenant.jobs.empty()) continue;
+
+			const double start = std::max(virtualTime, tenant.finish);
+			if(best == tenants.size() || tenant.priority > tenants[best].priority
+				|| (tenant.priority == tenants[best].priority && start < bestStart))
+			{
+				best = i;
+				bestStart = start;
+			}
+		}
+
+		return best;
+	}
+
+	void FairScheduler::impl_t::issue(tenant_t &tenant, std::vector<outcome_t> &outcomes)
+	{
+		const boost::shared_ptr<job_t> job = tenant.jobs.front();
+		const GridChunk &chunk = job->chunks[job->next];
+		const unsigned int blocks = chunk.gridX * chunk.gridY;
+
+		// A slice that fails to launch does not use its share
+		const double lastVirtualTime = virtualTime, lastFinish = tenant.finish;
+		const double start = std::max(virtualTime, tenant.finish);
+		virtualTime = start;
+		tenant.finish = start + blocks / tenant.weight;
+
+		if(!job->next)
+		{
+			const double delay = detail::now() - job->submitted;
+			tenant.stats.totalDelayMicroseconds += delay;
+			tenant.stats.maxDelayMicroseconds = std::max(tenant.stats.maxDelayMicroseconds, delay);
+			--tenant.stats.queued;
+		}
+
+		const bool last = job->next + 1 == job->chunks.size();
+		++job->next;
+		--pending;
+		if(last)
+		{
+			tenant.jobs.pop_front();
+			++tenant.stats.issued;
+		}
+
+		try
+		{
+			const grid_t grid(chunk.gridX, chunk.gridY);
+			const unsigned int record = std::find(job->grids.begin(), job->grids.end(), grid) - job->grids.begin();
+
+			const int offsets[3] = {
+				static_cast<int>(chunk.offsetX),
+				static_cast<int>(chunk.offsetY),
+				static_cast<int>(chunk.offsetZ) };
+			job->records[record].replay(stream, offsets);
+
+			const Completion slice = engine.enqueue(stream);
+			inFlight.push_back(slice);
+			++tenant.stats.slices;
+			tenant.stats.blocks += blocks;
+
+			if(last) outcomes.push_back(boost::bind(completeAfter, slice, job->source));
+		} catch(std::exception const &e)
+		{
+			virtualTime = lastVirtualTime;
+			tenant.finish = lastFinish;
+
+			// A job that fails to launch drops its remaining slices
+			if(!last)
+			{
+				pending -= job->chunks.size() - job->next;
+				tenant.jobs.pop_front();
+				++tenant.stats.issued;
+			}
+			outcomes.push_back(boost::bind(failJob, job->source, std::string(e.what())));
+		}
+	}
+
+	FairScheduler::FairScheduler(const Stream &stream, CompletionEngine &engine, const DeviceLimits &limits)
+		: impl(new impl_t(stream, engine, limits))
+	{
+	}
+
+	FairScheduler::~FairScheduler()
+	{
+		for(std::vector<impl_t::tenant_t>::iterator tenant = impl->tenants.begin(); tenant != impl->tenants.end(); ++tenant)
+		{
+			while(!tenant->jobs.empty())
+			{
+				tenant->jobs.front()->source.fail("Fair scheduler destroyed before issuing the job");
+				tenant->jobs.pop_front();
+			}
+		}
+	}
+
+	FairScheduler& FairScheduler::setSliceBlocks(unsigned int blocks)
+	{
+		boost::mutex::scoped_lock lock(impl->mutex);
+		impl->sliceBlocks = blocks;
+		return *this;
+	}
+
+	FairScheduler& FairScheduler::setMaxInFlight(unsigned int slices)
+	{
+		boost::mutex::scoped_lock lock(impl->mutex);
+		impl->maxInFlight = std::max(slices, 1u);
+		return *this;
+	}
+
+	FairScheduler::Tenant FairScheduler::addTenant(const std::string &name, double weight, int priority)
+	{
+		if(weight <= 0.0) throw Exception("Tenant weight must be positive");
+
+		impl_t::tenant_t tenant;
+		tenant.name = name;
+		tenant.weight = weight;
+		tenant.priority = priority;
+		tenant.finish = 0.0;
+		tenant.stats = TenantStats();
+
+		boost::mutex::scoped_lock lock(impl->mutex);
+		impl->tenants.push_back(tenant);
+		return impl->tenants.size() - 1;
+	}
+
+	void FairScheduler::setWeight(Tenant tenant, double weight)
+	{
+		if(weight <= 0.0) throw Exception("Tenant weight must be positive");
+
+		boost::mutex::scoped_lock lock(impl->mutex);
+		impl->tenant(tenant).weight = weight;
+	}
+
+	void FairScheduler::setPriority(Tenant tenant, int priority)
+	{
+		boost::mutex::scoped_lock lock(impl->mutex);
+		impl->tenant(tenant).priority = priority;
+	}
+
+	Completion FairScheduler::submit(Tenant tenant, const Function &function, int offsetParameter,
+		const Extent &problem, const Extent &block)
+	{
+		boost::shared_ptr<impl_t::job_t> job(new impl_t::job_t);
+
+		unsigned int sliceBlocks;
+		{
+			boost::mutex::scoped_lock lock(impl->mutex);
+			impl->tenant(tenant);
+			sliceBlocks = impl->sliceBlocks;
+		}
+
+		job->chunks = splitGrid(problem, block, impl->limits, sliceBlocks);
+		if(job->chunks.empty())
+		{
+			job->source.complete();
+			return job->source.completion();
+		}
+
+		{
+			Function::ScopedLock lock(function);
+			function.setBlockShape(block.x, block.y, block.z);
+
+			for(std::vector<GridChunk>::const_iterator chunk = job->chunks.begin(); chunk != job->chunks.end(); ++chunk)
+			{
+				const impl_t::grid_t grid(chunk->gridX, chunk->gridY);
+				if(std::find(job->grids.begin(), job->grids.end(), grid) != job->grids.end()) continue;
+
+				job->grids.push_back(grid);
+				job->records.push_back(LaunchRecord(function, chunk->gridX, chunk->gridY));
+				job->records.back().dynamic(offsetParameter, 3 * sizeof(int));
+			}
+		}
+
+		boost::mutex::scoped_lock lock(impl->mutex);
+		impl_t::tenant_t &t = impl->tenant(tenant);
+		t.jobs.push_back(job);
+		++t.stats.submitted;
+		++t.stats.queued;
+		impl->pending += job->chunks.size();
+		return job->source.completion();
+	}
+
+	unsigned int FairScheduler::schedule()
+	{
+		std::vector<impl_t::outcome_t> outcomes;
+		unsigned int issued = 0;
+		{
+			boost::mutex::scoped_lock lock(impl->mutex);
+
+			while(!impl->inFlight.empty() && impl->inFlight.front().ready()) impl->inFlight.pop_front();
+
+			while(impl->inFlight.size() < impl->maxInFlight)
+			{
+				const unsigned int tenant = impl->pick();
+				if(tenant == impl->tenants.size()) break;
+
+				impl->issue(impl->tenants[tenant], outcomes);
+				++issued;
+			}
+		}
+
+		// Continuations may call back into the scheduler
+		for(std::vector<impl_t::outcome_t>::const_iterator it = outcomes.begin(); it != outcomes.end(); ++it) (*it)();
+		return issued;
+	}
+
+	void FairScheduler::drain()
+	{
+		for(;;)
+		{
+			schedule();
+
+			Completion oldest;
+			{
+				boost::mutex::scoped_lock lock(impl->mutex);
+				if(impl->inFlight.empty())
+				{
+					if(!impl->pending) break;
+					continue;
+				}
+				oldest = impl->inFlight.front();
+			}
+
+			// Slices complete in order on the stream
+			oldest.wait();
+		}
+	}
+
+	unsigned long FairScheduler::queued() const
+	{
+		boost::mutex::scoped_lock lock(impl->mutex);
+		return impl->pending;
+	}
+
+	std::string FairScheduler::name(Tenant tenant) const
+	{
+		boost::mutex::scoped_lock lock(impl->mutex);
+		return impl->tenant(tenant).name;
+	}
+
+	TenantStats FairScheduler::stats(Tenant tenant) const
+	{
+		boost::mutex::scoped_lock lock(impl->mutex);
+		return impl->tenant(tenant).stats;
+	}
+}
@@ -1,69 +1,119 @@
 #include <cuda.h>
 #include <iostream>
+#include <string>
 
+#include <cudamm/exception.hpp>
 #include <cudamm/function.hpp>
 #include <cudamm/module.hpp>
 #include <cudamm/texturereference.hpp>
 #include <cudamm/stream.hpp>
 
+#include <detail/context.hpp>
 #include <detail/error.hpp>
 #include <detail/module_impl.hpp> 
+#include <detail/function_impl.hpp>
 #include <detail/texturereference_impl.hpp>
 #include <detail/stream_impl.hpp>
 #include <detail/deviceptr_impl.hpp>
 
 namespace cuda
 {
-	struct Function::impl_t
+	Function::Function(Module &module, const char *name)
+		: impl(new impl_t)
 	{
-		CUfunction func;
-	};
+		impl->state = module.impl->function(name);
+		impl->func = impl->state->func;
+		impl->name = name;
+		impl->moduleHash = module.impl->hash;
+	}
 
-	Function::Function(Module &module, const char *name)
+	Function::Function(Module &module, const char *name, const CubinInfo &info)
 		: impl(new impl_t)
 	{
-		detail::error_check(cuModuleGetFunction(&impl->func, module.impl->mod, name),
-			"Can't get Cuda function");
+		impl->cubin.reset(new CubinKernel(info.kernel(name)));
+		impl->state = module.impl->function(name);
+		impl->func = impl->state->func;
+		impl->name = name;
+		impl->moduleHash = module.impl->hash;
 	}
 
 	Function::~Function()
 	{
 	}
 	
+	const char *Function::name() const
+	{
+		return impl->name.c_str();
+	}
+
+	const std::string& Function::moduleHash() const
+	{
+		return impl->moduleHash;
+	}
+
 	void Function::setBlockShape(int x, int y, int z) const
 	{
+		ScopedLock lock(*this);
+
 		detail::error_check(cuFuncSetBlockShape(impl->func, x, y, z),
 			"Can't set Cuda function block shape");
+
+		impl->state->blockX = x;
+		impl->state->blockY = y;
+		impl->state->blockZ = z;
 	}
 	
 	void Function::setSharedSize(unsigned int bytes) const
 	{
+		ScopedLock lock(*this);
+
 		detail::error_check(cuFuncSetSharedSize(impl->func, bytes),
 			"Can't set Cuda function shared memory size");
+
+		impl->state->sharedSize = bytes;
+		impl->state->sharedSizeKnown = true;
 	}
 	
 	void Function::setParameterSize(unsigned int bytes) const
 	{
+		ScopedLock lock(*this);
+
 		detail::error_check(cuParamSetSize(impl->func, bytes),
 			"Can't set Cuda function parameter size");
+
+		impl->state->parameterSize = bytes;
+		impl->state->parameterSizeKnown = true;
 	}
 	
 	void Function::setParameter(int offset, int value) const
 	{
+		ScopedLock lock(*this);
+
 		detail::error_check(cuParamSeti(impl->func, offset, value),
 			"Can't set Cuda function parameter (int)");
+
+		const unsigned int temp = value;
+		impl->state->setParameters(offset, &temp, sizeof(temp));
 	}
 	
 	void Function::setParameter(int offset, float value) const
 	{
+		ScopedLock lock(*this);
+
 		detail::error_check(cuParamSetf(impl->func, offset, value),
 			"Can't set Cuda function parameter (float)");
+
+		impl->state->setParameters(offset, &value, sizeof(value));
 	}
 	
 	void Function::setParameter(int offset, void *data, unsigned int len) const
 	{
+		ScopedLock lock(*this);
+
 		detail::error_check(cuParamSetv(impl->func, offset, data, len),
 			"Can't set Cuda function parameter");
+
+		impl->state->setParameters(offset, data, len);
 	}
 
 	void Function::setParameter(int offset, const DevicePtr &ptr) const
@@ -73,18 +123,24 @@ namespace cuda
 	
 	void Function::launch() const
 	{
+		ScopedLock lock(*this);
+
 		detail::error_check(cuLaunch(impl->func),
 			"Can't launch Cuda function");
 	}
 	
 	void Function::launch(int gridWidth, int gridHeight) const
 	{
+		ScopedLock lock(*this);
+
 		detail::error_check(cuLaunchGrid(impl->func, gridWidth, gridHeight),
 			"Can't launch Cuda function grid");
 	}
 	
 	void Function::launch(int gridWidth, int gridHeight, const Stream &stream) const
 	{
+		ScopedLock lock(*this);
+
     //std::cout << "DOIN IT" << std::endl;
 		detail::error_check(
 			cuLaunchGridAsync(impl->func, gridWidth, gridHeight, stream.impl->stream),
@@ -93,11 +149,65 @@ namespace cuda
 		
 	void Function::useTexture(const TextureReference &texref) const
 	{	
+		ScopedLock lock(*this);
+		detail::context_check(texref.impl->context, "Can't use Cuda texture reference in function");
+
 		detail::error_check(cuParamSetTexRef(impl->func, CU_PARAM_TR_DEFAULT, texref.impl->texref),
 			"Can't use Cuda texture reference in function");
+
+		if(!impl->state->usesTexture(texref.impl->texref)) impl->state->textures.push_back(texref.impl->texref);
 	}
 
-}
+	void Function::checkParameters(const std::vector<CubinParameter> &layout) const
+	{
+		if(!impl->cubin) throw Exception((std::string("No cubin metadata for Cuda function ") + impl->name).c_str());
+		impl->cubin->checkParameters(layout);
+	}
+
+	unsigned int Function::registers() const
+	{
+		int value;
+		detail::error_check(cuFuncGetAttribute(&value, CU_FUNC_ATTRIBUTE_NUM_REGS, impl->func),
+			"Can't get Cuda function register count");
+		return static_cast<unsigned int>(value);
+	}
+
+	unsigned int Function::staticSharedSize() const
+	{
+		int value;
+		detail::error_check(cuFuncGetAttribute(&value, CU_FUNC_ATTRIBUTE_SHARED_SIZE_BYTES, impl->func),
+			"Can't get Cuda function shared memory size");
+		return static_cast<unsigned int>(value);
+	}
+
+	unsigned int Function::localSize() const
+	{
+		int value;
+		detail::error_check(cuFuncGetAttribute(&value, CU_FUNC_ATTRIBUTE_LOCAL_SIZE_BYTES, impl->func),
+			"Can't get Cuda function local memory size");
+		return static_cast<unsigned int>(value);
+	}
+
+	unsigned int Function::maxThreadsPerBlock() const
+	{
+		int value;
+		detail::error_check(cuFuncGetAttribute(&value, CU_FUNC_ATTRIBUTE_MAX_THREADS_PER_BLOCK, impl->func),
+			"Can't get Cuda function maximum block size");
+		return static_cast<unsigned int>(value);
+	}
+
+	Function::ScopedLock::ScopedLock(const Function &function)
+		: function(function)
+	{
+		detail::context_check(function.impl->state->context, "Can't use Cuda function");
+		function.impl->state->mutex.lock();
+	}
+
+	Function::ScopedLock::~ScopedLock()
+	{
+		function.impl->state->mutex.unlock();
+	}
 
+}
 
 
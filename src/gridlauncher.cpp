@@ -0,0 +1,106 @@
+#include <algorithm>
+
+#include <cudamm/exception.hpp>
+#include <cudamm/function.hpp>
+#include <cudamm/stream.hpp>
+#include <cudamm/gridlauncher.hpp>
+
+namespace
+{
+	/// Rounded up division that does not wrap for a close to UINT_MAX
+	inline unsigned int divUp(unsigned int a, unsigned int b)
+	{
+		return a / b + (a % b != 0);
+	}
+}
+
+namespace cuda
+{
+	std::vector<GridChunk> splitGrid(const Extent &problem, const Extent &block,
+		const DeviceLimits &limits, unsigned int maxBlocksPerLaunch)
+	{
+		if(!block.x || !block.y || !block.z) throw Exception("Empty block shape");
+
+		const unsigned int gridX = divUp(problem.x, block.x);
+		const unsigned int gridY = divUp(problem.y, block.y);
+		const unsigned int gridZ = divUp(problem.z, block.z);
+
+		// Chunk size: as wide as allowed, then as many rows as the block budget leaves
+		unsigned int chunkX = std::min(gridX, limits.maxGridDimX);
+		if(maxBlocksPerLaunch) chunkX = std::min(chunkX, maxBlocksPerLaunch);
+		unsigned int chunkY = std::min(gridY, limits.maxGridDimY);
+		if(maxBlocksPerLaunch) chunkY = std::max(1u, std::min(chunkY, maxBlocksPerLaunch / std::max(chunkX, 1u)));
+
+		std::vector<GridChunk> chunks;
+		for(unsigned int z = 0; z < gridZ; ++z)
+		{
+			// Steps are clamped to the grid so the offsets can't wrap
+			for(unsigned int y = 0; y < gridY; y += std::min(chunkY, gridY - y))
+			{
+				for(unsigned int x = 0; x < gridX; x += std::min(chunkX, gridX - x))
+				{
+					GridChunk chunk;
+					chunk.offsetX = x;
+					chunk.offsetY = y;
+					chunk.offsetZ = z;
+					chunk.gridX = std::min(chunkX, gridX - x);
+					chunk.gridY = std::min(chunkY, gridY - y);
+					chunks.push_back(chunk);
+				}
+			}
+		}
+
+		return chunks;
+	}
+
+	GridLauncher::GridLauncher(const Function &function, int offsetParameter)
+		: function(function)
+		, offsetParameter(offsetParameter)
+		, limits(DeviceLimits::current())
+		, maxBlocks(0)
+	{
+	}
+
+	GridLauncher::GridLauncher(const Function &function, int offsetParameter, const DeviceLimits &limits)
+		: function(function)
+		, offsetParameter(offsetParameter)
+		, limits(limits)
+		, maxBlocks(0)
+	{
+	}
+
+	GridLauncher& GridLauncher::maxBlocksPerLaunch(unsigned int blocks)
+	{
+		maxBlocks = blocks;
+		return *this;
+	}
+
+	void GridLauncher::launch(const Extent &problem, const Extent &block) const
+	{
+		launch(problem, block, static_cast<const Stream *>(0));
+	}
+
+	void GridLauncher::launch(const Extent &problem, const Extent &block, const Stream &stream) const
+	{
+		launch(problem, block, &stream);
+	}
+
+	void GridLauncher::launch(const Extent &problem, const Extent &block, const Stream *stream) const
+	{
+		const std::vector<GridChunk> chunks = splitGrid(problem, block, limits, maxBlocks);
+
+		// Other threads must not change the offsets between setting and launching
+		Function::ScopedLock lock(function);
+
+		function.setBlockShape(block.x, block.y, block.z);
+		for(std::vector<GridChunk>::const_iterator chunk = chunks.begin(); chunk != chunks.end(); ++chunk)
+		{
+			function.setParameter(offsetParameter, static_cast<int>(chunk->offsetX));
+			function.setParameter(offsetParameter + 4, static_cast<int>(chunk->offsetY));
+			function.setParameter(offsetParameter + 8, static_cast<int>(chunk->offsetZ));
+
+			if(stream) function.launch(chunk->gridX, chunk->gridY, *stream);
+			else function.launch(chunk->gridX, chunk->gridY);
+		}
+	}
+}
@@ -0,0 +1,259 @@
+#include <iostream>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <cudamm/event.hpp>
+#include <cudamm/exception.hpp>
+#include <cudamm/haloexchange.hpp>
+#include <cudamm/hostmemory.hpp>
+#include <cudamm/memcpy2d.hpp>
+#include <cudamm/stream.hpp>
+
+namespace cuda
+{
+	struct HaloExchange::impl_t
+	{
+		/// Exchange resources of one part, living in its context
+		struct part_t
+		{
+			HaloPartition partition;
+			boost::scoped_ptr<Stream> stream;
+
+			// Boundaries are ready to be copied, halos have arrived
+			boost::scoped_ptr<Event> ready, done;
+		};
+
+		/// Copy of a boundary into a neighbour's halo through host staging
+		struct transfer_t
+		{
+			unsigned int src, dest;
+			unsigned int srcX, srcY, destX, destY;
+			unsigned int widthBytes, height;
+
+			boost::scoped_ptr<HostMemory> staging;
+
+			// Staged, in the source context; halo written, in the destination context
+			boost::scoped_ptr<Event> staged, consumed;
+			bool pending;
+		};
+
+		impl_t()
+			: halo(0)
+			, bytes(0)
+			, begun(false)
+		{
+		}
+
+		void addTransfer(unsigned int src, unsigned int srcX, unsigned int srcY,
+			unsigned int dest, unsigned int destX, unsigned int destY,
+			unsigned int widthBytes, unsigned int height);
+
+		std::vector<boost::shared_ptr<part_t> > parts;
+		std::vector<boost::shared_ptr<transfer_t> > transfers;
+
+		unsigned int halo;
+		unsigned long bytes;
+		bool begun;
+	};
+
+	void HaloExchange::impl_t::addTransfer(unsigned int src, unsigned int srcX, unsigned int srcY,
+		unsigned int dest, unsigned int destX, unsigned int destY,
+		unsigned int widthBytes, unsigned int height)
+	{
+		boost::shared_ptr<transfer_t> transfer(new transfer_t);
+		transfer->src = src;
+		transfer->dest = dest;
+		transfer->srcX = srcX;
+		transfer->srcY = srcY;
+		transfer->destX = destX;
+		transfer->destY = destY;
+		transfer->widthBytes = widthBytes;
+		transfer->height = height;
+		transfer->pending = false;
+		transfers.push_back(transfer);
+
+		{
+			// Portable, so the destination context copies from it as well
+			ContextScope scope(*parts[src]->partition.context);
+			transfer->staging.reset(new HostMemory(widthBytes * height, true));
+			transfer->staged.reset(new Event(Event::DISABLE_TIMING));
+		}
+		{
+			ContextScope scope(*parts[dest]->partition.context);
+			transfer->consumed.reset(new Event(Event::DISABLE_TIMING));
+		}
+
+		bytes += static_cast<unsigned long>(widthBytes) * height;
+	}
+
+	HaloExchange::HaloExchange(const std::vector<HaloPartition> &partitions, unsigned int halo,
+		unsigned int elementSize, Partitioner::Split split)
+		: impl(new impl_t)
+	{
+		impl->halo = halo;
+
+		for(std::vector<HaloPartition>::const_iterator it = partitions.begin(); it != partitions.end(); ++it)
+		{
+			if(!it->context || !it->stream) throw Exception("Halo partition without context or stream");
+			if((split == Partitioner::ROWS ? it->height : it->width) < halo)
+				throw Exception("Halo partition smaller than the halo");
+
+			boost::shared_ptr<impl_t::part_t> part(new impl_t::part_t);
+			part->partition = *it;
+			impl->parts.push_back(part);
+
+			ContextScope scope(*it->context);
+			part->stream.reset(new Stream(Stream::NON_BLOCKING));
+			part->ready.reset(new Event(Event::DISABLE_TIMING));
+			part->done.reset(new Event(Event::DISABLE_TIMING));
+		}
+
+		if(!halo) return;
+
+		for(unsigned int i = 0; i + 1 < partitions.size(); ++i)
+		{
+			const HaloPartition &a = partitions[i];
+			const HaloPartition &b = partitions[i + 1];
+
+			if(split == Partitioner::ROWS)
+			{
+				if(a.width != b.width) throw Exception("Halo partitions of different width");
+				const unsigned int widthBytes = a.width * elementSize;
+
+				// Last interior rows of a to the top halo of b, first interior rows of b to the bottom halo of a
+				impl->addTransfer(i, 0, a.height, i + 1, 0, 0, widthBytes, halo);
+				impl->addTransfer(i + 1, 0, halo, i, 0, halo + a.height, widthBytes, halo);
+			}
+			else
+			{
+				if(a.height != b.height) throw Exception("Halo partitions of different height");
+				const unsigned int widthBytes = halo * elementSize;
+
+				// Same for columns, left to right
+				impl->addTransfer(i, a.width * elementSize, 0, i + 1, 0, 0, widthBytes, a.height);
+				impl->addTransfer(i + 1, halo * elementSize, 0, i, (halo + a.width) * elementSize, 0, widthBytes, a.height);
+			}
+		}
+	}
+
+	HaloExchange::~HaloExchange()
+	{
+		for(std::vector<boost::shared_ptr<impl_t::part_t> >::iterator it = impl->parts.begin(); it != impl->parts.end(); ++it)
+		{
+			try
+			{
+				ContextScope scope(*(*it)->partition.context);
+				(*it)->stream->synchronize();
+			} catch(Exception const &e)
+			{
+				std::cerr << e.what() << std::endl;
+			}
+		}
+
+		// Events and staging memory are freed in the context they were created in
+		for(std::vector<boost::shared_ptr<impl_t::transfer_t> >::iterator it = impl->transfers.begin(); it != impl->transfers.end(); ++it)
+		{
+			{
+				ContextScope scope(*impl->parts[(*it)->src]->partition.context);
+				(*it)->staged.reset();
+				(*it)->staging.reset();
+			}
+			{
+				ContextScope scope(*impl->parts[(*it)->dest]->partition.context);
+				(*it)->consumed.reset();
+			}
+		}
+
+		for(std::vector<boost::shared_ptr<impl_t::part_t> >::iterator it = impl->parts.begin(); it != impl->parts.end(); ++it)
+		{
+			ContextScope scope(*(*it)->partition.context);
+			(*it)->ready.reset();
+			(*it)->done.reset();
+			(*it)->stream.reset();
+		}
+	}
+
+	void HaloExchange::beginExchange()
+	{
+		if(impl->begun) throw Exception("Halo exchange already begun");
+
+		// Exchange streams start where the stencil streams are now
+		for(std::vector<boost::shared_ptr<impl_t::part_t> >::iterator it = impl->parts.begin(); it != impl->parts.end(); ++it)
+		{
+			impl_t::part_t &part = **it;
+			ContextScope scope(*part.partition.context);
+			part.ready->record(*part.partition.stream);
+			part.stream->wait(*part.ready);
+		}
+
+		for(std::vector<boost::shared_ptr<impl_t::transfer_t> >::iterator it = impl->transfers.begin(); it != impl->transfers.end(); ++it)
+		{
+			impl_t::transfer_t &transfer = **it;
+			impl_t::part_t &src = *impl->parts[transfer.src];
+			ContextScope scope(*src.partition.context);
+
+			// The staging buffer is free once the last exchange has written the halo
+			if(transfer.pending) src.stream->wait(*transfer.consumed);
+
+			Memcpy2D(transfer.widthBytes, transfer.height)
+				.source(src.partition.buffer, src.partition.pitch)
+				.sourcePos(transfer.srcX, transfer.srcY)
+				.destination(transfer.staging->ptr(), transfer.widthBytes)
+				.copy(*src.stream);
+			transfer.staged->record(*src.stream);
+		}
+
+		for(std::vector<boost::shared_ptr<impl_t::transfer_t> >::iterator it = impl->transfers.begin(); it != impl->transfers.end(); ++it)
+		{
+			impl_t::transfer_t &transfer = **it;
+			impl_t::part_t &dest = *impl->parts[transfer.dest];
+			ContextScope scope(*dest.partition.context);
+
+			// Waits on the device, across contexts
+			dest.stream->wait(*transfer.staged);
+
+			Memcpy2D(transfer.widthBytes, transfer.height)
+				.source(transfer.staging->ptr(), transfer.widthBytes)
+				.destination(dest.partition.buffer, dest.partition.pitch)
+				.destinationPos(transfer.destX, transfer.destY)
+				.copy(*dest.stream);
+			transfer.consumed->record(*dest.stream);
+			transfer.pending = true;
+		}
+
+		for(std::vector<boost::shared_ptr<impl_t::part_t> >::iterator it = impl->parts.begin(); it != impl->parts.end(); ++it)
+		{
+			impl_t::part_t &part = **it;
+			ContextScope scope(*part.partition.context);
+			part.done->record(*part.stream);
+		}
+
+		impl->begun = true;
+	}
+
+	void HaloExchange::finishExchange()
+	{
+		if(!impl->begun) throw Exception("Halo exchange not begun");
+
+		for(std::vector<boost::shared_ptr<impl_t::part_t> >::iterator it = impl->parts.begin(); it != impl->parts.end(); ++it)
+		{
+			impl_t::part_t &part = **it;
+			ContextScope scope(*part.partition.context);
+			part.partition.stream->wait(*part.done);
+		}
+
+		impl->begun = false;
+	}
+
+	unsigned int HaloExchange::halo() const
+	{
+		return impl->halo;
+	}
+
+	unsigned long HaloExchange::bytes() const
+	{
+		return impl->bytes;
+	}
+}
@@ -0,0 +1,22 @@
+#include <cuda.h>
+
+#include <cudamm/hostmemory.hpp>
+
+#include <detail/error.hpp>
+
+namespace cuda
+{
+	void *mallocHost(unsigned int size, bool portable)
+	{
+		void *ptr;
+		detail::error_check(cuMemHostAlloc(&ptr, size, portable ? CU_MEMHOSTALLOC_PORTABLE : 0),
+			"Can't allocate page locked host memory");
+		return ptr;
+	}
+
+	void freeHost(void *ptr)
+	{
+		detail::error_check(cuMemFreeHost(ptr),
+			"Can't deallocate page locked host memory");
+	}
+}
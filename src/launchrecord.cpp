@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <cuda.h>
+
+#include <cudamm/exception.hpp>
+#include <cudamm/function.hpp>
+#include <cudamm/stream.hpp>
+#include <cudamm/launchrecord.hpp>
+
+#include <detail/context.hpp>
+#include <detail/error.hpp>
+#include <detail/function_impl.hpp>
+#include <detail/stream_impl.hpp>
+
+namespace
+{
+	/// Largest parameter space of a kernel
+	const unsigned int maxParameterBytes = 4096;
+
+	/// Send the parameter bytes that differ from the last ones set on the function
+	void updateParameters(cuda::detail::function_state_t &state, const unsigned char *desired, unsigned int size)
+	{
+		const unsigned int known = std::min(size, static_cast<unsigned int>(state.known.size()));
+
+		unsigned int i = 0;
+		while(i < size)
+		{
+			if(i < known && state.known[i] && state.parameters[i] == desired[i])
+			{
+				++i;
+				continue;
+			}
+
+			unsigned int j = i + 1;
+			while(j < size && !(j < known && state.known[j] && state.parameters[j] == desired[j])) ++j;
+
+			cuda::detail::error_check(cuParamSetv(state.func, i, const_cast<unsigned char *>(desired + i), j - i),
+				"Can't set Cuda function parameter");
+			state.setParameters(i, desired + i, j - i);
+			i = j;
+		}
+	}
+}
+
+namespace cuda
+{
+	struct LaunchRecord::impl_t
+	{
+		typedef std::vector<std::pair<unsigned int, unsigned int> > ranges_t;
+
+		boost::shared_ptr<detail::function_state_t> state;
+
+		int gridWidth, gridHeight;
+		int blockX, blockY, blockZ;
+		unsigned int sharedSize;
+		unsigned int parameterSize;
+		std::vector<unsigned char> parameters;
+		std::vector<CUtexref> textures;
+
+		// Dynamic ranges as (offset, size)
+		ranges_t dynamic;
+		unsigned int dynamicSize;
+	};
+
+	LaunchRecord::LaunchRecord(const Function &function, int gridWidth, int gridHeight)
+		: impl(new impl_t)
+	{
+		detail::function_state_t &state = *function.impl->state;
+		boost::recursive_mutex::scoped_lock lock(state.mutex);
+
+		if(!state.blockX) throw Exception("Can't record Cuda launch without block shape");
+		if(!state.parameterSizeKnown) throw Exception("Can't record Cuda launch without parameter size");
+		if(state.parameterSize > maxParameterBytes) throw Exception("Cuda function parameters too large to record");
+
+		impl->state = function.impl->state;
+		impl->gridWidth = gridWidth;
+		impl->gridHeight = gridHeight;
+		impl->blockX = state.blockX;
+		impl->blockY = state.blockY;
+		impl->blockZ = state.blockZ;
+		impl->sharedSize = state.sharedSizeKnown ? state.sharedSize : 0;
+		impl->parameterSize = state.parameterSize;
+		impl->textures = state.textures;
+		impl->dynamicSize = 0;
+
+		impl->parameters.assign(state.parameterSize, 0);
+		for(unsigned int i = 0; i < state.parameterSize && i < state.parameters.size(); ++i)
+		{
+			if(state.known[i]) impl->parameters[i] = state.parameters[i];
+		}
+	}
+
+	LaunchRecord::LaunchRecord(const LaunchRecord &copy)
+		: impl(new impl_t(*copy.impl))
+	{
+	}
+
+	LaunchRecord::~LaunchRecord()
+	{
+	}
+
+	LaunchRecord& LaunchRecord::dynamic(int offset, unsigned int len)
+	{
+		if(offset < 0 || offset + len > impl->parameterSize) throw Exception("Dynamic range outside of Cuda function parameters");
+
+		impl->dynamic.push_back(impl_t::ranges_t::value_type(offset, len));
+		impl->dynamicSize += len;
+		return *this;
+	}
+
+	unsigned int LaunchRecord::dynamicSize() const
+	{
+		return impl->dynamicSize;
+	}
+
+	void LaunchRecord::replay(const Stream &stream) const
+	{
+		replay(stream, 0);
+	}
+
+	void LaunchRecord::replay(const Stream &stream, const void *dynamicData) const
+	{
+		detail::function_state_t &state = *impl->state;
+		boost::recursive_mutex::scoped_lock lock(state.mutex);
+		detail::context_check(state.context, "Can't replay Cuda function launch");
+		detail::context_check(stream.impl->context, "Can't replay Cuda function launch");
+
+		if(state.blockX != impl->blockX || state.blockY != impl->blockY || state.blockZ != impl->blockZ)
+		{
+			detail::error_check(cuFuncSetBlockShape(state.func, impl->blockX, impl->blockY, impl->blockZ),
+				"Can't set Cuda function block shape");
+			state.blockX = impl->blockX;
+			state.blockY = impl->blockY;
+			state.blockZ = impl->blockZ;
+		}
+
+		if(!state.sharedSizeKnown || state.sharedSize != impl->sharedSize)
+		{
+			detail::error_check(cuFuncSetSharedSize(state.func, impl->sharedSize),
+				"Can't set Cuda function shared memory size");
+			state.sharedSize = impl->sharedSize;
+			state.sharedSizeKnown = true;
+		}
+
+		for(std::vector<CUtexref>::const_iterator it = impl->textures.begin(); it != impl->textures.end(); ++it)
+		{
+			if(state.usesTexture(*it)) continue;
+			detail::error_check(cuParamSetTexRef(state.func, CU_PARAM_TR_DEFAULT, *it),
+				"Can't use Cuda texture reference in function");
+			state.textures.push_back(*it);
+		}
+
+		if(impl->parameterSize)
+		{
+			const unsigned char *desired = &impl->parameters[0];
+
+			unsigned char buffer[maxParameterBytes];
+			if(dynamicData && !impl->dynamic.empty())
+			{
+				std::memcpy(buffer, desired, impl->parameterSize);
+
+				const unsigned char *src = static_cast<const unsigned char *>(dynamicData);
+				for(impl_t::ranges_t::const_iterator it = impl->dynamic.begin(); it != impl->dynamic.end(); ++it)
+				{
+					std::memcpy(buffer + it->first, src, it->second);
+					src += it->second;
+				}
+				desired = buffer;
+			}
+
+			updateParameters(state, desired, impl->parameterSize);
+		}
+
+		if(!state.parameterSizeKnown || state.parameterSize != impl->parameterSize)
+		{
+			detail::error_check(cuParamSetSize(state.func, impl->parameterSize),
+				"Can't set Cuda function parameter size");
+			state.parameterSize = impl->parameterSize;
+			state.parameterSizeKnown = true;
+		}
+
+		detail::error_check(
+			cuLaunchGridAsync(state.func, impl->gridWidth, impl->gridHeight, stream.impl->stream),
+			"Can't launch asynchronous Cuda function grid");
+	}
+}
@@ -9,21 +9,23 @@
 #include <detail/stream_impl.hpp>
 #include <detail/deviceptr_impl.hpp>
 #include <detail/array_impl.hpp>
+#include <detail/memcpy2d_impl.hpp>
 
 namespace cuda
 {
-	struct Memcpy2D::impl_t
-	{
-		CUDA_MEMCPY2D_st memcpy2d;
-	};
-	
 	Memcpy2D::Memcpy2D(unsigned int widthBytes, unsigned int height)
 		: impl(new impl_t)
 	{
 		impl->memcpy2d.srcXInBytes = 0;
 		impl->memcpy2d.srcY = 0;
+		impl->memcpy2d.srcPitch = 0;
 		impl->memcpy2d.dstXInBytes = 0;
 		impl->memcpy2d.dstY = 0;
+		impl->memcpy2d.dstPitch = 0;
+
+		// 0 is no CUmemorytype, marks the sides not set yet
+		impl->memcpy2d.srcMemoryType = static_cast<CUmemorytype>(0);
+		impl->memcpy2d.dstMemoryType = static_cast<CUmemorytype>(0);
 		
 		size(widthBytes, height);
 	}
@@ -103,6 +105,26 @@ namespace cuda
 		impl->memcpy2d.Height = height;
 		return *this;
 	}
+
+	unsigned long Memcpy2D::bytes() const
+	{
+		return static_cast<unsigned long>(impl->memcpy2d.WidthInBytes) * impl->memcpy2d.Height;
+	}
+
+	bool Memcpy2D::complete() const
+	{
+		return impl->memcpy2d.srcMemoryType != 0 && impl->memcpy2d.dstMemoryType != 0;
+	}
+
+	bool Memcpy2D::fromHost() const
+	{
+		return impl->memcpy2d.srcMemoryType == CU_MEMORYTYPE_HOST;
+	}
+
+	bool Memcpy2D::toHost() const
+	{
+		return impl->memcpy2d.dstMemoryType == CU_MEMORYTYPE_HOST;
+	}
 	
 	void Memcpy2D::copy() const
 	{
@@ -1,21 +1,300 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
 #include <cuda.h>
 
 #include <cudamm/module.hpp>
+#include <cudamm/deviceptr.hpp>
 
+#include <detail/context.hpp>
 #include <detail/error.hpp>
+#include <detail/file.hpp>
+#include <detail/hash.hpp>
 #include <detail/module_impl.hpp>
+#include <detail/deviceptr_impl.hpp>
+
+namespace
+{
+	typedef std::vector<char> image_t;
+
+	bool readFile(const std::string &filename, image_t &image)
+	{
+		std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+		if(!file) return false;
+		image.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		return !file.bad();
+	}
+
+	/// Hash of a module image, identifies the module across processes
+	std::string imageHash(const image_t &image)
+	{
+		cuda::detail::hash_t hash;
+		if(!image.empty()) hash.add(&image[0], image.size());
+		return hash.hex();
+	}
+
+	bool isPtx(const image_t &image)
+	{
+		static const char elfMagic[] = { 0x7f, 'E', 'L', 'F' };
+		if(image.size() >= 4 && std::equal(elfMagic, elfMagic + 4, image.begin())) return false;
+
+		const std::string text(image.begin(), image.end());
+		return text.find(".version") != std::string::npos && text.find(".target") != std::string::npos;
+	}
+
+	/// Name of the cache entry for an image compiled on the current device
+	std::string cacheKey(const image_t &image, const cuda::JitOptions &options)
+	{
+		CUdevice dev;
+		cuda::detail::error_check(cuCtxGetDevice(&dev), "Can't get current Cuda device");
+
+		char name[256];
+		int major, minor, driver;
+		cuda::detail::error_check(cuDeviceGetName(name, sizeof(name), dev), "Can't get Cuda device name");
+		cuda::detail::error_check(cuDeviceComputeCapability(&major, &minor, dev),
+			"Can't get Cuda device compute capability");
+		cuda::detail::error_check(cuDriverGetVersion(&driver), "Can't get Cuda driver version");
+
+		cuda::detail::hash_t hash;
+		if(!image.empty()) hash.add(&image[0], image.size());
+		hash.add(std::string(name)).add(major).add(minor).add(driver);
+		hash.add(options.maxRegisters).add(options.optimizationLevel).add(options.target);
+		return hash.hex();
+	}
+
+	/// Driver JIT option array with info and error log buffers
+	class jit_options_t
+	{
+		public:
+			explicit jit_options_t(const cuda::JitOptions &options)
+				: infoLog(options.logSize + 1, '\0')
+				, errorLog(options.logSize + 1, '\0')
+			{
+				add(CU_JIT_INFO_LOG_BUFFER, &infoLog[0]);
+				add(CU_JIT_INFO_LOG_BUFFER_SIZE_BYTES, options.logSize);
+				add(CU_JIT_ERROR_LOG_BUFFER, &errorLog[0]);
+				add(CU_JIT_ERROR_LOG_BUFFER_SIZE_BYTES, options.logSize);
+
+				if(options.maxRegisters) add(CU_JIT_MAX_REGISTERS, options.maxRegisters);
+				if(options.optimizationLevel >= 0) add(CU_JIT_OPTIMIZATION_LEVEL, options.optimizationLevel);
+				if(options.target >= 0) add(CU_JIT_TARGET, options.target);
+			}
+
+			unsigned int size() const { return keys.size(); }
+			CUjit_option *options() { return keys.empty() ? 0 : &keys[0]; }
+			void **values() { return vals.empty() ? 0 : &vals[0]; }
+
+			void store(std::string &info, std::string &error) const
+			{
+				info = &infoLog[0];
+				error = &errorLog[0];
+			}
+
+			std::string message(const char *msg) const
+			{
+				std::string str(msg);
+				if(errorLog[0]) str += std::string(" (") + &errorLog[0] + ")";
+				return str;
+			}
+
+		private:
+			void add(CUjit_option key, void *value)
+			{
+				keys.push_back(key);
+				vals.push_back(value);
+			}
+
+			void add(CUjit_option key, unsigned int value)
+			{
+				// Scalar option values are passed in place of the pointer
+				keys.push_back(key);
+				vals.push_back(reinterpret_cast<void *>(static_cast<size_t>(value)));
+			}
+
+			void add(CUjit_option key, int value)
+			{
+				add(key, static_cast<unsigned int>(value));
+			}
+
+			std::vector<char> infoLog, errorLog;
+			std::vector<CUjit_option> keys;
+			std::vector<void *> vals;
+	};
+
+	/// Compile a PTX image to a cubin and store it in the cache
+	void compileToCache(CUmodule &mod, std::string &infoLog, std::string &errorLog,
+		image_t &image, const cuda::JitOptions &options, const std::string &entry)
+	{
+		jit_options_t jit(options);
+
+		CUlinkState link;
+		cuda::detail::error_check(cuLinkCreate(jit.size(), jit.options(), jit.values(), &link),
+			"Can't create Cuda JIT linker");
+
+		image.push_back('\0');
+		CUresult result = cuLinkAddData(link, CU_JIT_INPUT_PTX, &image[0], image.size(), "module", 0, 0, 0);
+
+		void *cubin = 0;
+		size_t cubinSize = 0;
+		if(result == CUDA_SUCCESS) result = cuLinkComplete(link, &cubin, &cubinSize);
+		if(result == CUDA_SUCCESS)
+		{
+			if(!cuda::detail::replace_file(entry, cubin, cubinSize))
+				std::cerr << "Can't write Cuda module cache entry " << entry << std::endl;
+			result = cuModuleLoadData(&mod, cubin);
+		}
+
+		jit.store(infoLog, errorLog);
+
+		// The cubin is owned by the linker, so it is only destroyed after loading
+		cuda::detail::error_warn(cuLinkDestroy(link), "Can't destroy Cuda JIT linker");
+		cuda::detail::error_check(result, jit.message("Can't compile Cuda module").c_str());
+	}
+}
 
 namespace cuda
 {
+	Module::impl_t::function_ptr Module::impl_t::function(const char *name)
+	{
+		detail::context_check(context, "Can't get Cuda function");
+
+		boost::mutex::scoped_lock lock(mutex);
+
+		function_map_t::const_iterator it = functions.find(name);
+		if(it != functions.end()) return it->second;
+
+		CUfunction func;
+		detail::error_check(cuModuleGetFunction(&func, mod, name),
+			"Can't get Cuda function");
+
+		function_ptr state(new detail::function_state_t(func, context));
+		functions.insert(function_map_t::value_type(name, state));
+		return state;
+	}
+
+	CUtexref Module::impl_t::texref(const char *name)
+	{
+		detail::context_check(context, "Can't get Cuda texture reference from module");
+
+		boost::mutex::scoped_lock lock(mutex);
+
+		texref_map_t::const_iterator it = texrefs.find(name);
+		if(it != texrefs.end()) return it->second;
+
+		CUtexref tex;
+		detail::error_check(cuModuleGetTexRef(&tex, mod, name),
+			"Can't get Cuda texture reference from module");
+		texrefs.insert(texref_map_t::value_type(name, tex));
+		return tex;
+	}
+
+	Module::impl_t::global_t Module::impl_t::global(const char *name)
+	{
+		detail::context_check(context, "Can't get Cuda global from module");
+
+		boost::mutex::scoped_lock lock(mutex);
+
+		global_map_t::const_iterator it = globals.find(name);
+		if(it != globals.end()) return it->second;
+
+		global_t glob;
+		detail::error_check(cuModuleGetGlobal(&glob.ptr, &glob.bytes, mod, name),
+			"Can't get Cuda global from module");
+		globals.insert(global_map_t::value_type(name, glob));
+		return glob;
+	}
+
 	Module::Module(const char *filename)
 		: impl(new impl_t)
 	{
+		impl->context = detail::current_context();
 		detail::error_check(cuModuleLoad(&impl->mod, filename), "Can't load Cuda module");
+
+		image_t image;
+		impl->hash = readFile(filename, image) ? imageHash(image) : filename;
+	}
+
+	Module::Module(const char *filename, const JitOptions &options)
+		: impl(new impl_t)
+	{
+		impl->context = detail::current_context();
+
+		image_t image;
+		if(!readFile(filename, image)) detail::error_check(CUDA_ERROR_FILE_NOT_FOUND, "Can't load Cuda module");
+		impl->hash = imageHash(image);
+
+		if(!isPtx(image))
+		{
+			image.push_back('\0');
+			detail::error_check(cuModuleLoadData(&impl->mod, &image[0]), "Can't load Cuda module");
+			return;
+		}
+
+		if(!options.cacheDirectory.empty())
+		{
+			const std::string entry = options.cacheDirectory + "/" + cacheKey(image, options) + ".cubin";
+
+			image_t cubin;
+			if(readFile(entry, cubin) && !cubin.empty() && cuModuleLoadData(&impl->mod, &cubin[0]) == CUDA_SUCCESS)
+			{
+				impl->fromCache = true;
+				return;
+			}
+
+			compileToCache(impl->mod, impl->infoLog, impl->errorLog, image, options, entry);
+			return;
+		}
+
+		jit_options_t jit(options);
+		image.push_back('\0');
+		CUresult result = cuModuleLoadDataEx(&impl->mod, &image[0], jit.size(), jit.options(), jit.values());
+		jit.store(impl->infoLog, impl->errorLog);
+		detail::error_check(result, jit.message("Can't load Cuda module").c_str());
 	}
 
 	Module::~Module()
 	{
 		detail::error_warn(cuModuleUnload(impl->mod), "Can't unload Cuda module");
 	}
-}
 
+	const std::string& Module::infoLog() const
+	{
+		return impl->infoLog;
+	}
+
+	const std::string& Module::errorLog() const
+	{
+		return impl->errorLog;
+	}
+
+	const std::string& Module::hash() const
+	{
+		return impl->hash;
+	}
+
+	bool Module::cached() const
+	{
+		return impl->fromCache;
+	}
+
+	DevicePtr Module::global(const char *name) const
+	{
+		unsigned int bytes;
+		return global(name, bytes);
+	}
+
+	DevicePtr Module::global(const char *name, unsigned int &bytes) const
+	{
+		impl_t::global_t glob = impl->global(name);
+
+		DevicePtr ptr;
+		ptr.impl->devicePtr = glob.ptr;
+		ptr.impl->context = impl->context;
+		bytes = glob.bytes;
+		return ptr;
+	}
+}
@@ -0,0 +1,113 @@
+#include <climits>
+#include <cstdlib>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include <boost/weak_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <cudamm/module.hpp>
+#include <cudamm/moduleregistry.hpp>
+
+#include <detail/context.hpp>
+
+namespace
+{
+	std::string canonicalPath(const char *filename)
+	{
+		char buffer[PATH_MAX];
+		if(::realpath(filename, buffer)) return buffer;
+		return filename;
+	}
+	
+	std::string registryKey(const char *filename, const cuda::JitOptions *options)
+	{
+		// Modules belong to the context they were loaded in
+		std::ostringstream key;
+		key << cuda::detail::current_context() << '\n' << canonicalPath(filename);
+		if(options)
+		{
+			key << '\n' << options->maxRegisters
+				<< ' ' << options->optimizationLevel
+				<< ' ' << options->target;
+		}
+		return key.str();
+	}
+}
+
+namespace cuda
+{
+	struct ModuleRegistry::impl_t
+	{
+		typedef std::map<std::string, boost::weak_ptr<Module> > map_t;
+
+		mutable boost::mutex mutex;
+		map_t modules;
+	};
+
+	ModuleRegistry::ModuleRegistry()
+		: impl(new impl_t)
+	{
+	}
+
+	ModuleRegistry::~ModuleRegistry()
+	{
+	}
+
+	ModuleRegistry& ModuleRegistry::instance()
+	{
+		static ModuleRegistry registry;
+		return registry;
+	}
+
+	ModuleRegistry::module_ptr ModuleRegistry::load(const char *filename)
+	{
+		return load(filename, static_cast<const JitOptions *>(0));
+	}
+
+	ModuleRegistry::module_ptr ModuleRegistry::load(const char *filename, const JitOptions &options)
+	{
+		return load(filename, &options);
+	}
+
+	ModuleRegistry::module_ptr ModuleRegistry::load(const char *filename, const JitOptions *options)
+	{
+		const std::string key = registryKey(filename, options);
+
+		// Loading under the lock makes concurrent requests for the same
+		// file wait for the first load instead of loading it twice.
+		boost::mutex::scoped_lock lock(impl->mutex);
+
+		impl_t::map_t::iterator it = impl->modules.find(key);
+		if(it != impl->modules.end())
+		{
+			module_ptr mod = it->second.lock();
+			if(mod) return mod;
+		}
+
+		module_ptr mod(options ? new Module(filename, *options) : new Module(filename));
+		impl->modules[key] = mod;
+
+		// Forget modules that have been unloaded in the meantime
+		for(it = impl->modules.begin(); it != impl->modules.end(); )
+		{
+			if(it->second.expired()) impl->modules.erase(it++);
+			else ++it;
+		}
+
+		return mod;
+	}
+
+	unsigned int ModuleRegistry::size() const
+	{
+		boost::mutex::scoped_lock lock(impl->mutex);
+
+		unsigned int count = 0;
+		for(impl_t::map_t::const_iterator it = impl->modules.begin(); it != impl->modules.end(); ++it)
+		{
+			if(!it->second.expired()) ++count;
+		}
+		return count;
+	}
+}
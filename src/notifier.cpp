@@ -0,0 +1,179 @@
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <boost/cstdint.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <cudamm/exception.hpp>
+#include <cudamm/event.hpp>
+#include <cudamm/stream.hpp>
+#include <cudamm/notifier.hpp>
+
+namespace
+{
+	/// State shared with the stream callbacks, outlives the notifier while callbacks are pending
+	struct state_t
+	{
+		explicit state_t(int fd)
+			: fd(fd)
+			, pending(0)
+		{
+		}
+
+		~state_t()
+		{
+			close(fd);
+		}
+
+		const int fd;
+
+		boost::mutex mutex;
+		std::vector<unsigned long> completed, failed;
+		unsigned int pending;
+
+		// Event watch streams of the notifier without a pending watch
+		std::vector<unsigned int> idle;
+	};
+
+	/// Stream callback of one watch
+	struct notify_t
+	{
+		notify_t(const boost::shared_ptr<state_t> &state, unsigned long token, int stream)
+			: state(state)
+			, token(token)
+			, stream(stream)
+		{
+		}
+
+		void operator()(bool succeeded) const
+		{
+			{
+				boost::mutex::scoped_lock lock(state->mutex);
+				(succeeded ? state->completed : state->failed).push_back(token);
+				--state->pending;
+				if(stream >= 0) state->idle.push_back(stream);
+			}
+
+			const boost::uint64_t one = 1;
+			while(write(state->fd, &one, sizeof(one)) < 0 && errno == EINTR);
+		}
+
+		boost::shared_ptr<state_t> state;
+		unsigned long token;
+
+		// Event watch stream to return to the idle ones, -1 for none
+		int stream;
+	};
+}
+
+namespace cuda
+{
+	struct CompletionNotifier::impl_t
+	{
+		boost::shared_ptr<state_t> state;
+
+		// Wait for watched events, so their streams are not held up. One
+		// per pending event watch, so no watch waits behind another.
+		std::vector<boost::shared_ptr<Stream> > events;
+
+		void watch(const Stream &stream, unsigned long token, int index)
+		{
+			{
+				boost::mutex::scoped_lock lock(state->mutex);
+				++state->pending;
+			}
+
+			try
+			{
+				stream.callback(notify_t(state, token, index));
+			} catch(...)
+			{
+				boost::mutex::scoped_lock lock(state->mutex);
+				--state->pending;
+				throw;
+			}
+		}
+	};
+
+	CompletionNotifier::CompletionNotifier()
+		: impl(new impl_t)
+	{
+		const int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if(fd < 0) throw Exception(("Can't create eventfd: " + std::string(std::strerror(errno))).c_str());
+		impl->state.reset(new state_t(fd));
+	}
+
+	CompletionNotifier::~CompletionNotifier()
+	{
+	}
+
+	int CompletionNotifier::fd() const
+	{
+		return impl->state->fd;
+	}
+
+	void CompletionNotifier::watch(const Stream &stream, unsigned long token)
+	{
+		impl->watch(stream, token, -1);
+	}
+
+	void CompletionNotifier::watch(const Event &event, unsigned long token)
+	{
+		unsigned int index = impl->events.size();
+		{
+			boost::mutex::scoped_lock lock(impl->state->mutex);
+			if(!impl->state->idle.empty())
+			{
+				index = impl->state->idle.back();
+				impl->state->idle.pop_back();
+			}
+		}
+
+		try
+		{
+			if(index == impl->events.size()) impl->events.push_back(boost::shared_ptr<Stream>(new Stream(Stream::NON_BLOCKING)));
+
+			const Stream &stream = *impl->events[index];
+			stream.wait(event);
+			impl->watch(stream, token, index);
+		} catch(...)
+		{
+			if(index < impl->events.size())
+			{
+				boost::mutex::scoped_lock lock(impl->state->mutex);
+				impl->state->idle.push_back(index);
+			}
+			throw;
+		}
+	}
+
+	std::vector<unsigned long> CompletionNotifier::drain()
+	{
+		boost::uint64_t count;
+		while(read(impl->state->fd, &count, sizeof(count)) < 0 && errno == EINTR);
+
+		std::vector<unsigned long> tokens;
+		boost::mutex::scoped_lock lock(impl->state->mutex);
+		tokens.swap(impl->state->completed);
+		return tokens;
+	}
+
+	std::vector<unsigned long> CompletionNotifier::failed()
+	{
+		std::vector<unsigned long> tokens;
+		boost::mutex::scoped_lock lock(impl->state->mutex);
+		tokens.swap(impl->state->failed);
+		return tokens;
+	}
+
+	unsigned int CompletionNotifier::pending() const
+	{
+		boost::mutex::scoped_lock lock(impl->state->mutex);
+		return impl->state->pending;
+	}
+}
@@ -0,0 +1,271 @@
+#include <algorithm>
+#include <vector>
+
+#include <cuda.h>
+
+#include <cudamm/exception.hpp>
+#include <cudamm/function.hpp>
+#include <cudamm/cubininfo.hpp>
+#include <cudamm/occupancy.hpp>
+
+#include <detail/error.hpp>
+
+namespace
+{
+	inline unsigned int divUp(unsigned int a, unsigned int b)
+	{
+		return (a + b - 1) / b;
+	}
+
+	inline unsigned int roundUp(unsigned int a, unsigned int b)
+	{
+		return b ? divUp(a, b) * b : a;
+	}
+
+	/// Query a device attribute that older drivers may not know about
+	void queryAttribute(unsigned int &value, CUdevice_attribute attribute, CUdevice dev)
+	{
+		int result;
+		if(cuDeviceGetAttribute(&result, attribute, dev) == CUDA_SUCCESS && result > 0)
+			value = static_cast<unsigned int>(result);
+	}
+
+	/// Wasted threads of a launch covering width * height
+	unsigned long idleThreads(const cuda::LaunchConfig &config, unsigned int width, unsigned int height)
+	{
+		return static_cast<unsigned long>(config.gridX) * config.blockX * config.gridY * config.blockY
+			- static_cast<unsigned long>(width) * height;
+	}
+}
+
+namespace cuda
+{
+	DeviceLimits DeviceLimits::forComputeCapability(int major, int minor, unsigned int multiprocessors)
+	{
+		DeviceLimits limits;
+		limits.warpSize = 32;
+		limits.multiprocessors = multiprocessors;
+		limits.maxGridDimX = 65535;
+		limits.maxGridDimY = 65535;
+
+		if(major == 1)
+		{
+			limits.maxThreadsPerBlock = 512;
+			limits.maxBlockDimX = 512;
+			limits.maxBlockDimY = 512;
+			limits.maxBlockDimZ = 64;
+			limits.maxThreadsPerMultiprocessor = minor >= 2 ? 1024 : 768;
+			limits.maxBlocksPerMultiprocessor = 8;
+			limits.registersPerMultiprocessor = minor >= 2 ? 16384 : 8192;
+			limits.registerAllocationUnit = minor >= 2 ? 512 : 256;
+			limits.registersPerWarp = false;
+			limits.sharedPerMultiprocessor = 16384;
+			limits.sharedPerBlock = 16384;
+			limits.sharedAllocationUnit = 512;
+		} else if(major == 2)
+		{
+			limits.maxThreadsPerBlock = 1024;
+			limits.maxBlockDimX = 1024;
+			limits.maxBlockDimY = 1024;
+			limits.maxBlockDimZ = 64;
+			limits.maxThreadsPerMultiprocessor = 1536;
+			limits.maxBlocksPerMultiprocessor = 8;
+			limits.registersPerMultiprocessor = 32768;
+			limits.registerAllocationUnit = 64;
+			limits.registersPerWarp = true;
+			limits.sharedPerMultiprocessor = 49152;
+			limits.sharedPerBlock = 49152;
+			limits.sharedAllocationUnit = 128;
+		} else
+		{
+			limits.maxThreadsPerBlock = 1024;
+			limits.maxBlockDimX = 1024;
+			limits.maxBlockDimY = 1024;
+			limits.maxBlockDimZ = 64;
+			limits.maxGridDimX = 2147483647u;
+			limits.maxThreadsPerMultiprocessor = major == 7 && minor == 5 ? 1024 : 2048;
+			limits.maxBlocksPerMultiprocessor = major == 3 || (major == 7 && minor == 5) ? 16 : 32;
+			limits.registersPerMultiprocessor = 65536;
+			limits.registerAllocationUnit = 256;
+			limits.registersPerWarp = true;
+			limits.sharedPerMultiprocessor = major == 3 ? 49152 : 65536;
+			limits.sharedPerBlock = 49152;
+			limits.sharedAllocationUnit = 256;
+		}
+
+		return limits;
+	}
+
+	DeviceLimits DeviceLimits::current()
+	{
+		CUdevice dev;
+		detail::error_check(cuCtxGetDevice(&dev), "Can't get current Cuda device");
+
+		int major, minor;
+		detail::error_check(cuDeviceComputeCapability(&major, &minor, dev),
+			"Can't get Cuda device compute capability");
+
+		DeviceLimits limits = forComputeCapability(major, minor);
+
+		queryAttribute(limits.multiprocessors, CU_DEVICE_ATTRIBUTE_MULTIPROCESSOR_COUNT, dev);
+		queryAttribute(limits.warpSize, CU_DEVICE_ATTRIBUTE_WARP_SIZE, dev);
+		queryAttribute(limits.maxThreadsPerBlock, CU_DEVICE_ATTRIBUTE_MAX_THREADS_PER_BLOCK, dev);
+		queryAttribute(limits.maxBlockDimX, CU_DEVICE_ATTRIBUTE_MAX_BLOCK_DIM_X, dev);
+		queryAttribute(limits.maxBlockDimY, CU_DEVICE_ATTRIBUTE_MAX_BLOCK_DIM_Y, dev);
+		queryAttribute(limits.maxBlockDimZ, CU_DEVICE_ATTRIBUTE_MAX_BLOCK_DIM_Z, dev);
+		queryAttribute(limits.maxGridDimX, CU_DEVICE_ATTRIBUTE_MAX_GRID_DIM_X, dev);
+		queryAttribute(limits.maxGridDimY, CU_DEVICE_ATTRIBUTE_MAX_GRID_DIM_Y, dev);
+		queryAttribute(limits.sharedPerBlock, CU_DEVICE_ATTRIBUTE_MAX_SHARED_MEMORY_PER_BLOCK, dev);
+
+		// Only known to newer drivers, the table values are kept otherwise
+		queryAttribute(limits.maxThreadsPerMultiprocessor, CU_DEVICE_ATTRIBUTE_MAX_THREADS_PER_MULTIPROCESSOR, dev);
+		queryAttribute(limits.registersPerMultiprocessor, CU_DEVICE_ATTRIBUTE_MAX_REGISTERS_PER_MULTIPROCESSOR, dev);
+		queryAttribute(limits.sharedPerMultiprocessor, CU_DEVICE_ATTRIBUTE_MAX_SHARED_MEMORY_PER_MULTIPROCESSOR, dev);
+		queryAttribute(limits.maxBlocksPerMultiprocessor, CU_DEVICE_ATTRIBUTE_MAX_BLOCKS_PER_MULTIPROCESSOR, dev);
+
+		return limits;
+	}
+
+	KernelResources::KernelResources(const CubinKernel &kernel)
+		: registers(kernel.registers)
+		, sharedBytes(kernel.sharedBytes)
+		, maxThreadsPerBlock(0)
+	{
+	}
+
+	KernelResources::KernelResources(const Function &function)
+		: registers(function.registers())
+		, sharedBytes(function.staticSharedSize())
+		, maxThreadsPerBlock(function.maxThreadsPerBlock())
+	{
+	}
+
+	unsigned int residentBlocks(const DeviceLimits &limits, const KernelResources &resources,
+		unsigned int threads, unsigned int dynamicShared)
+	{
+		if(!threads || threads > limits.maxThreadsPerBlock) return 0;
+		if(resources.maxThreadsPerBlock && threads > resources.maxThreadsPerBlock) return 0;
+
+		const unsigned int warps = divUp(threads, limits.warpSize);
+		unsigned int blocks = std::min(limits.maxBlocksPerMultiprocessor,
+			limits.maxThreadsPerMultiprocessor / (warps * limits.warpSize));
+
+		if(resources.registers)
+		{
+			if(limits.registersPerWarp)
+			{
+				const unsigned int perWarp = roundUp(resources.registers * limits.warpSize, limits.registerAllocationUnit);
+				blocks = std::min(blocks, limits.registersPerMultiprocessor / perWarp / warps);
+			} else
+			{
+				// Registers are allocated for an even number of warps per block
+				const unsigned int perBlock = roundUp(roundUp(warps, 2) * limits.warpSize * resources.registers,
+					limits.registerAllocationUnit);
+				blocks = std::min(blocks, limits.registersPerMultiprocessor / perBlock);
+			}
+		}
+
+		const unsigned int shared = resources.sharedBytes + dynamicShared;
+		if(shared > limits.sharedPerBlock) return 0;
+		if(shared) blocks = std::min(blocks, limits.sharedPerMultiprocessor / roundUp(shared, limits.sharedAllocationUnit));
+
+		return blocks;
+	}
+
+	std::vector<LaunchConfig> feasibleLaunches(const DeviceLimits &limits, const KernelResources &resources,
+		unsigned int width, unsigned int height,
+		unsigned int sharedPerThread, unsigned int sharedPerBlock)
+	{
+		if(!width || !height) throw Exception("Empty problem size");
+
+		const unsigned int maxWarps = limits.maxThreadsPerMultiprocessor / limits.warpSize;
+
+		std::vector<LaunchConfig> configs;
+		for(unsigned int threads = limits.warpSize; threads <= limits.maxThreadsPerBlock; threads += limits.warpSize)
+		{
+			LaunchConfig config;
+			config.blockZ = 1;
+
+			if(height == 1)
+			{
+				config.blockX = threads;
+				config.blockY = 1;
+			} else
+			{
+				// Widest power of two that divides the block size and doesn't
+				// exceed the problem width by more than one step
+				config.blockX = 1;
+				while(config.blockX < width && threads % (config.blockX * 2) == 0) config.blockX *= 2;
+				config.blockY = threads / config.blockX;
+			}
+
+			if(config.blockX > limits.maxBlockDimX || config.blockY > limits.maxBlockDimY) continue;
+
+			config.sharedBytes = sharedPerBlock + sharedPerThread * threads;
+			config.blocksPerMultiprocessor = residentBlocks(limits, resources, threads, config.sharedBytes);
+			if(!config.blocksPerMultiprocessor) continue;
+
+			config.gridX = divUp(width, config.blockX);
+			config.gridY = divUp(height, config.blockY);
+			if(config.gridX > limits.maxGridDimX || config.gridY > limits.maxGridDimY) continue;
+
+			config.warpsPerMultiprocessor = config.blocksPerMultiprocessor * divUp(threads, limits.warpSize);
+			config.occupancy = static_cast<float>(config.warpsPerMultiprocessor) / maxWarps;
+			configs.push_back(config);
+		}
+
+		return configs;
+	}
+
+	LaunchConfig recommendLaunch(const DeviceLimits &limits, const KernelResources &resources,
+		unsigned int width, unsigned int height,
+		unsigned int sharedPerThread, unsigned int sharedPerBlock)
+	{
+		const std::vector<LaunchConfig> configs = feasibleLaunches(limits, resources,
+			width, height, sharedPerThread, sharedPerBlock);
+
+		const unsigned long usefulWarps = (static_cast<unsigned long>(width) * height + limits.warpSize - 1) / limits.warpSize;
+
+		LaunchConfig best;
+		unsigned long bestActive = 0;
+
+		for(std::vector<LaunchConfig>::const_iterator config = configs.begin(); config != configs.end(); ++config)
+		{
+			// Warps the whole device keeps resident, small problems can't fill it
+			// and warps beyond the problem size don't count
+			const unsigned int warps = divUp(config->threads(), limits.warpSize);
+			const unsigned long blocks = static_cast<unsigned long>(config->gridX) * config->gridY;
+			const unsigned long active = std::min(usefulWarps, std::min(blocks,
+				static_cast<unsigned long>(config->blocksPerMultiprocessor) * limits.multiprocessors) * warps);
+
+			bool better = active > bestActive;
+			if(active == bestActive && active)
+			{
+				const unsigned long idle = idleThreads(*config, width, height);
+				const unsigned long bestIdle = idleThreads(best, width, height);
+				better = idle < bestIdle || (idle == bestIdle && config->occupancy > best.occupancy);
+			}
+
+			if(better)
+			{
+				best = *config;
+				bestActive = active;
+			}
+		}
+
+		if(!bestActive) throw Exception("No block size fits the kernel resources");
+		return best;
+	}
+
+	LaunchConfig configureLaunch(const Function &function,
+		unsigned int width, unsigned int height,
+		unsigned int sharedPerThread, unsigned int sharedPerBlock)
+	{
+		const LaunchConfig config = recommendLaunch(DeviceLimits::current(), KernelResources(function),
+			width, height, sharedPerThread, sharedPerBlock);
+
+		function.setBlockShape(config.blockX, config.blockY, config.blockZ);
+		function.setSharedSize(config.sharedBytes);
+		return config;
+	}
+}
@@ -0,0 +1,315 @@
+#include <algorithm>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <cudamm/context.hpp>
+#include <cudamm/device.hpp>
+#include <cudamm/devicememory2d.hpp>
+#include <cudamm/event.hpp>
+#include <cudamm/exception.hpp>
+#include <cudamm/function.hpp>
+#include <cudamm/memcpy2d.hpp>
+#include <cudamm/module.hpp>
+#include <cudamm/moduleregistry.hpp>
+#include <cudamm/partitioner.hpp>
+#include <cudamm/stream.hpp>
+
+namespace
+{
+	/// Scale weights to sum up to 1
+	std::vector<double> normalize(const std::vector<double> &weights)
+	{
+		double sum = 0.0;
+		for(std::vector<double>::const_iterator it = weights.begin(); it != weights.end(); ++it)
+		{
+			if(*it < 0.0) throw cuda::Exception("Negative partition weight");
+			sum += *it;
+		}
+		if(sum <= 0.0) throw cuda::Exception("Partition weights sum up to 0");
+
+		std::vector<double> result(weights);
+		for(std::vector<double>::iterator it = result.begin(); it != result.end(); ++it) *it /= sum;
+		return result;
+	}
+
+	/// Access size for malloc2D, which only accepts 4, 8 and 16
+	unsigned int accessSize(unsigned int elementSize)
+	{
+		if(elementSize <= 4) return 4;
+		if(elementSize <= 8) return 8;
+		return 16;
+	}
+
+	/// Make a buffer hold at least widthBytes * height
+	void ensure(boost::scoped_ptr<cuda::DeviceMemory2D> &buffer, unsigned int widthBytes, unsigned int height, unsigned int elementSize)
+	{
+		if(buffer && buffer->width() >= widthBytes && buffer->height() >= height) return;
+
+		// Free the old buffer first, the device may not hold both
+		buffer.reset();
+		buffer.reset(new cuda::DeviceMemory2D(widthBytes, height, accessSize(elementSize)));
+	}
+}
+
+namespace cuda
+{
+	struct Partitioner::impl_t
+	{
+		/// Resources of one device, created and destroyed in its context
+		struct device_t
+		{
+			Context::context_ptr context;
+			ModuleRegistry::module_ptr module;
+			boost::scoped_ptr<Function> function;
+			boost::scoped_ptr<Stream> stream;
+			boost::scoped_ptr<Event> start, end;
+			boost::scoped_ptr<DeviceMemory2D> input, output;
+		};
+
+		impl_t()
+			: split(ROWS)
+			, adaptive(false)
+			, granularity(1)
+		{
+		}
+
+		std::vector<boost::shared_ptr<device_t> > devices;
+		std::vector<double> weights;
+		std::vector<float> times;
+
+		Split split;
+		bool adaptive;
+		unsigned int granularity;
+	};
+
+	std::vector<Tile> Partitioner::partition(unsigned int width, unsigned int height,
+		const std::vector<double> &weights, Split split, unsigned int granularity)
+	{
+		const std::vector<double> shares = normalize(weights);
+		if(!granularity) granularity = 1;
+
+		const unsigned int length = split == ROWS ? height : width;
+		const unsigned int units = (length + granularity - 1) / granularity;
+
+		// Largest remainder: floor of every share, the rest to the largest fractions
+		std::vector<unsigned int> counts(shares.size());
+		std::vector<std::pair<double, unsigned int> > remainders;
+		unsigned int assigned = 0;
+		for(unsigned int i = 0; i < shares.size(); ++i)
+		{
+			const double exact = shares[i] * units;
+			counts[i] = static_cast<unsigned int>(exact);
+			assigned += counts[i];
+			remainders.push_back(std::make_pair(exact - counts[i], i));
+		}
+		std::sort(remainders.begin(), remainders.end());
+		for(std::vector<std::pair<double, unsigned int> >::reverse_iterator it = remainders.rbegin();
+			it != remainders.rend() && assigned < units; ++it, ++assigned)
+		{
+			++counts[it->second];
+		}
+
+		std::vector<Tile> tiles;
+		unsigned int position = 0;
+		for(unsigned int i = 0; i < counts.size(); ++i)
+		{
+			const unsigned int size = std::min(counts[i] * granularity, length - position);
+
+			Tile tile;
+			tile.device = i;
+			if(split == ROWS)
+			{
+				tile.x = 0;
+				tile.y = position;
+				tile.width = size ? width : 0;
+				tile.height = size;
+			}
+			else
+			{
+				tile.x = position;
+				tile.y = 0;
+				tile.width = size;
+				tile.height = size ? height : 0;
+			}
+			tiles.push_back(tile);
+			position += size;
+		}
+		return tiles;
+	}
+
+	Partitioner::Partitioner(const std::vector<int> &devices, const char *moduleFile, const char *kernel, Split split)
+		: impl(new impl_t)
+	{
+		if(devices.empty()) throw Exception("No devices to partition over");
+
+		impl->split = split;
+		std::vector<double> weights;
+		for(std::vector<int>::const_iterator it = devices.begin(); it != devices.end(); ++it)
+		{
+			boost::shared_ptr<impl_t::device_t> device(new impl_t::device_t);
+			device->context = Context::device(*it);
+			impl->devices.push_back(device);
+
+			ContextScope scope(*device->context);
+			device->module = loadModule(moduleFile);
+			device->function.reset(new Function(*device->module, kernel));
+			device->stream.reset(new Stream(Stream::NON_BLOCKING));
+			device->start.reset(new Event);
+			device->end.reset(new Event);
+
+			const DeviceInfo &info = device->context->info();
+			weights.push_back(static_cast<double>(info.multiprocessors) * info.clockRate);
+		}
+
+		impl->weights = normalize(weights);
+		impl->times.assign(devices.size(), 0.0f);
+	}
+
+	Partitioner::~Partitioner()
+	{
+		for(std::vector<boost::shared_ptr<impl_t::device_t> >::iterator it = impl->devices.begin(); it != impl->devices.end(); ++it)
+		{
+			impl_t::device_t &device = **it;
+			if(!device.context) continue;
+
+			ContextScope scope(*device.context);
+			device.input.reset();
+			device.output.reset();
+			device.start.reset();
+			device.end.reset();
+			device.stream.reset();
+			device.function.reset();
+			device.module.reset();
+		}
+	}
+
+	unsigned int Partitioner::devices() const
+	{
+		return impl->devices.size();
+	}
+
+	const std::vector<double>& Partitioner::weights() const
+	{
+		return impl->weights;
+	}
+
+	void Partitioner::setWeights(const std::vector<double> &weights)
+	{
+		if(weights.size() != impl->devices.size()) throw Exception("Need one partition weight per device");
+		impl->weights = normalize(weights);
+	}
+
+	void Partitioner::setAdaptive(bool adaptive)
+	{
+		impl->adaptive = adaptive;
+	}
+
+	void Partitioner::setGranularity(unsigned int granularity)
+	{
+		impl->granularity = granularity ? granularity : 1;
+	}
+
+	std::vector<Tile> Partitioner::tiles(unsigned int width, unsigned int height) const
+	{
+		return partition(width, height, impl->weights, impl->split, impl->granularity);
+	}
+
+	void Partitioner::run(const void *input, unsigned int inputPitch, void *output, unsigned int outputPitch,
+		unsigned int width, unsigned int height, unsigned int elementSize, const Launch &launch)
+	{
+		const std::vector<Tile> tiles = this->tiles(width, height);
+
+		// Issue everything first so that the devices work concurrently
+		for(std::vector<Tile>::const_iterator tile = tiles.begin(); tile != tiles.end(); ++tile)
+		{
+			if(!tile->width || !tile->height) continue;
+
+			impl_t::device_t &device = *impl->devices[tile->device];
+			ContextScope scope(*device.context);
+
+			const unsigned int widthBytes = tile->width * elementSize;
+			Partition partition;
+			partition.tile = *tile;
+			partition.inputPitch = 0;
+			partition.outputPitch = 0;
+
+			device.start->record(*device.stream);
+
+			if(input)
+			{
+				ensure(device.input, widthBytes, tile->height, elementSize);
+				partition.input = device.input->ptr();
+				partition.inputPitch = device.input->pitch();
+
+				Memcpy2D(widthBytes, tile->height)
+					.source(input, inputPitch)
+					.sourcePos(tile->x * elementSize, tile->y)
+					.destination(device.input->ptr(), device.input->pitch())
+					.copy(*device.stream);
+			}
+
+			if(output)
+			{
+				ensure(device.output, widthBytes, tile->height, elementSize);
+				partition.output = device.output->ptr();
+				partition.outputPitch = device.output->pitch();
+			}
+
+			launch(*device.function, partition, *device.stream);
+
+			if(output)
+			{
+				Memcpy2D(widthBytes, tile->height)
+					.source(device.output->ptr(), device.output->pitch())
+					.destination(output, outputPitch)
+					.destinationPos(tile->x * elementSize, tile->y)
+					.copy(*device.stream);
+			}
+
+			device.end->record(*device.stream);
+		}
+
+		std::vector<double> throughput(tiles.size(), 0.0);
+		double total = 0.0;
+		for(std::vector<Tile>::const_iterator tile = tiles.begin(); tile != tiles.end(); ++tile)
+		{
+			impl->times[tile->device] = 0.0f;
+			if(!tile->width || !tile->height) continue;
+
+			impl_t::device_t &device = *impl->devices[tile->device];
+			ContextScope scope(*device.context);
+
+			device.end->synchronize();
+			const float time = *device.end - *device.start;
+			impl->times[tile->device] = time;
+
+			if(time > 0.0f)
+			{
+				throughput[tile->device] = static_cast<double>(tile->width) * tile->height / time;
+				total += throughput[tile->device];
+			}
+		}
+
+		if(!impl->adaptive || total <= 0.0) return;
+
+		// Move the weights of the measured devices halfway towards their measured share
+		double measured = 0.0;
+		for(unsigned int i = 0; i < throughput.size(); ++i)
+		{
+			if(throughput[i] > 0.0) measured += impl->weights[i];
+		}
+		std::vector<double> weights(impl->weights);
+		for(unsigned int i = 0; i < throughput.size(); ++i)
+		{
+			if(throughput[i] > 0.0) weights[i] = 0.5 * weights[i] + 0.5 * measured * throughput[i] / total;
+		}
+		impl->weights = normalize(weights);
+	}
+
+	const std::vector<float>& Partitioner::times() const
+	{
+		return impl->times;
+	}
+}
@@ -0,0 +1,343 @@
+#include <climits>
+#include <iostream>
+#include <list>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <cudamm/deviceptr.hpp>
+#include <cudamm/event.hpp>
+#include <cudamm/exception.hpp>
+#include <cudamm/residencycache.hpp>
+#include <cudamm/stream.hpp>
+
+namespace
+{
+	/// Offset a device pointer by more bytes than DevicePtr::operator+ takes at once
+	cuda::DevicePtr offset(const cuda::DevicePtr &ptr, boost::uint64_t bytes)
+	{
+		cuda::DevicePtr result = ptr;
+		for(; bytes > INT_MAX; bytes -= INT_MAX) result = result + INT_MAX;
+		return result + static_cast<int>(bytes);
+	}
+}
+
+namespace cuda
+{
+	struct ResidencyCache::impl_t
+	{
+		/// Device memory of one block
+		struct slot_t
+		{
+			slot_t()
+				: block(-1)
+				, dirty(false)
+				, pins(0)
+				, prefetched(false)
+			{
+			}
+
+			DevicePtr ptr;
+			int block;
+			bool dirty;
+			unsigned int pins;
+
+			// Uploaded on the side stream, the access stream has not waited for it yet
+			bool prefetched;
+			boost::shared_ptr<Event> ready;
+
+			std::list<unsigned int>::iterator lru;
+		};
+
+		impl_t(const Stream &stream)
+			: stream(stream)
+			, side(Stream::NON_BLOCKING)
+			, accessed(Event::DISABLE_TIMING)
+			, distance(0)
+			, sidePending(false)
+		{
+			stats = ResidencyStats();
+		}
+
+		/// Host memory of a block
+		char* host(unsigned int block) const
+		{
+			return static_cast<char *>(hostBuffer) + static_cast<unsigned long>(block) * blockBytes;
+		}
+
+		/// Size of a block
+		unsigned int bytes(unsigned int block) const
+		{
+			const unsigned long start = static_cast<unsigned long>(block) * blockBytes;
+			return hostBytes - start < blockBytes ? hostBytes - start : blockBytes;
+		}
+
+		/// Find the least recently used slot that may be evicted
+		/**
+			@param forPrefetch true to spare prefetched slots
+			@return the slot, -1 if all are acquired
+		*/
+		int victim(bool forPrefetch) const;
+
+		/// Evict the block of a slot, writing it back on a stream if dirty
+		void evict(unsigned int slot, const Stream &on);
+
+		/// Make a slot the most recently used
+		void touch(unsigned int slot);
+
+		void checkBlock(unsigned int block) const
+		{
+			if(block >= blockSlot.size()) throw Exception("Block outside of the residency cache");
+		}
+
+		void *hostBuffer;
+		unsigned long hostBytes;
+		unsigned int blockBytes;
+
+		const Stream &stream;
+		Stream side;
+
+		// Recorded on the access stream before a prefetch reuses a slot
+		Event accessed;
+
+		DevicePtr memory;
+		std::vector<slot_t> slots;
+		std::vector<int> blockSlot;
+
+		// Slots, most recently used first
+		std::list<unsigned int> lru;
+
+		unsigned int distance;
+
+		// Side stream work the access stream has not waited for, ending with lastSide
+		bool sidePending;
+		boost::shared_ptr<Event> lastSide;
+
+		ResidencyStats stats;
+	};
+
+	int ResidencyCache::impl_t::victim(bool forPrefetch) const
+	{
+		for(std::list<unsigned int>::const_reverse_iterator it = lru.rbegin(); it != lru.rend(); ++it)
+		{
+			const slot_t &slot = slots[*it];
+			if(slot.pins) continue;
+			if(forPrefetch && slot.prefetched) continue;
+			return *it;
+		}
+		return -1;
+	}
+
+	void ResidencyCache::impl_t::evict(unsigned int index, const Stream &on)
+	{
+		slot_t &slot = slots[index];
+
+		// A prefetch into the slot may still be running
+		if(slot.prefetched && &on != &side) on.wait(*slot.ready);
+		slot.prefetched = false;
+
+		if(slot.block < 0) return;
+
+		if(slot.dirty)
+		{
+			memcpy(host(slot.block), slot.ptr, bytes(slot.block), on);
+			slot.dirty = false;
+			++stats.writeBacks;
+		}
+
+		blockSlot[slot.block] = -1;
+		slot.block = -1;
+		++stats.evictions;
+	}
+
+	void ResidencyCache::impl_t::touch(unsigned int index)
+	{
+		lru.splice(lru.begin(), lru, slots[index].lru);
+	}
+
+	ResidencyCache::ResidencyCache(void *host, unsigned long bytes, unsigned int blockBytes,
+		unsigned int deviceBlocks, const Stream &stream)
+		: impl(new impl_t(stream))
+	{
+		if(!blockBytes || !deviceBlocks) throw Exception("Empty residency cache");
+
+		impl->hostBuffer = host;
+		impl->hostBytes = bytes;
+		impl->blockBytes = blockBytes;
+		impl->blockSlot.assign((bytes + blockBytes - 1) / blockBytes, -1);
+
+		// cuda::malloc takes 32 bit sizes
+		const boost::uint64_t deviceBytes = static_cast<boost::uint64_t>(deviceBlocks) * blockBytes;
+		if(deviceBytes > UINT_MAX) throw Exception("Device memory of the residency cache too large");
+
+		impl->memory = malloc(static_cast<unsigned int>(deviceBytes));
+		impl->slots.resize(deviceBlocks);
+		for(unsigned int i = 0; i < deviceBlocks; ++i)
+		{
+			impl_t::slot_t &slot = impl->slots[i];
+			slot.ptr = offset(impl->memory, static_cast<boost::uint64_t>(i) * blockBytes);
+			slot.ready.reset(new Event(Event::DISABLE_TIMING));
+			slot.lru = impl->lru.insert(impl->lru.end(), i);
+		}
+	}
+
+	ResidencyCache::~ResidencyCache()
+	{
+		try
+		{
+			writeBack();
+			impl->side.synchronize();
+			impl->stream.synchronize();
+		} catch(Exception const &e)
+		{
+			std::cerr << e.what() << std::endl;
+		}
+
+		free(impl->memory);
+	}
+
+	ResidencyCache& ResidencyCache::setPrefetchDistance(unsigned int blocks)
+	{
+		impl->distance = blocks;
+		return *this;
+	}
+
+	const DevicePtr& ResidencyCache::acquire(unsigned int block, bool write)
+	{
+		impl->checkBlock(block);
+
+		int index = impl->blockSlot[block];
+		if(index >= 0)
+		{
+			impl_t::slot_t &slot = impl->slots[index];
+			if(slot.prefetched)
+			{
+				impl->stream.wait(*slot.ready);
+				slot.prefetched = false;
+				++impl->stats.prefetchHits;
+			}
+			++impl->stats.hits;
+		} else
+		{
+			index = impl->victim(false);
+			if(index < 0) throw Exception("All blocks of the residency cache are acquired");
+
+			// Write-backs on the side stream must land before the host data is read again
+			if(impl->sidePending)
+			{
+				impl->stream.wait(*impl->lastSide);
+				impl->sidePending = false;
+			}
+
+			impl->evict(index, impl->stream);
+
+			impl_t::slot_t &slot = impl->slots[index];
+			memcpy(slot.ptr, impl->host(block), impl->bytes(block), impl->stream);
+			slot.block = block;
+			impl->blockSlot[block] = index;
+			++impl->stats.misses;
+		}
+
+		impl_t::slot_t &slot = impl->slots[index];
+		impl->touch(index);
+		++slot.pins;
+		if(write) slot.dirty = true;
+
+		for(unsigned int i = 1; i <= impl->distance && block + i < impl->blockSlot.size(); ++i)
+		{
+			if(!prefetch(block + i)) break;
+		}
+
+		return slot.ptr;
+	}
+
+	void ResidencyCache::release(unsigned int block)
+	{
+		impl->checkBlock(block);
+
+		const int index = impl->blockSlot[block];
+		if(index < 0 || !impl->slots[index].pins) throw Exception("Block of the residency cache not acquired");
+		--impl->slots[index].pins;
+	}
+
+	bool ResidencyCache::prefetch(unsigned int block)
+	{
+		impl->checkBlock(block);
+		if(impl->blockSlot[block] >= 0) return true;
+
+		const int index = impl->victim(true);
+		if(index < 0) return false;
+
+		// Kernels issued so far may still use the evicted block
+		impl->accessed.record(impl->stream);
+		impl->side.wait(impl->accessed);
+
+		impl->evict(index, impl->side);
+
+		impl_t::slot_t &slot = impl->slots[index];
+		memcpy(slot.ptr, impl->host(block), impl->bytes(block), impl->side);
+		slot.ready->record(impl->side);
+		slot.prefetched = true;
+		slot.block = block;
+		impl->blockSlot[block] = index;
+		impl->touch(index);
+
+		impl->lastSide = slot.ready;
+		impl->sidePending = true;
+		++impl->stats.prefetches;
+		return true;
+	}
+
+	void ResidencyCache::markDirty(unsigned int block)
+	{
+		impl->checkBlock(block);
+
+		const int index = impl->blockSlot[block];
+		if(index < 0) throw Exception("Block of the residency cache not resident");
+		impl->slots[index].dirty = true;
+	}
+
+	unsigned int ResidencyCache::writeBack()
+	{
+		unsigned int written = 0;
+		for(std::vector<impl_t::slot_t>::iterator slot = impl->slots.begin(); slot != impl->slots.end(); ++slot)
+		{
+			if(slot->block < 0 || !slot->dirty) continue;
+
+			memcpy(impl->host(slot->block), slot->ptr, impl->bytes(slot->block), impl->stream);
+			slot->dirty = false;
+			++written;
+		}
+
+		impl->stats.writeBacks += written;
+		return written;
+	}
+
+	bool ResidencyCache::resident(unsigned int block) const
+	{
+		impl->checkBlock(block);
+		return impl->blockSlot[block] >= 0;
+	}
+
+	unsigned int ResidencyCache::blocks() const
+	{
+		return impl->blockSlot.size();
+	}
+
+	unsigned int ResidencyCache::blockBytes(unsigned int block) const
+	{
+		impl->checkBlock(block);
+		return impl->bytes(block);
+	}
+
+	const Stream& ResidencyCache::prefetchStream() const
+	{
+		return impl->side;
+	}
+
+	ResidencyStats ResidencyCache::stats() const
+	{
+		return impl->stats;
+	}
+}
@@ -1,9 +1,57 @@
+#include <exception>
+#include <iostream>
+
+#define BOOST_BIND_GLOBAL_PLACEHOLDERS
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+
 #include <cuda.h>
 
 #include <cudamm/stream.hpp>
+#include <cudamm/waitpolicy.hpp>
 
+#include <detail/context.hpp>
 #include <detail/error.hpp>
+#include <detail/event_impl.hpp>
 #include <detail/stream_impl.hpp>
+#include <detail/wait.hpp>
+
+namespace
+{
+	void CUDA_CB callbackTrampoline(CUstream, CUresult status, void *data)
+	{
+		boost::scoped_ptr<boost::function<void (bool)> > callback(static_cast<boost::function<void (bool)> *>(data));
+
+		// Exceptions must not propagate into the driver
+		try
+		{
+			(*callback)(status == CUDA_SUCCESS);
+		} catch(std::exception const &e)
+		{
+			std::cerr << "Cuda stream callback failed: " << e.what() << std::endl;
+		} catch(...)
+		{
+			std::cerr << "Cuda stream callback failed" << std::endl;
+		}
+	}
+
+	/// Blocking part of a policy wait
+	struct synchronize_t
+	{
+		explicit synchronize_t(CUstream stream)
+			: stream(stream)
+		{
+		}
+
+		void operator()() const
+		{
+			cuda::detail::error_check(cuStreamSynchronize(stream),
+				"Can't synchronize Cuda stream");
+		}
+
+		CUstream stream;
+	};
+}
 
 namespace cuda
 {
@@ -12,6 +60,23 @@ namespace cuda
 	{
 		detail::error_check(cuStreamCreate(&impl->stream, 0),
 			"Can't create Cuda stream");
+		impl->context = detail::current_context();
+	}
+
+	Stream::Stream(unsigned int flags, int priority)
+		: impl(new impl_t)
+	{
+		if(priority)
+		{
+			detail::error_check(cuStreamCreateWithPriority(&impl->stream, flags, priority),
+				"Can't create Cuda stream with priority");
+		}
+		else
+		{
+			detail::error_check(cuStreamCreate(&impl->stream, flags),
+				"Can't create Cuda stream");
+		}
+		impl->context = detail::current_context();
 	}
 	
 	Stream::~Stream()
@@ -22,16 +87,64 @@ namespace cuda
 	
 	void Stream::synchronize() const
 	{
+		detail::context_check(impl->context, "Can't synchronize Cuda stream");
+
+		WaitPolicy policy;
+		if(WaitPolicy::contextDefault(policy))
+		{
+			synchronize(policy);
+			return;
+		}
+
 		detail::error_check(cuStreamSynchronize(impl->stream),
 			"Can't synchronize Cuda stream");
 	}
+
+	void Stream::synchronize(const WaitPolicy &policy) const
+	{
+		detail::wait(policy, boost::bind(&Stream::query, this), synchronize_t(impl->stream));
+	}
 	
 	bool Stream::query() const
 	{
+		detail::context_check(impl->context, "Can't query Cuda stream state");
 		CUresult result = cuStreamQuery(impl->stream);
 		if(result == CUDA_ERROR_NOT_READY) return false;
 		detail::error_check(result, "Can't query Cuda stream state");
 		return true;
 	}
-}
 
+	int Stream::priority() const
+	{
+		detail::context_check(impl->context, "Can't get Cuda stream priority");
+
+		int priority;
+		detail::error_check(cuStreamGetPriority(impl->stream, &priority),
+			"Can't get Cuda stream priority");
+		return priority;
+	}
+
+	void Stream::priorityRange(int &least, int &greatest)
+	{
+		detail::error_check(cuCtxGetStreamPriorityRange(&least, &greatest),
+			"Can't get Cuda stream priority range");
+	}
+
+	void Stream::callback(const boost::function<void (bool)> &callback) const
+	{
+		detail::context_check(impl->context, "Can't add Cuda stream callback");
+
+		boost::function<void (bool)> *data = new boost::function<void (bool)>(callback);
+		CUresult result = cuStreamAddCallback(impl->stream, callbackTrampoline, data, 0);
+		if(result != CUDA_SUCCESS) delete data;
+		detail::error_check(result, "Can't add Cuda stream callback");
+	}
+
+	void Stream::wait(const Event &event) const
+	{
+		// The event may belong to another context, the device synchronizes across contexts
+		detail::context_check(impl->context, "Can't make Cuda stream wait for event");
+		detail::error_check(cuStreamWaitEvent(impl->stream, event.impl->event, 0),
+			"Can't make Cuda stream wait for event");
+	}
+}
@@ -0,0 +1,91 @@
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <cudamm/exception.hpp>
+#include <cudamm/streampool.hpp>
+
+namespace cuda
+{
+	struct StreamPool::impl_t
+	{
+		std::vector<boost::shared_ptr<Stream> > streams;
+		Policy policy;
+
+		boost::mutex mutex;
+		unsigned int cursor;
+
+		// Hand-outs since each stream was last seen idle
+		std::vector<unsigned int> load;
+	};
+
+	StreamPool::StreamPool(unsigned int size, Policy policy, unsigned int flags, int priority)
+		: impl(new impl_t)
+	{
+		if(!size) throw Exception("Stream pool needs at least one stream");
+
+		for(unsigned int i = 0; i < size; ++i)
+		{
+			impl->streams.push_back(boost::shared_ptr<Stream>(new Stream(flags, priority)));
+		}
+		impl->policy = policy;
+		impl->cursor = 0;
+		impl->load.assign(size, 0);
+	}
+
+	StreamPool::~StreamPool()
+	{
+	}
+
+	const Stream& StreamPool::next()
+	{
+		boost::mutex::scoped_lock lock(impl->mutex);
+
+		const unsigned int size = impl->streams.size();
+		unsigned int index = impl->cursor;
+
+		if(impl->policy == LEAST_LOADED)
+		{
+			// Scan from the cursor so ties rotate; an idle stream ends the search
+			unsigned int best = index;
+			for(unsigned int i = 0; i < size; ++i)
+			{
+				const unsigned int candidate = (impl->cursor + i) % size;
+				if(impl->streams[candidate]->query())
+				{
+					impl->load[candidate] = 0;
+					best = candidate;
+					break;
+				}
+				if(impl->load[candidate] < impl->load[best]) best = candidate;
+			}
+			index = best;
+		}
+
+		impl->cursor = (index + 1) % size;
+		++impl->load[index];
+		return *impl->streams[index];
+	}
+
+	unsigned int StreamPool::size() const
+	{
+		return impl->streams.size();
+	}
+
+	const Stream& StreamPool::operator[](unsigned int index) const
+	{
+		if(index >= impl->streams.size()) throw Exception("Unknown stream pool stream");
+		return *impl->streams[index];
+	}
+
+	void StreamPool::synchronize() const
+	{
+		for(unsigned int i = 0; i < impl->streams.size(); ++i)
+		{
+			impl->streams[i]->synchronize();
+			boost::mutex::scoped_lock lock(impl->mutex);
+			impl->load[i] = 0;
+		}
+	}
+}
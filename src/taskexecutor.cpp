@@ -0,0 +1,160 @@
+#include <vector>
+
+#define BOOST_BIND_GLOBAL_PLACEHOLDERS
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <cudamm/exception.hpp>
+#include <cudamm/deviceptr.hpp>
+#include <cudamm/event.hpp>
+#include <cudamm/eventpool.hpp>
+#include <cudamm/launchrecord.hpp>
+#include <cudamm/memcpy2d.hpp>
+#include <cudamm/stream.hpp>
+#include <cudamm/taskexecutor.hpp>
+
+namespace cuda
+{
+	struct TaskExecutor::impl_t
+	{
+		typedef std::vector<boost::shared_ptr<Event> > events_t;
+
+		std::vector<boost::shared_ptr<Stream> > streams;
+
+		// Dependency events, timing disabled
+		EventPool pool;
+		events_t events;
+
+		bool timing;
+		events_t starts, ends;
+
+		// Number of nodes of the last executed graph
+		unsigned int nodes;
+
+		TaskSchedule schedule;
+
+		/// Grow a list of timing events to a size
+		static void reserve(events_t &events, unsigned int size)
+		{
+			while(events.size() < size) events.push_back(boost::shared_ptr<Event>(new Event));
+		}
+	};
+
+	TaskExecutor::TaskExecutor(unsigned int streams, bool timing)
+		: impl(new impl_t)
+	{
+		if(!streams) throw Exception("Task executor needs at least one stream");
+
+		for(unsigned int i = 0; i < streams; ++i) impl->streams.push_back(boost::shared_ptr<Stream>(new Stream));
+		impl->timing = timing;
+		impl->nodes = 0;
+	}
+
+	TaskExecutor::~TaskExecutor()
+	{
+	}
+
+	unsigned int TaskExecutor::streams() const
+	{
+		return impl->streams.size();
+	}
+
+	const Stream& TaskExecutor::stream(unsigned int index) const
+	{
+		if(index >= impl->streams.size()) throw Exception("Unknown task executor stream");
+		return *impl->streams[index];
+	}
+
+	const TaskSchedule& TaskExecutor::execute(const TaskGraph &graph)
+	{
+		impl->schedule = scheduleTasks(graph, impl->streams.size());
+		execute(graph, impl->schedule);
+		return impl->schedule;
+	}
+
+	void TaskExecutor::execute(const TaskGraph &graph, const TaskSchedule &schedule)
+	{
+		if(schedule.streams > impl->streams.size()) throw Exception("Task schedule needs more streams than available");
+
+		while(impl->events.size() < schedule.events) impl->events.push_back(impl->pool.acquire());
+		if(impl->timing)
+		{
+			impl_t::reserve(impl->starts, graph.size());
+			impl_t::reserve(impl->ends, graph.size());
+		}
+
+		impl->nodes = graph.size();
+		executeTasks(graph, schedule, *this);
+	}
+
+	void TaskExecutor::synchronize() const
+	{
+		for(unsigned int i = 0; i < impl->streams.size(); ++i) impl->streams[i]->synchronize();
+	}
+
+	std::vector<float> TaskExecutor::times() const
+	{
+		if(!impl->timing) throw Exception("Task executor has timing disabled");
+
+		std::vector<float> times(impl->nodes);
+		for(unsigned int i = 0; i < times.size(); ++i) times[i] = *impl->ends[i] - *impl->starts[i];
+		return times;
+	}
+
+	float TaskExecutor::criticalPath(const TaskGraph &graph) const
+	{
+		return graph.criticalPath(times());
+	}
+
+	void TaskExecutor::run(const TaskGraph &graph, TaskGraph::Node node, unsigned int stream)
+	{
+		const Stream &s = *impl->streams[stream];
+
+		if(impl->timing) impl->starts[node]->record(s);
+		graph.work(node)(s);
+		if(impl->timing) impl->ends[node]->record(s);
+	}
+
+	void TaskExecutor::record(unsigned int event, unsigned int stream)
+	{
+		impl->events[event]->record(*impl->streams[stream]);
+	}
+
+	void TaskExecutor::wait(unsigned int stream, unsigned int event)
+	{
+		impl->streams[stream]->wait(*impl->events[event]);
+	}
+
+	TaskGraph::Work copyTask(const Memcpy2D &copy)
+	{
+		return boost::bind(static_cast<void (Memcpy2D::*)(const Stream &) const>(&Memcpy2D::copy), copy, _1);
+	}
+
+	TaskGraph::Work copyTask(const DevicePtr &dest, const void *src, unsigned int len)
+	{
+		return boost::bind(static_cast<void (*)(const DevicePtr &, const void *, unsigned int, const Stream &)>(&cuda::memcpy),
+			dest, src, len, _1);
+	}
+
+	TaskGraph::Work copyTask(void *dest, const DevicePtr &src, unsigned int len)
+	{
+		return boost::bind(static_cast<void (*)(void *, const DevicePtr &, unsigned int, const Stream &)>(&cuda::memcpy),
+			dest, src, len, _1);
+	}
+
+	TaskGraph::Work launchTask(const LaunchRecord &record)
+	{
+		return boost::bind(static_cast<void (LaunchRecord::*)(const Stream &) const>(&LaunchRecord::replay), record, _1);
+	}
+
+	TaskGraph::Work memsetTask(const DevicePtr &ptr, unsigned int value, unsigned int count)
+	{
+		return boost::bind(static_cast<void (*)(const DevicePtr &, unsigned int, unsigned int, const Stream &)>(&cuda::memset32),
+			ptr, value, count, _1);
+	}
+
+	TaskGraph::Work hostTask(const boost::function<void (bool)> &callback)
+	{
+		return boost::bind(&Stream::callback, _1, callback);
+	}
+}
@@ -0,0 +1,291 @@
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <vector>
+
+#include <cudamm/exception.hpp>
+#include <cudamm/taskgraph.hpp>
+
+// Host-only, the scheduling does not call the Cuda driver
+
+namespace
+{
+	/// Orders nodes by issue position, latest first
+	struct issued_later
+	{
+		explicit issued_later(const std::vector<unsigned int> &issue)
+			: issue(issue)
+		{
+		}
+
+		bool operator()(cuda::TaskGraph::Node a, cuda::TaskGraph::Node b) const
+		{
+			return issue[a] > issue[b];
+		}
+
+		const std::vector<unsigned int> &issue;
+	};
+}
+
+namespace cuda
+{
+	struct TaskGraph::impl_t
+	{
+		struct node_t
+		{
+			Work work;
+			float cost;
+			std::vector<Node> dependencies;
+		};
+
+		node_t& node(Node index)
+		{
+			if(index >= nodes.size()) throw Exception("Unknown task graph node");
+			return nodes[index];
+		}
+
+		const node_t& node(Node index) const
+		{
+			if(index >= nodes.size()) throw Exception("Unknown task graph node");
+			return nodes[index];
+		}
+
+		std::vector<node_t> nodes;
+	};
+
+	TaskGraph::TaskGraph()
+		: impl(new impl_t)
+	{
+	}
+
+	TaskGraph::~TaskGraph()
+	{
+	}
+
+	TaskGraph::Node TaskGraph::add(const Work &work, float cost)
+	{
+		impl_t::node_t node;
+		node.work = work;
+		node.cost = cost;
+		impl->nodes.push_back(node);
+		return impl->nodes.size() - 1;
+	}
+
+	void TaskGraph::depend(Node node, Node on)
+	{
+		impl->node(on);
+		std::vector<Node> &dependencies = impl->node(node).dependencies;
+		if(node == on) throw Exception("Task graph node can't depend on itself");
+
+		if(std::find(dependencies.begin(), dependencies.end(), on) == dependencies.end()) dependencies.push_back(on);
+	}
+
+	unsigned int TaskGraph::size() const
+	{
+		return impl->nodes.size();
+	}
+
+	const TaskGraph::Work& TaskGraph::work(Node node) const
+	{
+		return impl->node(node).work;
+	}
+
+	float TaskGraph::cost(Node node) const
+	{
+		return impl->node(node).cost;
+	}
+
+	void TaskGraph::setCost(Node node, float cost)
+	{
+		impl->node(node).cost = cost;
+	}
+
+	const std::vector<TaskGraph::Node>& TaskGraph::dependencies(Node node) const
+	{
+		return impl->node(node).dependencies;
+	}
+
+	std::vector<TaskGraph::Node> TaskGraph::order() const
+	{
+		const unsigned int n = impl->nodes.size();
+
+		std::vector<unsigned int> pending(n);
+		std::vector<std::vector<Node> > dependents(n);
+		for(Node node = 0; node < n; ++node)
+		{
+			const std::vector<Node> &dependencies = impl->nodes[node].dependencies;
+			pending[node] = dependencies.size();
+			for(std::vector<Node>::const_iterator it = dependencies.begin(); it != dependencies.end(); ++it)
+			{
+				dependents[*it].push_back(node);
+			}
+		}
+
+		// Smallest ready node first keeps independent nodes in the order they were added
+		std::priority_queue<Node, std::vector<Node>, std::greater<Node> > ready;
+		for(Node node = 0; node < n; ++node)
+		{
+			if(!pending[node]) ready.push(node);
+		}
+
+		std::vector<Node> order;
+		order.reserve(n);
+		while(!ready.empty())
+		{
+			const Node node = ready.top();
+			ready.pop();
+			order.push_back(node);
+
+			for(std::vector<Node>::const_iterator it = dependents[node].begin(); it != dependents[node].end(); ++it)
+			{
+				if(!--pending[*it]) ready.push(*it);
+			}
+		}
+
+		if(order.size() != n) throw Exception("Task graph has a dependency cycle");
+		return order;
+	}
+
+	float TaskGraph::criticalPath() const
+	{
+		std::vector<float> times(impl->nodes.size());
+		for(Node node = 0; node < times.size(); ++node) times[node] = impl->nodes[node].cost;
+		return criticalPath(times);
+	}
+
+	float TaskGraph::criticalPath(const std::vector<float> &times) const
+	{
+		if(times.size() != impl->nodes.size()) throw Exception("Task graph times don't match nodes");
+
+		const std::vector<Node> nodes = order();
+
+		// Longest chain ending at each node, dependencies are visited first
+		std::vector<float> finish(nodes.size(), 0.0f);
+		float longest = 0.0f;
+		for(std::vector<Node>::const_iterator node = nodes.begin(); node != nodes.end(); ++node)
+		{
+			float start = 0.0f;
+			const std::vector<Node> &dependencies = impl->nodes[*node].dependencies;
+			for(std::vector<Node>::const_iterator it = dependencies.begin(); it != dependencies.end(); ++it)
+			{
+				start = std::max(start, finish[*it]);
+			}
+
+			finish[*node] = start + times[*node];
+			longest = std::max(longest, finish[*node]);
+		}
+
+		return longest;
+	}
+
+	TaskSchedule scheduleTasks(const TaskGraph &graph, unsigned int streams)
+	{
+		if(!streams) throw Exception("Can't schedule tasks on no streams");
+
+		const std::vector<TaskGraph::Node> order = graph.order();
+		const unsigned int n = order.size();
+
+		TaskSchedule schedule;
+		schedule.streams = 0;
+		schedule.events = 0;
+		schedule.steps.reserve(n);
+
+		std::vector<unsigned int> issue(n), streamOf(n), position(n);
+		std::vector<int> eventOf(n, -1);
+		std::vector<float> finish(n);
+
+		// Vector clocks: known[s][t] is how many nodes of stream t stream s
+		// has waited for (or run itself), clock[node] the same for node's stream
+		// right after node. A dependency needs no wait if it is already known.
+		std::vector<std::vector<unsigned int> > known(streams, std::vector<unsigned int>(streams, 0));
+		std::vector<std::vector<unsigned int> > clock(n);
+
+		std::vector<float> ready(streams, 0.0f);
+		std::vector<int> tail(streams, -1);
+
+		for(unsigned int i = 0; i < n; ++i)
+		{
+			const TaskGraph::Node node = order[i];
+			issue[node] = i;
+
+			std::vector<TaskGraph::Node> dependencies = graph.dependencies(node);
+
+			float dependenciesDone = 0.0f;
+			for(std::vector<TaskGraph::Node>::const_iterator it = dependencies.begin(); it != dependencies.end(); ++it)
+			{
+				dependenciesDone = std::max(dependenciesDone, finish[*it]);
+			}
+
+			// Earliest start, then following a dependency on its stream, then lowest index
+			unsigned int stream = 0;
+			float bestStart = 0.0f;
+			bool bestFollows = false;
+			for(unsigned int s = 0; s < streams; ++s)
+			{
+				const float start = std::max(ready[s], dependenciesDone);
+				const bool follows = tail[s] >= 0 &&
+					std::find(dependencies.begin(), dependencies.end(), static_cast<TaskGraph::Node>(tail[s])) != dependencies.end();
+
+				if(!s || start < bestStart || (start == bestStart && follows && !bestFollows))
+				{
+					stream = s;
+					bestStart = start;
+					bestFollows = follows;
+				}
+			}
+
+			TaskStep step;
+			step.node = node;
+			step.stream = stream;
+			step.record = -1;
+
+			// A wait for a later node covers everything that node's stream waited for
+			std::sort(dependencies.begin(), dependencies.end(), issued_later(issue));
+			std::vector<unsigned int> &streamKnown = known[stream];
+			for(std::vector<TaskGraph::Node>::const_iterator it = dependencies.begin(); it != dependencies.end(); ++it)
+			{
+				if(streamKnown[streamOf[*it]] >= position[*it]) continue;
+
+				if(eventOf[*it] < 0)
+				{
+					eventOf[*it] = schedule.events++;
+					schedule.steps[issue[*it]].record = eventOf[*it];
+				}
+				step.waits.push_back(eventOf[*it]);
+
+				const std::vector<unsigned int> &producer = clock[*it];
+				for(unsigned int s = 0; s < streams; ++s) streamKnown[s] = std::max(streamKnown[s], producer[s]);
+			}
+
+			streamOf[node] = stream;
+			position[node] = ++streamKnown[stream];
+			clock[node] = streamKnown;
+
+			finish[node] = bestStart + graph.cost(node);
+			ready[stream] = finish[node];
+			tail[stream] = node;
+			schedule.streams = std::max(schedule.streams, stream + 1);
+
+			schedule.steps.push_back(step);
+		}
+
+		schedule.criticalPath = graph.criticalPath();
+		schedule.makespan = n ? *std::max_element(ready.begin(), ready.end()) : 0.0f;
+		return schedule;
+	}
+
+	void executeTasks(const TaskGraph &graph, const TaskSchedule &schedule, TaskBackend &backend)
+	{
+		for(std::vector<TaskStep>::const_iterator step = schedule.steps.begin(); step != schedule.steps.end(); ++step)
+		{
+			for(std::vector<unsigned int>::const_iterator event = step->waits.begin(); event != step->waits.end(); ++event)
+			{
+				backend.wait(step->stream, *event);
+			}
+
+			backend.run(graph, step->node, step->stream);
+
+			if(step->record >= 0) backend.record(step->record, step->stream);
+		}
+	}
+}
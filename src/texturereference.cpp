@@ -4,6 +4,7 @@
 #include <cudamm/array.hpp>
 #include <cudamm/texturereference.hpp>
 
+#include <detail/context.hpp>
 #include <detail/error.hpp>
 #include <detail/module_impl.hpp>
 #include <detail/deviceptr_impl.hpp>
@@ -15,19 +16,22 @@ namespace cuda
 	TextureReference::TextureReference(Module &mod, const char *name)
 		: impl(new impl_t)
 	{
-		cuda::detail::error_check(cuModuleGetTexRef(&impl->texref, mod.impl->mod, name),
-			"Can't get Cuda texture reference from module");
+		impl->texref = mod.impl->texref(name);
+		impl->context = mod.impl->context;
 	}
 
 	
 	TextureReference::~TextureReference()
 	{
-		detail::error_warn(cuTexRefDestroy(impl->texref),
-			"Can't destroy Cuda texture reference");
+		// The texture reference belongs to its module and is shared through
+		// the module's cache, so it must not be destroyed here.
 	}
 
 	unsigned int TextureReference::bind(const DevicePtr &ptr, int size) const
 	{
+		detail::context_check(impl->context, "Can't bind Cuda texture to device memory");
+		detail::context_check(ptr.impl->context, "Can't bind Cuda texture to device memory");
+
 		unsigned int offset;
 		detail::error_check(cuTexRefSetAddress(&offset, impl->texref, ptr.impl->devicePtr, size),
 			"Can't bind Cuda texture to device memory");
@@ -36,6 +40,9 @@ namespace cuda
 
 	void TextureReference::bind(const Array &array) const
 	{
+		detail::context_check(impl->context, "Can't bind Cuda texture reference to device array");
+		detail::context_check(array.impl->context, "Can't bind Cuda texture reference to device array");
+
 		detail::error_check(cuTexRefSetArray(impl->texref, array.impl->array, CU_TRSA_OVERRIDE_FORMAT),
 			"Can't bind Cuda texture reference to device array");
 	}
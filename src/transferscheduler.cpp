@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <iostream>
+
+#define BOOST_BIND_GLOBAL_PLACEHOLDERS
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <cudamm/deviceptr.hpp>
+#include <cudamm/event.hpp>
+#include <cudamm/exception.hpp>
+#include <cudamm/memcpy2d.hpp>
+#include <cudamm/stream.hpp>
+#include <cudamm/transferscheduler.hpp>
+
+namespace
+{
+	/// Complete a queued copy with the outcome of the issued one
+	void completeTransfer(const cuda::Completion &issued, const cuda::CompletionSource &source)
+	{
+		try
+		{
+			issued.wait();
+			source.complete();
+		} catch(std::exception const &e)
+		{
+			source.fail(e.what());
+		}
+	}
+}
+
+namespace cuda
+{
+	struct TransferScheduler::impl_t
+	{
+		/// Queued copy
+		struct request_t
+		{
+			request_t()
+				: host(0)
+				, len(0)
+				, offset(0)
+			{
+			}
+
+			// 1D copies
+			DevicePtr device;
+			void *host;
+			unsigned int len;
+
+			// 2D copies
+			boost::shared_ptr<Memcpy2D> copy;
+
+			// Bytes issued so far
+			unsigned int offset;
+
+			CompletionSource source;
+		};
+
+		/// Copies of one flush in one direction, timed with events
+		struct batch_t
+		{
+			boost::shared_ptr<Event> start, end;
+			unsigned long transfers, bytes;
+		};
+
+		/// Queue, stream and timing of one direction
+		struct direction_t
+		{
+			direction_t()
+				: stream(Stream::NON_BLOCKING)
+			{
+				stats = TransferStats();
+			}
+
+			Stream stream;
+			std::deque<request_t> requests;
+
+			// Batches not completed on the device yet
+			std::deque<batch_t> batches;
+			TransferStats stats;
+		};
+
+		impl_t(CompletionEngine &engine, unsigned int chunkBytes)
+			: engine(engine)
+			, chunkBytes(chunkBytes)
+			, uploaded(Event::DISABLE_TIMING)
+			, computed(Event::DISABLE_TIMING)
+		{
+		}
+
+		/// Issue the next chunk of the oldest copy of a direction
+		/**
+			@return the bytes issued
+		*/
+		unsigned int issue(Direction direction);
+
+		/// Add completed batches to the statistics
+		void collect(direction_t &direction) const;
+
+		CompletionEngine &engine;
+		unsigned int chunkBytes;
+
+		// Indexed by Direction
+		mutable direction_t directions[2];
+
+		Event uploaded, computed;
+	};
+
+	unsigned int TransferScheduler::impl_t::issue(Direction direction)
+	{
+		direction_t &d = directions[direction];
+		request_t &request = d.requests.front();
+
+		unsigned int bytes;
+		try
+		{
+			if(request.copy)
+			{
+				request.copy->copy(d.stream);
+				bytes = request.copy->bytes();
+				request.offset = request.len;
+			} else
+			{
+				bytes = chunkBytes ? std::min(chunkBytes, request.len - request.offset) : request.len;
+				if(direction == UPLOAD)
+				{
+					memcpy(request.device + request.offset, static_cast<const char *>(request.host) + request.offset, bytes, d.stream);
+				} else
+				{
+					memcpy(static_cast<char *>(request.host) + request.offset, request.device + request.offset, bytes, d.stream);
+				}
+				request.offset += bytes;
+			}
+
+			if(request.offset == request.len)
+			{
+				const Completion issued = engine.enqueue(d.stream);
+				issued.then(boost::bind(completeTransfer, issued, request.source));
+				d.requests.pop_front();
+			}
+		} catch(std::exception const &e)
+		{
+			// The rest of a failed copy is dropped
+			request.source.fail(e.what());
+			d.requests.pop_front();
+			return 0;
+		}
+
+		return bytes;
+	}
+
+	void TransferScheduler::impl_t::collect(direction_t &direction) const
+	{
+		while(!direction.batches.empty() && direction.batches.front().end->query())
+		{
+			const batch_t &batch = direction.batches.front();
+			direction.stats.transfers += batch.transfers;
+			direction.stats.bytes += batch.bytes;
+			direction.stats.milliseconds += *batch.end - *batch.start;
+			direction.batches.pop_front();
+		}
+	}
+
+	TransferScheduler::TransferScheduler(CompletionEngine &engine, unsigned int chunkBytes)
+		: impl(new impl_t(engine, chunkBytes))
+	{
+	}
+
+	TransferScheduler::~TransferScheduler()
+	{
+		for(unsigned int i = 0; i < 2; ++i)
+		{
+			impl_t::direction_t &d = impl->directions[i];
+			for(std::deque<impl_t::request_t>::iterator it = d.requests.begin(); it != d.requests.end(); ++it)
+			{
+				it->source.fail("Transfer scheduler destroyed before issuing the copy");
+			}
+
+			try
+			{
+				d.stream.synchronize();
+			} catch(Exception const &e)
+			{
+				std::cerr << e.what() << std::endl;
+			}
+		}
+	}
+
+	Completion TransferScheduler::upload(const DevicePtr &dest, const void *src, unsigned int len)
+	{
+		impl_t::request_t request;
+		request.device = dest;
+		request.host = const_cast<void *>(src);
+		request.len = len;
+		impl->directions[UPLOAD].requests.push_back(request);
+		return request.source.completion();
+	}
+
+	Completion TransferScheduler::download(void *dest, const DevicePtr &src, unsigned int len)
+	{
+		impl_t::request_t request;
+		request.device = src;
+		request.host = dest;
+		request.len = len;
+		impl->directions[DOWNLOAD].requests.push_back(request);
+		return request.source.completion();
+	}
+
+	Completion TransferScheduler::copy(const Memcpy2D &copy)
+	{
+		if(!copy.complete()) throw Exception("2D copy without source or destination");
+		if(copy.fromHost() == copy.toHost()) throw Exception("2D copy is neither an upload nor a download");
+
+		impl_t::request_t request;
+		request.copy.reset(new Memcpy2D(copy));
+		impl->directions[copy.fromHost() ? UPLOAD : DOWNLOAD].requests.push_back(request);
+		return request.source.completion();
+	}
+
+	void TransferScheduler::flush()
+	{
+		impl_t::batch_t batches[2];
+		for(unsigned int i = 0; i < 2; ++i)
+		{
+			batches[i].transfers = impl->directions[i].requests.size();
+			batches[i].bytes = 0;
+			if(!batches[i].transfers) continue;
+
+			batches[i].start.reset(new Event());
+			batches[i].start->record(impl->directions[i].stream);
+		}
+
+		// Alternate between the directions so both copy engines get work
+		while(!impl->directions[UPLOAD].requests.empty() || !impl->directions[DOWNLOAD].requests.empty())
+		{
+			if(!impl->directions[UPLOAD].requests.empty()) batches[UPLOAD].bytes += impl->issue(UPLOAD);
+			if(!impl->directions[DOWNLOAD].requests.empty()) batches[DOWNLOAD].bytes += impl->issue(DOWNLOAD);
+		}
+
+		for(unsigned int i = 0; i < 2; ++i)
+		{
+			if(!batches[i].transfers) continue;
+
+			batches[i].end.reset(new Event());
+			batches[i].end->record(impl->directions[i].stream);
+			impl->directions[i].batches.push_back(batches[i]);
+			impl->collect(impl->directions[i]);
+		}
+	}
+
+	void TransferScheduler::uploadsBefore(const Stream &compute) const
+	{
+		impl->uploaded.record(impl->directions[UPLOAD].stream);
+		compute.wait(impl->uploaded);
+	}
+
+	void TransferScheduler::downloadsAfter(const Stream &compute) const
+	{
+		impl->computed.record(compute);
+		impl->directions[DOWNLOAD].stream.wait(impl->computed);
+	}
+
+	const Stream& TransferScheduler::stream(Direction direction) const
+	{
+		return impl->directions[direction].stream;
+	}
+
+	unsigned int TransferScheduler::queued(Direction direction) const
+	{
+		return impl->directions[direction].requests.size();
+	}
+
+	TransferStats TransferScheduler::stats(Direction direction) const
+	{
+		impl->collect(impl->directions[direction]);
+		return impl->directions[direction].stats;
+	}
+}
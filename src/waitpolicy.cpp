@@ -0,0 +1,120 @@
+#include <map>
+
+#include <boost/thread/mutex.hpp>
+
+#include <cuda.h>
+
+#include <cudamm/exception.hpp>
+#include <cudamm/stream.hpp>
+#include <cudamm/waitpolicy.hpp>
+
+#include <detail/error.hpp>
+#include <detail/wait.hpp>
+
+namespace
+{
+	typedef std::map<CUcontext, cuda::WaitPolicy> defaults_t;
+
+	boost::mutex defaultsMutex;
+	defaults_t defaults;
+
+	// Lets synchronize skip the lookup while no default was ever set
+	volatile bool anyDefaults = false;
+
+	/// Stamps the time the stream reached the callback
+	struct stamp_t
+	{
+		explicit stamp_t(volatile double *time)
+			: time(time)
+		{
+		}
+
+		void operator()(bool) const
+		{
+			*time = cuda::detail::now();
+		}
+
+		volatile double *time;
+	};
+}
+
+namespace cuda
+{
+	unsigned int WaitPolicy::contextFlags() const
+	{
+		switch(strategy)
+		{
+			case SPIN: return CU_CTX_SCHED_SPIN;
+			case YIELD: return CU_CTX_SCHED_YIELD;
+			default: return CU_CTX_SCHED_BLOCKING_SYNC;
+		}
+	}
+
+	void WaitPolicy::setContextDefault(const WaitPolicy &policy)
+	{
+		CUcontext context;
+		detail::error_check(cuCtxGetCurrent(&context), "Can't get current Cuda context");
+		if(!context) throw Exception("No current Cuda context");
+
+		boost::mutex::scoped_lock lock(defaultsMutex);
+		defaults[context] = policy;
+		anyDefaults = true;
+	}
+
+	void WaitPolicy::clearContextDefault()
+	{
+		CUcontext context;
+		if(cuCtxGetCurrent(&context) != CUDA_SUCCESS || !context) return;
+
+		boost::mutex::scoped_lock lock(defaultsMutex);
+		defaults.erase(context);
+	}
+
+	bool WaitPolicy::contextDefault(WaitPolicy &policy)
+	{
+		if(!anyDefaults) return false;
+
+		CUcontext context;
+		if(cuCtxGetCurrent(&context) != CUDA_SUCCESS || !context) return false;
+
+		boost::mutex::scoped_lock lock(defaultsMutex);
+		defaults_t::const_iterator it = defaults.find(context);
+		if(it == defaults.end()) return false;
+		policy = it->second;
+		return true;
+	}
+
+	WaitMeasurement measureWait(const WaitPolicy &policy, const Stream &stream,
+		const boost::function<void (const Stream &)> &work, unsigned int samples)
+	{
+		WaitMeasurement measurement;
+		measurement.samples = samples;
+		measurement.wakeMicroseconds = 0.0;
+		measurement.wallMicroseconds = 0.0;
+		measurement.cpuMicroseconds = 0.0;
+		if(!samples) return measurement;
+
+		// Completed before the callback returns, which the synchronize waits for
+		volatile double completed = 0.0;
+
+		for(unsigned int i = 0; i < samples; ++i)
+		{
+			work(stream);
+			stream.callback(stamp_t(&completed));
+
+			const double wall = detail::now();
+			const double cpu = detail::threadTime();
+			stream.synchronize(policy);
+			const double returned = detail::now();
+
+			measurement.cpuMicroseconds += detail::threadTime() - cpu;
+			measurement.wallMicroseconds += returned - wall;
+			measurement.wakeMicroseconds += returned - completed;
+		}
+
+		measurement.wakeMicroseconds /= samples;
+		measurement.wallMicroseconds /= samples;
+		measurement.cpuMicroseconds /= samples;
+		return measurement;
+	}
+}
@@ -0,0 +1,42 @@
+#ifndef CUDA_TEST_CHECK_HPP
+#define CUDA_TEST_CHECK_HPP
+
+#include <iostream>
+
+// Checks shared by the host-only tests
+
+namespace test
+{
+	/// Get the number of failed checks
+	inline int& failures()
+	{
+		static int count = 0;
+		return count;
+	}
+
+	/// Report and count a failed check
+	/**
+		@param condition the checked condition
+		@param what the description of the check
+	*/
+	inline void check(bool condition, const char *what)
+	{
+		if(condition) return;
+		std::cerr << "FAILED: " << what << std::endl;
+		++failures();
+	}
+
+	/// Report the outcome of a test
+	/**
+		@param name the name of the test
+		@return the exit code, 1 if a check failed
+	*/
+	inline int result(const char *name)
+	{
+		if(failures()) return 1;
+		std::cout << name << " tests passed" << std::endl;
+		return 0;
+	}
+}
+
+#endif
@@ -0,0 +1,251 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include <cudamm/exception.hpp>
+#include <cudamm/cubininfo.hpp>
+#include <cudamm/deviceptr.hpp>
+#include <cudamm/function.hpp>
+
+#include "check.hpp"
+
+// Host-only check of the cubin reader, runs without a Cuda driver
+
+namespace
+{
+	using test::check;
+
+	/// Little endian encoding of a value
+	std::string le(boost::uint64_t value, unsigned int bytes)
+	{
+		std::string str;
+		for(unsigned int i = 0; i < bytes; ++i) str += static_cast<char>((value >> (8 * i)) & 0xff);
+		return str;
+	}
+
+	/// Little endian ELF64 image assembled section by section
+	class ElfBuilder
+	{
+		public:
+			ElfBuilder()
+			{
+				section("", 0, "");
+			}
+
+			/// Append a section
+			/**
+				@return the section index
+			*/
+			unsigned int section(const std::string &name, unsigned int type, const std::string &data,
+				unsigned int link = 0, unsigned int info = 0)
+			{
+				section_t s = { static_cast<unsigned int>(names.size()), type, data, link, info };
+				names += name + '\0';
+				sections.push_back(s);
+				return sections.size() - 1;
+			}
+
+			/// Lay out header, section contents and section headers
+			/**
+				@param flags the ELF flags, the low byte is the architecture
+				@return the image
+			*/
+			std::string image(unsigned int flags)
+			{
+				const unsigned int shstrndx = section(".shstrtab", 3, "");
+				sections[shstrndx].data = names;
+
+				std::string contents;
+				std::vector<size_t> offsets;
+				for(size_t i = 0; i < sections.size(); ++i)
+				{
+					offsets.push_back(64 + contents.size());
+					contents += sections[i].data;
+				}
+
+				std::string header("\x7f" "ELF", 4);
+				header += le(2, 1) + le(1, 1) + le(1, 1) + std::string(9, '\0');
+				header += le(2, 2) + le(190, 2) + le(1, 4) + le(0, 8) + le(0, 8);
+				header += le(64 + contents.size(), 8) + le(flags, 4);
+				header += le(64, 2) + le(0, 2) + le(0, 2) + le(64, 2) + le(sections.size(), 2) + le(shstrndx, 2);
+
+				std::string headers;
+				for(size_t i = 0; i < sections.size(); ++i)
+				{
+					const section_t &s = sections[i];
+					headers += le(s.name, 4) + le(s.type, 4) + le(0, 8) + le(0, 8);
+					headers += le(offsets[i], 8) + le(s.data.size(), 8) + le(s.link, 4) + le(s.info, 4);
+					headers += le(0, 8) + le(0, 8);
+				}
+
+				return header + contents + headers;
+			}
+
+		private:
+			struct section_t
+			{
+				unsigned int name, type;
+				std::string data;
+				unsigned int link, info;
+			};
+
+			std::string names;
+			std::vector<section_t> sections;
+	};
+
+	/// ELF64 symbol
+	std::string symbol(unsigned int name, unsigned int type, unsigned int section, unsigned int value, unsigned int size)
+	{
+		return le(name, 4) + le(type, 1) + le(0, 1) + le(section, 2) + le(value, 8) + le(size, 8);
+	}
+
+	/// .nv.info attribute with a value in the header
+	std::string hval(unsigned int attribute, unsigned int value)
+	{
+		return le(0x03, 1) + le(attribute, 1) + le(value, 2);
+	}
+
+	/// .nv.info attribute with data following the header
+	std::string sval(unsigned int attribute, const std::string &data)
+	{
+		return le(0x04, 1) + le(attribute, 1) + le(data.size(), 2) + data;
+	}
+
+	/// Kernel argument of 16 bytes
+	struct vec4
+	{
+		float x, y, z, w;
+	};
+
+	/// Check a parameter layout against a kernel
+	/**
+		@return true if the layouts match
+	*/
+	bool matches(const cuda::CubinKernel &kernel, const std::vector<cuda::CubinParameter> &layout)
+	{
+		try
+		{
+			kernel.checkParameters(layout);
+		} catch(cuda::Exception const &)
+		{
+			return false;
+		}
+		return true;
+	}
+
+	/// Check section, symbol and attribute parsing of ELF cubins
+	void checkElf()
+	{
+		// Symbol names: "scale" at 1, "image" at 7, "table" at 13
+		const std::string strtab("\0scale\0image\0table\0", 20);
+
+		ElfBuilder elf;
+		const unsigned int strings = elf.section(".strtab", 3, strtab);
+		const unsigned int text = elf.section(".text.scale", 1, std::string(32, '\0'), 0, 16u << 24);
+		elf.section(".text.copy", 1, std::string(16, '\0'), 0, 8u << 24);
+		elf.section(".nv.shared.scale", 8, std::string(64, '\0'));
+		elf.section(".nv.constant0.scale", 1, std::string(48, '\0'));
+		const unsigned int bank = elf.section(".nv.constant3", 1, std::string(16, '\0'));
+
+		const std::string symbols = symbol(0, 0, 0, 0, 0)
+			+ symbol(1, 2, text, 0, 32)
+			+ symbol(7, 10, 0, 0, 0)
+			+ symbol(13, 1, bank, 4, 8);
+		elf.section(".symtab", 2, symbols, strings);
+
+		// Registers and frame size of all kernels by symbol index, parameters of scale
+		elf.section(".nv.info", 0x70000000, sval(0x2f, le(1, 4) + le(24, 4)) + sval(0x11, le(1, 4) + le(16, 4)));
+		elf.section(".nv.info.scale", 0x70000000, hval(0x19, 20)
+			+ sval(0x17, le(0, 4) + le(1, 2) + le(16, 2) + le(4u << 18, 4))
+			+ sval(0x17, le(0, 4) + le(0, 2) + le(0, 2) + le(16u << 18, 4)));
+
+		const std::string image = elf.image(0x32);
+		const cuda::CubinInfo info(image.data(), image.size());
+
+		check(info.architecture() == "sm_50", "ELF architecture");
+		check(info.kernels().size() == 2 && info.hasKernel("scale") && info.hasKernel("copy"), "ELF kernels");
+
+		const cuda::CubinKernel &scale = info.kernel("scale");
+		check(scale.registers == 24, "ELF register count attribute overrides section info");
+		check(info.kernel("copy").registers == 8, "ELF register count from section info");
+		check(scale.sharedBytes == 64, "ELF shared memory");
+		check(scale.constBytes == 48, "ELF kernel constants");
+		check(scale.localBytes == 16, "ELF frame size");
+		check(scale.parameterBytes == 20, "ELF parameter size");
+
+		check(scale.parameters.size() == 2, "ELF parameter count");
+		if(scale.parameters.size() == 2)
+		{
+			check(scale.parameters[0].ordinal == 0 && scale.parameters[0].offset == 0 && scale.parameters[0].size == 16,
+				"ELF first parameter");
+			check(scale.parameters[1].ordinal == 1 && scale.parameters[1].offset == 16 && scale.parameters[1].size == 4,
+				"ELF second parameter");
+		}
+
+		// Layouts go() pushes for argument types
+		check(matches(scale, cuda::Function::Parameters<vec4, int>::layout()), "matching go() layout");
+		check(!matches(scale, cuda::Function::Parameters<int, vec4>::layout()), "go() layout with other offsets");
+		check(!matches(scale, cuda::Function::Parameters<vec4>::layout()), "go() layout with other parameter count");
+		check(!matches(scale, cuda::Function::Parameters<vec4, double>::layout()), "go() layout with other size");
+
+		const std::vector<cuda::CubinParameter> pointer = cuda::Function::Parameters<cuda::DevicePtr, float>::layout();
+		check(pointer.size() == 2 && pointer[0].size == sizeof(int) && pointer[1].offset == sizeof(cuda::DevicePtr),
+			"go() layout of device pointers");
+
+		check(info.textures().size() == 1 && info.textures()[0] == "image", "ELF texture");
+		check(info.constants().size() == 1 && info.constants()[0].name == "table" && info.constants()[0].bank == 3
+			&& info.constants()[0].offset == 4 && info.constants()[0].size == 8, "ELF constant symbol");
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const char *filename = argc > 1 ? argv[1] : "test.cubin";
+
+	try
+	{
+		checkElf();
+	} catch(cuda::Exception const &e)
+	{
+		std::cerr << "Cuda exception in ELF cubin: " << e.what() << std::endl;
+		return 1;
+	}
+
+	try
+	{
+		cuda::CubinInfo info(filename);
+
+		std::cout << "Architecture: " << info.architecture() << std::endl;
+		for(size_t i = 0; i < info.kernels().size(); ++i)
+		{
+			const cuda::CubinKernel &kernel = info.kernels()[i];
+			std::cout << "Kernel " << kernel.name
+				<< ": reg " << kernel.registers
+				<< ", smem " << kernel.sharedBytes
+				<< ", lmem " << kernel.localBytes
+				<< ", const " << kernel.constBytes << std::endl;
+		}
+		for(size_t i = 0; i < info.textures().size(); ++i)
+		{
+			std::cout << "Texture " << info.textures()[i] << std::endl;
+		}
+
+		check(info.architecture() == "sm_10", "architecture");
+		check(info.kernels().size() == 2, "kernel count");
+		check(info.hasKernel("box_filter") && info.hasKernel("difference"), "kernel names");
+		check(info.kernel("box_filter").registers == 11, "box_filter registers");
+		check(info.kernel("difference").registers == 8, "difference registers");
+		check(info.kernel("box_filter").sharedBytes == 32, "box_filter shared memory");
+		check(info.kernel("box_filter").constBytes == 20, "box_filter constants");
+		check(info.textures().size() == 2, "texture count");
+		check(!info.hasKernel("missing"), "missing kernel");
+	} catch(cuda::Exception const &e)
+	{
+		std::cerr << "Cuda exception: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return test::result("Cubin reader");
+}
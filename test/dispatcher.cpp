@@ -0,0 +1,233 @@
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <sys/time.h>
+
+#define BOOST_BIND_GLOBAL_PLACEHOLDERS
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <cudamm/completion.hpp>
+#include <cudamm/context.hpp>
+#include <cudamm/deviceptr.hpp>
+#include <cudamm/dispatcher.hpp>
+#include <cudamm/event.hpp>
+#include <cudamm/exception.hpp>
+#include <cudamm/function.hpp>
+#include <cudamm/module.hpp>
+
+#include "check.hpp"
+#include "fakedriver.hpp"
+
+// Host-only check and benchmark of the dispatcher against a fake driver
+
+namespace
+{
+	using test::check;
+
+	double seconds()
+	{
+		timeval t;
+		gettimeofday(&t, 0);
+		return t.tv_sec + t.tv_usec * 1e-6;
+	}
+
+	/// Operation that records the order of a producer's submissions
+	cuda::Completion sequence(std::vector<unsigned int> *seen, unsigned int value)
+	{
+		seen->push_back(value);
+		return cuda::Completion();
+	}
+
+	cuda::Completion fail()
+	{
+		throw cuda::Exception("operation failed");
+	}
+
+	cuda::Completion later(const cuda::CompletionSource &source)
+	{
+		return source.completion();
+	}
+
+	cuda::Completion inContext(bool *current)
+	{
+		*current = fake::current() == fake::context();
+		return cuda::Completion();
+	}
+
+	cuda::Completion nothing()
+	{
+		return cuda::Completion();
+	}
+
+	/// Wait for a handle, reporting failures instead of throwing
+	bool completes(const cuda::Completion &handle)
+	{
+		try
+		{
+			return handle.wait(1000);
+		} catch(cuda::Exception const &e)
+		{
+			std::cerr << e.what() << std::endl;
+			return false;
+		}
+	}
+
+	void produce(cuda::Dispatcher *dispatcher, std::vector<unsigned int> *seen, unsigned int count,
+		std::vector<cuda::Completion> *handles)
+	{
+		for(unsigned int i = 0; i < count; ++i) handles->push_back(dispatcher->submit(boost::bind(sequence, seen, i)));
+	}
+
+	void flood(cuda::Dispatcher *dispatcher, unsigned int count)
+	{
+		for(unsigned int i = 0; i < count; ++i) dispatcher->submit(nothing);
+	}
+}
+
+int main()
+{
+	const unsigned int producers = 4, count = 10000;
+
+	// Every producer's operations run in submission order and complete
+	{
+		cuda::Dispatcher dispatcher((cuda::Context::context_ptr()));
+
+		std::vector<std::vector<unsigned int> > seen(producers);
+		std::vector<std::vector<cuda::Completion> > handles(producers);
+		boost::thread_group threads;
+		for(unsigned int p = 0; p < producers; ++p)
+		{
+			threads.create_thread(boost::bind(produce, &dispatcher, &seen[p], count, &handles[p]));
+		}
+		threads.join_all();
+
+		for(unsigned int p = 0; p < producers; ++p)
+		{
+			for(unsigned int i = 0; i < count; ++i) handles[p][i].wait();
+
+			bool ordered = seen[p].size() == count;
+			for(unsigned int i = 0; ordered && i < count; ++i) ordered = seen[p][i] == i;
+			check(ordered, "operations of a producer run in order");
+		}
+		check(dispatcher.submitted() == producers * count, "submissions counted");
+		check(dispatcher.executed() == producers * count, "executions counted");
+	}
+
+	// Failures reach the producer, handles follow the issued work
+	{
+		cuda::Dispatcher dispatcher((cuda::Context::context_ptr()));
+
+		bool thrown = false;
+		try
+		{
+			dispatcher.submit(fail).wait();
+		} catch(cuda::Exception const &)
+		{
+			thrown = true;
+		}
+		check(thrown, "failed operation fails its handle");
+
+		cuda::CompletionSource source;
+		cuda::Completion handle = dispatcher.submit(boost::bind(later, source));
+		check(!handle.wait(20), "handle waits for the issued work");
+		source.complete();
+		check(handle.wait(1000), "handle completes with the issued work");
+
+	}
+
+	// The dispatcher thread owns the context, producers don't need it
+	{
+		cuda::Context::context_ptr context = cuda::Context::device(0);
+		check(!context->current(), "context not current after creation");
+
+		cuda::Dispatcher dispatcher(context);
+		bool current = false;
+		dispatcher.submit(boost::bind(inContext, &current)).wait();
+		check(current, "context current on the dispatcher thread");
+		check(!context->current(), "context not current on the producer");
+	}
+
+	// Copies, launches and records run on the dispatcher's stream, its thread polls the events
+	{
+		cuda::Context::context_ptr context = cuda::Context::device(0);
+		const unsigned int count = 64, bytes = count * sizeof(unsigned int);
+		std::vector<unsigned int> in(count), out(count, 0);
+		for(unsigned int i = 0; i < count; ++i) in[i] = i * i;
+
+		cuda::DevicePtr memory;
+		boost::scoped_ptr<cuda::Module> module;
+		boost::scoped_ptr<cuda::Function> function;
+		boost::shared_ptr<cuda::Event> event;
+		{
+			cuda::ContextScope scope(*context);
+			memory = cuda::malloc(bytes);
+			module.reset(new cuda::Module("fake.cubin"));
+			function.reset(new cuda::Function(*module, "kernel"));
+			event.reset(new cuda::Event());
+		}
+
+		const unsigned int launches = fake::launches(), notReady = fake::notReady();
+		{
+			cuda::Dispatcher dispatcher(context);
+			const cuda::Completion upload = dispatcher.copy(memory, &in[0], bytes);
+			const cuda::Completion launch = dispatcher.launch(*function, 4, 2);
+			const cuda::Completion download = dispatcher.copy(&out[0], memory, bytes);
+			const cuda::Completion recorded = dispatcher.record(event);
+
+			check(completes(upload), "copy to the device completes");
+			check(completes(launch), "launch completes");
+			check(completes(download), "copy to the host completes");
+			check(completes(recorded), "event record completes");
+		}
+		check(in == out, "copies reach the device and come back");
+		check(fake::launches() == launches + 1, "launch issued once");
+		check(fake::notReady() > notReady, "engine polled until the events were ready");
+		check(!context->current(), "context not current on the producer");
+
+		cuda::ContextScope scope(*context);
+		event.reset();
+		function.reset();
+		module.reset();
+		cuda::free(memory);
+	}
+
+	// A background engine tracks events from a thread without their context
+	{
+		cuda::Context::context_ptr context = cuda::Context::device(0);
+		boost::shared_ptr<cuda::Event> event;
+		{
+			cuda::ContextScope scope(*context);
+			event.reset(new cuda::Event());
+			event->record();
+		}
+
+		{
+			cuda::CompletionEngine engine;
+			check(completes(engine.watch(event)), "background engine completes an event of another context");
+		}
+
+		cuda::ContextScope scope(*context);
+		event.reset();
+	}
+
+	// Throughput of the queue with concurrent producers
+	{
+		cuda::Dispatcher dispatcher((cuda::Context::context_ptr()));
+		const double start = seconds();
+
+		boost::thread_group threads;
+		for(unsigned int p = 0; p < producers; ++p) threads.create_thread(boost::bind(flood, &dispatcher, count * 10));
+		threads.join_all();
+		dispatcher.submit(nothing).wait();
+
+		const double elapsed = seconds() - start;
+		std::cout << producers * count * 10 + 1 << " operations from " << producers << " producers in "
+			<< elapsed * 1e3 << " ms (" << (producers * count * 10 + 1) / elapsed / 1e6 << " M/s)" << std::endl;
+	}
+
+	return test::result("Dispatcher");
+}
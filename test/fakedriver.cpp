@@ -0,0 +1,319 @@
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+
+#include "fakedriver.hpp"
+
+namespace
+{
+	// One device, per-thread context stacks
+	char fakeContext;
+	boost::thread_specific_ptr<std::vector<CUcontext> > contextStack;
+
+	std::vector<CUcontext>& stack()
+	{
+		if(!contextStack.get()) contextStack.reset(new std::vector<CUcontext>);
+		return *contextStack;
+	}
+
+	bool inContext(CUcontext context)
+	{
+		return context && fake::current() == context;
+	}
+
+	struct stream_t
+	{
+		CUcontext context;
+	};
+
+	struct event_t
+	{
+		CUcontext context;
+		unsigned int pending;
+	};
+
+	// Device memory, pointer 0 stays invalid
+	const unsigned int arenaBytes = 1 << 20;
+	std::vector<unsigned char> arena(arenaBytes);
+	unsigned int arenaTop = 256;
+
+	char fakeModule, fakeFunction;
+
+	boost::mutex mutex;
+	unsigned int launchCount = 0, notReadyCount = 0, queryDelay = 2;
+
+	/// Check that a stream may be used, the null stream belongs to the current context
+	bool usable(CUstream stream)
+	{
+		if(!stream) return fake::current() != 0;
+		return inContext(reinterpret_cast<stream_t *>(stream)->context);
+	}
+
+	bool inArena(CUdeviceptr ptr, unsigned int bytes)
+	{
+		return ptr && ptr <= arenaBytes && bytes <= arenaBytes - ptr;
+	}
+}
+
+namespace fake
+{
+	CUcontext context()
+	{
+		return reinterpret_cast<CUcontext>(&fakeContext);
+	}
+
+	CUcontext current()
+	{
+		return stack().empty() ? 0 : stack().back();
+	}
+
+	unsigned char* memory(CUdeviceptr ptr)
+	{
+		return &arena[ptr];
+	}
+
+	unsigned int launches()
+	{
+		boost::mutex::scoped_lock lock(mutex);
+		return launchCount;
+	}
+
+	unsigned int notReady()
+	{
+		boost::mutex::scoped_lock lock(mutex);
+		return notReadyCount;
+	}
+
+	void setQueryDelay(unsigned int queries)
+	{
+		boost::mutex::scoped_lock lock(mutex);
+		queryDelay = queries;
+	}
+}
+
+// Device and context
+CUresult cuInit(unsigned int) { return CUDA_SUCCESS; }
+CUresult cuDriverGetVersion(int *version) { *version = 6000; return CUDA_SUCCESS; }
+CUresult cuDeviceGetCount(int *count) { *count = 1; return CUDA_SUCCESS; }
+CUresult cuDeviceGet(CUdevice *dev, int ordinal) { *dev = ordinal; return CUDA_SUCCESS; }
+CUresult cuDeviceGetName(char *name, int len, CUdevice) { std::strncpy(name, "fake", len); return CUDA_SUCCESS; }
+CUresult cuDeviceComputeCapability(int *major, int *minor, CUdevice) { *major = 1; *minor = 0; return CUDA_SUCCESS; }
+CUresult cuDeviceTotalMem(size_t *bytes, CUdevice) { *bytes = arenaBytes; return CUDA_SUCCESS; }
+CUresult cuDeviceGetAttribute(int *value, CUdevice_attribute, CUdevice) { *value = 1; return CUDA_SUCCESS; }
+CUresult cuCtxCreate(CUcontext *ctx, unsigned int, CUdevice)
+{
+	*ctx = fake::context();
+	stack().push_back(*ctx);
+	return CUDA_SUCCESS;
+}
+CUresult cuCtxDetach(CUcontext) { return CUDA_SUCCESS; }
+CUresult cuCtxDestroy(CUcontext) { return CUDA_SUCCESS; }
+CUresult cuCtxPushCurrent(CUcontext ctx) { stack().push_back(ctx); return CUDA_SUCCESS; }
+CUresult cuCtxPopCurrent(CUcontext *ctx)
+{
+	if(stack().empty()) return CUDA_ERROR_INVALID_CONTEXT;
+	*ctx = stack().back();
+	stack().pop_back();
+	return CUDA_SUCCESS;
+}
+CUresult cuCtxGetCurrent(CUcontext *ctx) { *ctx = fake::current(); return CUDA_SUCCESS; }
+CUresult cuCtxGetDevice(CUdevice *dev) { *dev = 0; return fake::current() ? CUDA_SUCCESS : CUDA_ERROR_INVALID_CONTEXT; }
+CUresult cuCtxSynchronize() { return fake::current() ? CUDA_SUCCESS : CUDA_ERROR_INVALID_CONTEXT; }
+CUresult cuCtxGetStreamPriorityRange(int *least, int *greatest) { *least = *greatest = 0; return CUDA_SUCCESS; }
+
+// Streams run their work at once
+CUresult cuStreamCreate(CUstream *stream, unsigned int)
+{
+	if(!fake::current()) return CUDA_ERROR_INVALID_CONTEXT;
+	stream_t *s = new stream_t;
+	s->context = fake::current();
+	*stream = reinterpret_cast<CUstream>(s);
+	return CUDA_SUCCESS;
+}
+CUresult cuStreamCreateWithPriority(CUstream *stream, unsigned int flags, int) { return cuStreamCreate(stream, flags); }
+CUresult cuStreamDestroy(CUstream stream)
+{
+	if(!usable(stream)) return CUDA_ERROR_INVALID_CONTEXT;
+	delete reinterpret_cast<stream_t *>(stream);
+	return CUDA_SUCCESS;
+}
+CUresult cuStreamGetPriority(CUstream, int *priority) { *priority = 0; return CUDA_SUCCESS; }
+CUresult cuStreamQuery(CUstream stream) { return usable(stream) ? CUDA_SUCCESS : CUDA_ERROR_INVALID_CONTEXT; }
+CUresult cuStreamSynchronize(CUstream stream) { return usable(stream) ? CUDA_SUCCESS : CUDA_ERROR_INVALID_CONTEXT; }
+CUresult cuStreamWaitEvent(CUstream stream, CUevent, unsigned int) { return usable(stream) ? CUDA_SUCCESS : CUDA_ERROR_INVALID_CONTEXT; }
+CUresult cuStreamAddCallback(CUstream stream, CUstreamCallback callback, void *data, unsigned int)
+{
+	if(!usable(stream)) return CUDA_ERROR_INVALID_CONTEXT;
+	callback(stream, CUDA_SUCCESS, data);
+	return CUDA_SUCCESS;
+}
+
+// Events stay not ready for a few queries after each record
+CUresult cuEventCreate(CUevent *event, unsigned int)
+{
+	if(!fake::current()) return CUDA_ERROR_INVALID_CONTEXT;
+	event_t *e = new event_t;
+	e->context = fake::current();
+	e->pending = 0;
+	*event = reinterpret_cast<CUevent>(e);
+	return CUDA_SUCCESS;
+}
+CUresult cuEventDestroy(CUevent event)
+{
+	event_t *e = reinterpret_cast<event_t *>(event);
+	if(!inContext(e->context)) return CUDA_ERROR_INVALID_CONTEXT;
+	delete e;
+	return CUDA_SUCCESS;
+}
+CUresult cuEventRecord(CUevent event, CUstream stream)
+{
+	event_t *e = reinterpret_cast<event_t *>(event);
+	if(!inContext(e->context) || !usable(stream)) return CUDA_ERROR_INVALID_CONTEXT;
+	boost::mutex::scoped_lock lock(mutex);
+	e->pending = queryDelay;
+	return CUDA_SUCCESS;
+}
+CUresult cuEventQuery(CUevent event)
+{
+	event_t *e = reinterpret_cast<event_t *>(event);
+	if(!inContext(e->context)) return CUDA_ERROR_INVALID_CONTEXT;
+	boost::mutex::scoped_lock lock(mutex);
+	if(!e->pending) return CUDA_SUCCESS;
+	--e->pending;
+	++notReadyCount;
+	return CUDA_ERROR_NOT_READY;
+}
+CUresult cuEventSynchronize(CUevent event)
+{
+	event_t *e = reinterpret_cast<event_t *>(event);
+	if(!inContext(e->context)) return CUDA_ERROR_INVALID_CONTEXT;
+	boost::mutex::scoped_lock lock(mutex);
+	e->pending = 0;
+	return CUDA_SUCCESS;
+}
+CUresult cuEventElapsedTime(float *milliseconds, CUevent, CUevent) { *milliseconds = 0.0f; return CUDA_SUCCESS; }
+
+// Memory in the arena, copies complete at once
+CUresult cuMemAlloc(CUdeviceptr *ptr, unsigned int bytes)
+{
+	if(!fake::current()) return CUDA_ERROR_INVALID_CONTEXT;
+	boost::mutex::scoped_lock lock(mutex);
+	if(bytes > arenaBytes - arenaTop) return CUDA_ERROR_OUT_OF_MEMORY;
+	*ptr = arenaTop;
+	arenaTop += (bytes + 255) & ~255u;
+	return CUDA_SUCCESS;
+}
+CUresult cuMemAllocPitch(CUdeviceptr *ptr, unsigned int *pitch, unsigned int width, unsigned int height, unsigned int)
+{
+	*pitch = (width + 255) & ~255u;
+	return cuMemAlloc(ptr, *pitch * height);
+}
+CUresult cuMemFree(CUdeviceptr) { return fake::current() ? CUDA_SUCCESS : CUDA_ERROR_INVALID_CONTEXT; }
+CUresult cuMemAllocHost(void **ptr, unsigned int bytes) { *ptr = std::malloc(bytes); return *ptr ? CUDA_SUCCESS : CUDA_ERROR_OUT_OF_MEMORY; }
+CUresult cuMemHostAlloc(void **ptr, size_t bytes, unsigned int) { *ptr = std::malloc(bytes); return *ptr ? CUDA_SUCCESS : CUDA_ERROR_OUT_OF_MEMORY; }
+CUresult cuMemFreeHost(void *ptr) { std::free(ptr); return CUDA_SUCCESS; }
+CUresult cuMemcpyHtoD(CUdeviceptr dest, const void *src, unsigned int bytes)
+{
+	if(!fake::current()) return CUDA_ERROR_INVALID_CONTEXT;
+	if(!inArena(dest, bytes)) return CUDA_ERROR_INVALID_VALUE;
+	std::memcpy(fake::memory(dest), src, bytes);
+	return CUDA_SUCCESS;
+}
+CUresult cuMemcpyDtoH(void *dest, CUdeviceptr src, unsigned int bytes)
+{
+	if(!fake::current()) return CUDA_ERROR_INVALID_CONTEXT;
+	if(!inArena(src, bytes)) return CUDA_ERROR_INVALID_VALUE;
+	std::memcpy(dest, fake::memory(src), bytes);
+	return CUDA_SUCCESS;
+}
+CUresult cuMemcpyDtoD(CUdeviceptr dest, CUdeviceptr src, unsigned int bytes)
+{
+	if(!fake::current()) return CUDA_ERROR_INVALID_CONTEXT;
+	if(!inArena(dest, bytes) || !inArena(src, bytes)) return CUDA_ERROR_INVALID_VALUE;
+	std::memmove(fake::memory(dest), fake::memory(src), bytes);
+	return CUDA_SUCCESS;
+}
+CUresult cuMemcpyHtoDAsync(CUdeviceptr dest, const void *src, unsigned int bytes, CUstream stream)
+{
+	return usable(stream) ? cuMemcpyHtoD(dest, src, bytes) : CUDA_ERROR_INVALID_CONTEXT;
+}
+CUresult cuMemcpyDtoHAsync(void *dest, CUdeviceptr src, unsigned int bytes, CUstream stream)
+{
+	return usable(stream) ? cuMemcpyDtoH(dest, src, bytes) : CUDA_ERROR_INVALID_CONTEXT;
+}
+CUresult cuMemcpyDtoDAsync(CUdeviceptr dest, CUdeviceptr src, unsigned int bytes, CUstream stream)
+{
+	return usable(stream) ? cuMemcpyDtoD(dest, src, bytes) : CUDA_ERROR_INVALID_CONTEXT;
+}
+CUresult cuMemsetD8(CUdeviceptr dest, unsigned char value, unsigned int count)
+{
+	if(!fake::current()) return CUDA_ERROR_INVALID_CONTEXT;
+	if(!inArena(dest, count)) return CUDA_ERROR_INVALID_VALUE;
+	std::memset(fake::memory(dest), value, count);
+	return CUDA_SUCCESS;
+}
+CUresult cuMemsetD8Async(CUdeviceptr dest, unsigned char value, unsigned int count, CUstream stream)
+{
+	return usable(stream) ? cuMemsetD8(dest, value, count) : CUDA_ERROR_INVALID_CONTEXT;
+}
+
+// Modules with any function, launches are only counted
+CUresult cuModuleLoad(CUmodule *mod, const char *) { *mod = reinterpret_cast<CUmodule>(&fakeModule); return CUDA_SUCCESS; }
+CUresult cuModuleLoadData(CUmodule *mod, const void *) { *mod = reinterpret_cast<CUmodule>(&fakeModule); return CUDA_SUCCESS; }
+CUresult cuModuleLoadDataEx(CUmodule *mod, const void *, unsigned int, CUjit_option *, void **)
+{
+	*mod = reinterpret_cast<CUmodule>(&fakeModule);
+	return CUDA_SUCCESS;
+}
+CUresult cuModuleUnload(CUmodule) { return CUDA_SUCCESS; }
+CUresult cuModuleGetFunction(CUfunction *func, CUmodule, const char *)
+{
+	*func = reinterpret_cast<CUfunction>(&fakeFunction);
+	return CUDA_SUCCESS;
+}
+CUresult cuFuncSetBlockShape(CUfunction, int, int, int) { return CUDA_SUCCESS; }
+CUresult cuFuncSetSharedSize(CUfunction, unsigned int) { return CUDA_SUCCESS; }
+CUresult cuFuncGetAttribute(int *value, CUfunction_attribute, CUfunction) { *value = 0; return CUDA_SUCCESS; }
+CUresult cuParamSetSize(CUfunction, unsigned int) { return CUDA_SUCCESS; }
+CUresult cuParamSeti(CUfunction, int, unsigned int) { return CUDA_SUCCESS; }
+CUresult cuParamSetf(CUfunction, int, float) { return CUDA_SUCCESS; }
+CUresult cuParamSetv(CUfunction, int, void *, unsigned int) { return CUDA_SUCCESS; }
+CUresult cuLaunchGridAsync(CUfunction, int, int, CUstream stream)
+{
+	if(!usable(stream)) return CUDA_ERROR_INVALID_CONTEXT;
+	boost::mutex::scoped_lock lock(mutex);
+	++launchCount;
+	return CUDA_SUCCESS;
+}
+CUresult cuLaunchGrid(CUfunction func, int gridWidth, int gridHeight) { return cuLaunchGridAsync(func, gridWidth, gridHeight, 0); }
+CUresult cuLaunch(CUfunction func) { return cuLaunchGridAsync(func, 1, 1, 0); }
+
+// Not supported by the fake
+CUresult cuModuleGetTexRef(CUtexref *, CUmodule, const char *) { return CUDA_ERROR_UNKNOWN; }
+CUresult cuModuleGetGlobal(CUdeviceptr *, unsigned int *, CUmodule, const char *) { return CUDA_ERROR_UNKNOWN; }
+CUresult cuLinkCreate(unsigned int, CUjit_option *, void **, CUlinkState *) { return CUDA_ERROR_UNKNOWN; }
+CUresult cuLinkAddData(CUlinkState, CUjitInputType, void *, size_t, const char *, unsigned int, CUjit_option *, void **) { return CUDA_ERROR_UNKNOWN; }
+CUresult cuLinkComplete(CUlinkState, void **, size_t *) { return CUDA_ERROR_UNKNOWN; }
+CUresult cuLinkDestroy(CUlinkState) { return CUDA_ERROR_UNKNOWN; }
+CUresult cuParamSetTexRef(CUfunction, int, CUtexref) { return CUDA_ERROR_UNKNOWN; }
+CUresult cuTexRefDestroy(CUtexref) { return CUDA_ERROR_UNKNOWN; }
+CUresult cuTexRefSetAddress(unsigned int *, CUtexref, CUdeviceptr, unsigned int) { return CUDA_ERROR_UNKNOWN; }
+CUresult cuTexRefSetArray(CUtexref, CUarray, unsigned int) { return CUDA_ERROR_UNKNOWN; }
+CUresult cuArrayCreate(CUarray *, const CUDA_ARRAY_DESCRIPTOR *) { return CUDA_ERROR_UNKNOWN; }
+CUresult cuArrayDestroy(CUarray) { return CUDA_ERROR_UNKNOWN; }
+CUresult cuMemcpyAtoA(CUarray, unsigned int, CUarray, unsigned int, unsigned int) { return CUDA_ERROR_UNKNOWN; }
+CUresult cuMemcpyDtoA(CUarray, unsigned int, CUdeviceptr, unsigned int) { return CUDA_ERROR_UNKNOWN; }
+CUresult cuMemcpyAtoD(CUdeviceptr, CUarray, unsigned int, unsigned int) { return CUDA_ERROR_UNKNOWN; }
+CUresult cuMemcpyAtoH(void *, CUarray, unsigned int, unsigned int) { return CUDA_ERROR_UNKNOWN; }
+CUresult cuMemcpyHtoA(CUarray, unsigned int, const void *, unsigned int) { return CUDA_ERROR_UNKNOWN; }
+CUresult cuMemcpyAtoHAsync(void *, CUarray, unsigned int, unsigned int, CUstream) { return CUDA_ERROR_UNKNOWN; }
+CUresult cuMemcpyHtoAAsync(CUarray, unsigned int, const void *, unsigned int, CUstream) { return CUDA_ERROR_UNKNOWN; }
+CUresult cuMemcpy2D(const CUDA_MEMCPY2D *) { return CUDA_ERROR_UNKNOWN; }
+CUresult cuMemcpy2DAsync(const CUDA_MEMCPY2D *, CUstream) { return CUDA_ERROR_UNKNOWN; }
+CUresult cuMemcpy2DUnaligned(const CUDA_MEMCPY2D *) { return CUDA_ERROR_UNKNOWN; }
+CUresult cuMemsetD16(CUdeviceptr, unsigned short, unsigned int) { return CUDA_ERROR_UNKNOWN; }
+CUresult cuMemsetD32(CUdeviceptr, unsigned int, unsigned int) { return CUDA_ERROR_UNKNOWN; }
+CUresult cuMemsetD32Async(CUdeviceptr, unsigned int, unsigned int, CUstream) { return CUDA_ERROR_UNKNOWN; }
@@ -0,0 +1,32 @@
+#ifndef CUDA_TEST_FAKEDRIVER_HPP
+#define CUDA_TEST_FAKEDRIVER_HPP
+
+#include <cuda.h>
+
+// Fake Cuda driver for host-only tests: one device with one context,
+// per-thread context stacks and device memory in a host arena. Calls
+// on streams and events fail with CUDA_ERROR_INVALID_CONTEXT unless
+// their context is current, like the driver documents.
+
+namespace fake
+{
+	/// Get the context of the fake device
+	CUcontext context();
+
+	/// Get the context current on the calling thread
+	CUcontext current();
+
+	/// Get the host memory behind a device pointer
+	unsigned char* memory(CUdeviceptr ptr);
+
+	/// Get the number of kernel launches so far
+	unsigned int launches();
+
+	/// Get the number of event queries that found an event not ready
+	unsigned int notReady();
+
+	/// Let event queries report not ready a number of times after a record
+	void setQueryDelay(unsigned int queries);
+}
+
+#endif
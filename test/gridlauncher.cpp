@@ -0,0 +1,107 @@
+#include <iostream>
+#include <vector>
+
+#include <cudamm/exception.hpp>
+#include <cudamm/gridlauncher.hpp>
+
+#include "check.hpp"
+
+// Host-only check of grid splitting, runs without a Cuda driver
+
+namespace
+{
+	using test::check;
+
+	/// Check that chunks cover a grid exactly once
+	bool covers(const std::vector<cuda::GridChunk> &chunks, unsigned int gridX, unsigned int gridY, unsigned int gridZ)
+	{
+		std::vector<unsigned char> seen(static_cast<size_t>(gridX) * gridY * gridZ, 0);
+		for(std::vector<cuda::GridChunk>::const_iterator chunk = chunks.begin(); chunk != chunks.end(); ++chunk)
+		{
+			if(chunk->offsetX + chunk->gridX > gridX || chunk->offsetY + chunk->gridY > gridY || chunk->offsetZ >= gridZ)
+				return false;
+
+			for(unsigned int y = chunk->offsetY; y < chunk->offsetY + chunk->gridY; ++y)
+				for(unsigned int x = chunk->offsetX; x < chunk->offsetX + chunk->gridX; ++x)
+					++seen[(static_cast<size_t>(chunk->offsetZ) * gridY + y) * gridX + x];
+		}
+
+		for(size_t i = 0; i < seen.size(); ++i) if(seen[i] != 1) return false;
+		return true;
+	}
+}
+
+int main()
+{
+	try
+	{
+		const cuda::DeviceLimits limits = cuda::DeviceLimits::forComputeCapability(2, 0);
+
+		// Empty problems take no launch
+		check(cuda::splitGrid(cuda::Extent(0, 16), cuda::Extent(16, 16), limits).empty(), "empty width");
+		check(cuda::splitGrid(cuda::Extent(16, 16, 0), cuda::Extent(16, 16), limits).empty(), "empty depth");
+
+		bool threw = false;
+		try
+		{
+			cuda::splitGrid(cuda::Extent(16), cuda::Extent(0), limits);
+		} catch(cuda::Exception const &)
+		{
+			threw = true;
+		}
+		check(threw, "empty block shape");
+
+		// Fits in one launch, partial blocks round up
+		std::vector<cuda::GridChunk> chunks = cuda::splitGrid(cuda::Extent(1000, 100), cuda::Extent(32, 8), limits);
+		check(chunks.size() == 1 && chunks[0].gridX == 32 && chunks[0].gridY == 13, "single launch");
+
+		// 70000 blocks wide exceed the 65535 limit, the remainder chunk starts where the first ends
+		chunks = cuda::splitGrid(cuda::Extent(70000 * 64), cuda::Extent(64), limits);
+		check(chunks.size() == 2, "grid limit splits");
+		if(chunks.size() == 2)
+		{
+			check(chunks[0].offsetX == 0 && chunks[0].gridX == 65535, "grid limit first chunk");
+			check(chunks[1].offsetX == 65535 && chunks[1].gridX == 70000 - 65535, "grid limit remainder chunk");
+		}
+		check(covers(chunks, 70000, 1, 1), "grid limit coverage");
+
+		// Same in Y
+		chunks = cuda::splitGrid(cuda::Extent(1, 65536), cuda::Extent(1), limits);
+		check(chunks.size() == 2 && chunks[1].offsetY == 65535 && chunks[1].gridY == 1, "grid limit in Y");
+
+		// Block budget: 10 x 7 grid, 24 blocks per launch make chunks of 10 x 2
+		chunks = cuda::splitGrid(cuda::Extent(10, 7), cuda::Extent(1), limits, 24);
+		check(chunks.size() == 4, "block budget chunk count");
+		for(std::vector<cuda::GridChunk>::const_iterator chunk = chunks.begin(); chunk != chunks.end(); ++chunk)
+			check(chunk->gridX * chunk->gridY <= 24, "block budget per launch");
+		check(!chunks.empty() && chunks.back().offsetY == 6 && chunks.back().gridY == 1, "block budget remainder rows");
+		check(covers(chunks, 10, 7, 1), "block budget coverage");
+
+		// A budget below the grid width splits rows
+		chunks = cuda::splitGrid(cuda::Extent(10, 2), cuda::Extent(1), limits, 4);
+		check(chunks.size() == 6, "narrow budget chunk count");
+		check(chunks.size() > 2 && chunks[2].offsetX == 8 && chunks[2].gridX == 2, "narrow budget remainder chunk");
+		check(covers(chunks, 10, 2, 1), "narrow budget coverage");
+
+		// Problem sizes close to UINT_MAX neither wrap the grid size nor the chunk offsets
+		const cuda::DeviceLimits large = cuda::DeviceLimits::forComputeCapability(3, 0);
+		chunks = cuda::splitGrid(cuda::Extent(0xFFFFFFF0u), cuda::Extent(256), large);
+		check(chunks.size() == 1 && chunks[0].gridX == 0x1000000u, "huge problem grid size");
+
+		chunks = cuda::splitGrid(cuda::Extent(0xFFFFFFFFu), cuda::Extent(1), large);
+		check(chunks.size() == 3, "huge problem chunk count");
+		if(chunks.size() == 3)
+			check(chunks[2].offsetX == 0xFFFFFFFEu && chunks[2].gridX == 1, "huge problem remainder chunk");
+
+		// One launch per layer of blocks in Z
+		chunks = cuda::splitGrid(cuda::Extent(64, 64, 10), cuda::Extent(16, 16, 4), limits);
+		check(chunks.size() == 3 && chunks[2].offsetZ == 2, "layers in Z");
+		check(covers(chunks, 4, 4, 3), "layers coverage");
+	} catch(cuda::Exception const &e)
+	{
+		std::cerr << "Cuda exception: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return test::result("Grid splitting");
+}
@@ -0,0 +1,76 @@
+#include <iostream>
+
+#include <cudamm/exception.hpp>
+#include <cudamm/occupancy.hpp>
+
+#include "check.hpp"
+
+// Host-only check of launch recommendations, runs without a Cuda driver
+
+namespace
+{
+	using test::check;
+
+	/// Check that a launch covers the problem
+	bool covers(const cuda::LaunchConfig &config, unsigned int width, unsigned int height)
+	{
+		return config.gridX * config.blockX >= width && config.gridY * config.blockY >= height
+			&& (config.gridX - 1) * config.blockX < width && (config.gridY - 1) * config.blockY < height;
+	}
+}
+
+int main()
+{
+	try
+	{
+		const cuda::DeviceLimits limits = cuda::DeviceLimits::forComputeCapability(2, 0, 14);
+
+		// A large problem without resource limits fills the multiprocessors without idle threads
+		cuda::LaunchConfig config = cuda::recommendLaunch(limits, cuda::KernelResources(), 1 << 20);
+		check(config.occupancy == 1.0f, "full occupancy");
+		check(config.blocksPerMultiprocessor * config.threads() == limits.maxThreadsPerMultiprocessor, "resident threads");
+		check(config.gridX * config.blockX == 1u << 20 && config.gridY == 1, "no idle threads");
+
+		// 63 registers per thread leave room for 16 warps
+		config = cuda::recommendLaunch(limits, cuda::KernelResources(63), 1 << 20);
+		check(config.warpsPerMultiprocessor == 16, "register limited warps");
+		check(covers(config, 1 << 20, 1), "register limited coverage");
+
+		// A small problem takes one block of the fitting size instead of many partial ones
+		config = cuda::recommendLaunch(limits, cuda::KernelResources(), 100);
+		check(config.threads() == 128 && config.gridX == 1, "small problem block");
+
+		// Narrow two dimensional problems get blocks no wider than a row
+		config = cuda::recommendLaunch(limits, cuda::KernelResources(16), 16, 4096);
+		check(config.blockX == 16 && config.blockY > 1 && config.threads() % limits.warpSize == 0, "two dimensional block");
+		check(covers(config, 16, 4096), "two dimensional coverage");
+
+		config = cuda::recommendLaunch(limits, cuda::KernelResources(16), 1000, 1000);
+		check(covers(config, 1000, 1000), "wide two dimensional coverage");
+
+		// The kernel's largest block size and dynamic shared memory are honoured
+		config = cuda::recommendLaunch(limits, cuda::KernelResources(0, 0, 128), 1 << 20);
+		check(config.threads() <= 128, "kernel block size limit");
+
+		config = cuda::recommendLaunch(limits, cuda::KernelResources(0, 1024), 1 << 20, 1, 16, 512);
+		check(config.sharedBytes == 512 + 16 * config.threads(), "dynamic shared memory");
+		check(config.blocksPerMultiprocessor * (1024 + config.sharedBytes) <= limits.sharedPerMultiprocessor,
+			"shared memory limited blocks");
+
+		bool threw = false;
+		try
+		{
+			cuda::recommendLaunch(limits, cuda::KernelResources(), 1 << 20, 1, 0, limits.sharedPerBlock + 1);
+		} catch(cuda::Exception const &)
+		{
+			threw = true;
+		}
+		check(threw, "no block size fits");
+	} catch(cuda::Exception const &e)
+	{
+		std::cerr << "Cuda exception: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return test::result("Launch recommendation");
+}
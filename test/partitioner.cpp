@@ -0,0 +1,95 @@
+#include <iostream>
+#include <vector>
+
+#include <cudamm/exception.hpp>
+#include <cudamm/partitioner.hpp>
+
+#include "check.hpp"
+
+// Host-only check of domain splitting, runs without a Cuda driver
+
+namespace
+{
+	using test::check;
+
+	std::vector<double> weights(double a, double b, double c = -1.0)
+	{
+		std::vector<double> result;
+		result.push_back(a);
+		result.push_back(b);
+		if(c >= 0.0) result.push_back(c);
+		return result;
+	}
+
+	/// Check that row tiles follow each other and cover the domain
+	bool coversRows(const std::vector<cuda::Tile> &tiles, unsigned int width, unsigned int height)
+	{
+		unsigned int position = 0;
+		for(unsigned int i = 0; i < tiles.size(); ++i)
+		{
+			const cuda::Tile &tile = tiles[i];
+			if(tile.device != i || tile.x != 0 || tile.y != position) return false;
+			if(tile.height && tile.width != width) return false;
+			position += tile.height;
+		}
+		return position == height;
+	}
+
+	bool throws(const std::vector<double> &w)
+	{
+		try
+		{
+			cuda::Partitioner::partition(16, 16, w);
+		} catch(cuda::Exception const &)
+		{
+			return true;
+		}
+		return false;
+	}
+}
+
+int main()
+{
+	try
+	{
+		// Largest remainder: 3.5, 2.1 and 1.4 rows round to 4, 2 and 1
+		std::vector<cuda::Tile> tiles = cuda::Partitioner::partition(5, 7, weights(0.5, 0.3, 0.2));
+		check(tiles.size() == 3, "tile count");
+		check(coversRows(tiles, 5, 7), "row coverage");
+		if(tiles.size() == 3)
+			check(tiles[0].height == 4 && tiles[1].height == 2 && tiles[2].height == 1, "largest remainder");
+
+		// Weights need not be normalized
+		tiles = cuda::Partitioner::partition(5, 10, weights(1, 1, 1));
+		check(coversRows(tiles, 5, 10), "equal weights coverage");
+		for(std::vector<cuda::Tile>::const_iterator tile = tiles.begin(); tile != tiles.end(); ++tile)
+			check(tile->height == 3 || tile->height == 4, "equal weights sizes");
+
+		// Granularity: 7 units of 16 rows split 3 and 4, the last strip clamped to the domain
+		tiles = cuda::Partitioner::partition(8, 100, weights(1, 1), cuda::Partitioner::ROWS, 16);
+		check(coversRows(tiles, 8, 100), "granularity coverage");
+		if(tiles.size() == 2)
+		{
+			check(tiles[0].height == 48, "granularity multiple");
+			check(tiles[1].y == 48 && tiles[1].height == 52, "granularity clamp on the last strip");
+		}
+
+		// Column splits, a device without weight gets an empty tile
+		tiles = cuda::Partitioner::partition(50, 9, weights(1, 0), cuda::Partitioner::COLUMNS);
+		check(tiles.size() == 2, "column tile count");
+		if(tiles.size() == 2)
+		{
+			check(tiles[0].x == 0 && tiles[0].width == 50 && tiles[0].height == 9, "column tile");
+			check(tiles[1].x == 50 && tiles[1].width == 0 && tiles[1].height == 0, "empty tile");
+		}
+
+		check(throws(weights(1, -1)), "negative weight");
+		check(throws(weights(0, 0)), "zero weights");
+	} catch(cuda::Exception const &e)
+	{
+		std::cerr << "Cuda exception: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return test::result("Domain partitioning");
+}
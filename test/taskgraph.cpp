@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include <cudamm/exception.hpp>
+#include <cudamm/taskgraph.hpp>
+
+#include "check.hpp"
+
+// Host-only check of the task scheduler against a simulated driver
+
+namespace
+{
+	using test::check;
+
+	void nothing(const cuda::Stream &)
+	{
+	}
+
+	/// Streams run nodes back to back for their cost, events carry times
+	class SimulatedBackend : public cuda::TaskBackend
+	{
+		public:
+			SimulatedBackend(const cuda::TaskGraph &graph, const cuda::TaskSchedule &schedule)
+				: streamTime(schedule.streams, 0.0f)
+				, eventTime(schedule.events, -1.0f)
+				, start(graph.size(), -1.0f)
+				, finish(graph.size(), -1.0f)
+				, waits(0)
+			{
+			}
+
+			void run(const cuda::TaskGraph &graph, cuda::TaskGraph::Node node, unsigned int stream)
+			{
+				start[node] = streamTime[stream];
+				streamTime[stream] += graph.cost(node);
+				finish[node] = streamTime[stream];
+			}
+
+			void record(unsigned int event, unsigned int stream)
+			{
+				eventTime[event] = streamTime[stream];
+			}
+
+			void wait(unsigned int stream, unsigned int event)
+			{
+				// Waiting for an event not recorded yet would not wait at all
+				check(eventTime[event] >= 0.0f, "wait for recorded event");
+				streamTime[stream] = std::max(streamTime[stream], eventTime[event]);
+				++waits;
+			}
+
+			/// Check that every node started after all its dependencies finished
+			bool dependenciesHold(const cuda::TaskGraph &graph) const
+			{
+				for(cuda::TaskGraph::Node node = 0; node < graph.size(); ++node)
+				{
+					const std::vector<cuda::TaskGraph::Node> &dependencies = graph.dependencies(node);
+					for(size_t i = 0; i < dependencies.size(); ++i)
+					{
+						if(start[node] < finish[dependencies[i]]) return false;
+					}
+				}
+				return true;
+			}
+
+			float makespan() const
+			{
+				return *std::max_element(streamTime.begin(), streamTime.end());
+			}
+
+			std::vector<float> streamTime, eventTime, start, finish;
+			unsigned int waits;
+	};
+
+	bool near(float a, float b)
+	{
+		return std::fabs(a - b) < 1e-4f;
+	}
+
+	void chain()
+	{
+		cuda::TaskGraph graph;
+		const cuda::TaskGraph::Node a = graph.add(nothing, 1.0f);
+		const cuda::TaskGraph::Node b = graph.add(nothing, 2.0f);
+		const cuda::TaskGraph::Node c = graph.add(nothing, 3.0f);
+		graph.depend(b, a);
+		graph.depend(c, b);
+
+		const cuda::TaskSchedule schedule = cuda::scheduleTasks(graph, 4);
+		SimulatedBackend backend(graph, schedule);
+		cuda::executeTasks(graph, schedule, backend);
+
+		check(schedule.streams == 1, "chain stays on one stream");
+		check(schedule.events == 0 && backend.waits == 0, "chain needs no events");
+		check(near(schedule.criticalPath, 6.0f), "chain critical path");
+		check(backend.dependenciesHold(graph), "chain dependencies");
+	}
+
+	void diamond()
+	{
+		cuda::TaskGraph graph;
+		const cuda::TaskGraph::Node a = graph.add(nothing, 1.0f);
+		const cuda::TaskGraph::Node b = graph.add(nothing, 4.0f);
+		const cuda::TaskGraph::Node c = graph.add(nothing, 2.0f);
+		const cuda::TaskGraph::Node d = graph.add(nothing, 1.0f);
+		graph.depend(b, a);
+		graph.depend(c, a);
+		graph.depend(d, b);
+		graph.depend(d, c);
+
+		const cuda::TaskSchedule schedule = cuda::scheduleTasks(graph, 2);
+		SimulatedBackend backend(graph, schedule);
+		cuda::executeTasks(graph, schedule, backend);
+
+		check(schedule.streams == 2, "diamond branches on two streams");
+		check(backend.waits == 2, "diamond waits once per branch crossing");
+		check(near(schedule.criticalPath, 6.0f), "diamond critical path");
+		check(near(schedule.makespan, 6.0f) && near(backend.makespan(), 6.0f), "diamond makespan");
+		check(backend.dependenciesHold(graph), "diamond dependencies");
+	}
+
+	void transitive()
+	{
+		// a and x run in parallel, b joins them, d depends on a and b:
+		// waiting for b already covers a
+		cuda::TaskGraph graph;
+		const cuda::TaskGraph::Node a = graph.add(nothing, 1.0f);
+		const cuda::TaskGraph::Node x = graph.add(nothing, 1.0f);
+		const cuda::TaskGraph::Node b = graph.add(nothing, 1.0f);
+		const cuda::TaskGraph::Node c = graph.add(nothing, 5.0f);
+		const cuda::TaskGraph::Node d = graph.add(nothing, 1.0f);
+		graph.depend(b, a);
+		graph.depend(b, x);
+		graph.depend(c, b);
+		graph.depend(d, a);
+		graph.depend(d, b);
+
+		const cuda::TaskSchedule schedule = cuda::scheduleTasks(graph, 2);
+		SimulatedBackend backend(graph, schedule);
+		cuda::executeTasks(graph, schedule, backend);
+
+		for(size_t i = 0; i < schedule.steps.size(); ++i)
+		{
+			if(schedule.steps[i].node == d) check(schedule.steps[i].waits.size() <= 1, "no redundant wait");
+		}
+		check(backend.waits == 2, "transitive waits");
+		check(backend.dependenciesHold(graph), "transitive dependencies");
+	}
+
+	void independent()
+	{
+		cuda::TaskGraph graph;
+		for(int i = 0; i < 8; ++i) graph.add(nothing, 1.0f);
+
+		const cuda::TaskSchedule schedule = cuda::scheduleTasks(graph, 4);
+		check(schedule.streams == 4, "independent nodes use all streams");
+		check(schedule.events == 0, "independent nodes need no events");
+		check(near(schedule.makespan, 2.0f), "independent makespan");
+	}
+
+	void cycle()
+	{
+		cuda::TaskGraph graph;
+		const cuda::TaskGraph::Node a = graph.add(nothing);
+		const cuda::TaskGraph::Node b = graph.add(nothing);
+		graph.depend(a, b);
+		graph.depend(b, a);
+
+		bool thrown = false;
+		try
+		{
+			cuda::scheduleTasks(graph, 2);
+		} catch(cuda::Exception const &)
+		{
+			thrown = true;
+		}
+		check(thrown, "cycle is rejected");
+	}
+}
+
+int main()
+{
+	try
+	{
+		chain();
+		diamond();
+		transitive();
+		independent();
+		cycle();
+	} catch(cuda::Exception const &e)
+	{
+		std::cerr << "Cuda exception: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return test::result("Task graph");
+}